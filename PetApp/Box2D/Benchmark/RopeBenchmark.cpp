@@ -0,0 +1,113 @@
+/*
+* Copyright (c) 2011 Erin Catto http://box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+// Steps 1000 ropes of 64 segments with b2Rope, with b2RopeSystem on one thread
+// and with b2RopeSystem on a number of threads.
+// Usage: RopeBenchmark [threadCount] [stepCount]
+
+#include <Box2D/Rope/b2Rope.h>
+#include <Box2D/Rope/b2RopeSystem.h>
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+
+const int32 k_ropeCount = 1000;
+const int32 k_vertexCount = 65;
+const float32 k_timeStep = 1.0f / 60.0f;
+const int32 k_iterations = 8;
+
+static float64 b2Milliseconds()
+{
+	std::chrono::steady_clock::duration t = std::chrono::steady_clock::now().time_since_epoch();
+	return std::chrono::duration<float64, std::milli>(t).count();
+}
+
+int main(int argc, char** argv)
+{
+	int32 threadCount = argc > 1 ? atoi(argv[1]) : (int32)std::thread::hardware_concurrency();
+	int32 stepCount = argc > 2 ? atoi(argv[2]) : 300;
+	threadCount = b2Max(threadCount, 1);
+
+	b2Vec2 vertices[k_vertexCount];
+	float32 masses[k_vertexCount];
+	for (int32 i = 0; i < k_vertexCount; ++i)
+	{
+		vertices[i].Set(0.1f * i, 0.0f);
+		masses[i] = 1.0f;
+	}
+	masses[0] = 0.0f;
+
+	b2RopeDef def;
+	def.vertices = vertices;
+	def.count = k_vertexCount;
+	def.masses = masses;
+	def.gravity.Set(0.0f, -10.0f);
+	def.k2 = 1.0f;
+	def.k3 = 0.5f;
+
+	b2Rope* ropes = new b2Rope[k_ropeCount];
+	for (int32 i = 0; i < k_ropeCount; ++i)
+	{
+		ropes[i].Initialize(&def);
+	}
+
+	b2RopeSystem serial;
+	b2RopeSystem parallel;
+	for (int32 i = 0; i < k_ropeCount; ++i)
+	{
+		serial.AddRope(&def);
+		parallel.AddRope(&def);
+	}
+
+	float64 t0 = b2Milliseconds();
+	for (int32 i = 0; i < stepCount; ++i)
+	{
+		for (int32 j = 0; j < k_ropeCount; ++j)
+		{
+			ropes[j].Step(k_timeStep, k_iterations);
+		}
+	}
+
+	float64 t1 = b2Milliseconds();
+	for (int32 i = 0; i < stepCount; ++i)
+	{
+		serial.Step(k_timeStep, k_iterations);
+	}
+
+	float64 t2 = b2Milliseconds();
+	for (int32 i = 0; i < stepCount; ++i)
+	{
+		parallel.Step(k_timeStep, k_iterations, threadCount);
+	}
+
+	float64 t3 = b2Milliseconds();
+
+	b2Vec2 tip1 = ropes[0].GetVertices()[k_vertexCount - 1];
+	b2Vec2 tip2 = serial.GetVertex(0, k_vertexCount - 1);
+	b2Vec2 tip3 = parallel.GetVertex(k_ropeCount - 1, k_vertexCount - 1);
+
+	printf("%d ropes x %d segments, %d steps, %d iterations\n", k_ropeCount, k_vertexCount - 1, stepCount, k_iterations);
+	printf("b2Rope:                  %8.3f ms/step  tip (%.3f, %.3f)\n", (t1 - t0) / stepCount, tip1.x, tip1.y);
+	printf("b2RopeSystem:            %8.3f ms/step  tip (%.3f, %.3f)\n", (t2 - t1) / stepCount, tip2.x, tip2.y);
+	printf("b2RopeSystem %2d threads: %8.3f ms/step  tip (%.3f, %.3f)\n", threadCount, (t3 - t2) / stepCount, tip3.x, tip3.y);
+
+	delete [] ropes;
+	return 0;
+}
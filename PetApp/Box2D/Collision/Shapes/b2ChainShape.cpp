@@ -21,11 +21,43 @@
 #include <new>
 #include <memory.h>
 
+// Chain memory comes from the block allocator if there is one.
+static void* b2ChainAlloc(b2BlockAllocator* allocator, int32 size)
+{
+	if (allocator)
+	{
+		return allocator->Allocate(size);
+	}
+
+	return b2Alloc(size);
+}
+
+static void b2ChainFree(b2BlockAllocator* allocator, void* mem, int32 size)
+{
+	if (allocator)
+	{
+		allocator->Free(mem, size);
+		return;
+	}
+
+	b2Free(mem);
+}
+
 b2ChainShape::~b2ChainShape()
 {
-	b2Free(m_vertices);
+	if (m_vertices)
+	{
+		b2ChainFree(m_allocator, m_vertices, m_count * sizeof(b2Vec2));
+	}
 	m_vertices = NULL;
 	m_count = 0;
+
+	if (m_edgeTree)
+	{
+		m_edgeTree->~b2DynamicTree();
+		b2ChainFree(m_allocator, m_edgeTree, sizeof(b2DynamicTree));
+		m_edgeTree = NULL;
+	}
 }
 
 void b2ChainShape::CreateLoop(const b2Vec2* vertices, int32 count)
@@ -41,7 +73,7 @@ void b2ChainShape::CreateLoop(const b2Vec2* vertices, int32 count)
 	}
 
 	m_count = count + 1;
-	m_vertices = (b2Vec2*)b2Alloc(m_count * sizeof(b2Vec2));
+	m_vertices = (b2Vec2*)b2ChainAlloc(m_allocator, m_count * sizeof(b2Vec2));
 	memcpy(m_vertices, vertices, count * sizeof(b2Vec2));
 	m_vertices[count] = m_vertices[0];
 	m_prevVertex = m_vertices[m_count - 2];
@@ -63,7 +95,7 @@ void b2ChainShape::CreateChain(const b2Vec2* vertices, int32 count)
 	}
 
 	m_count = count;
-	m_vertices = (b2Vec2*)b2Alloc(count * sizeof(b2Vec2));
+	m_vertices = (b2Vec2*)b2ChainAlloc(m_allocator, count * sizeof(b2Vec2));
 	memcpy(m_vertices, vertices, m_count * sizeof(b2Vec2));
 
 	m_hasPrevVertex = false;
@@ -89,14 +121,113 @@ b2Shape* b2ChainShape::Clone(b2BlockAllocator* allocator) const
 {
 	void* mem = allocator->Allocate(sizeof(b2ChainShape));
 	b2ChainShape* clone = new (mem) b2ChainShape;
+	clone->m_allocator = allocator;
 	clone->CreateChain(m_vertices, m_count);
 	clone->m_prevVertex = m_prevVertex;
 	clone->m_nextVertex = m_nextVertex;
 	clone->m_hasPrevVertex = m_hasPrevVertex;
 	clone->m_hasNextVertex = m_hasNextVertex;
+	if (m_edgeTree)
+	{
+		clone->CreateEdgeTree();
+	}
 	return clone;
 }
 
+void b2ChainShape::CreateEdgeTree()
+{
+	b2Assert(m_edgeTree == NULL && m_count >= 2);
+
+	void* mem = b2ChainAlloc(m_allocator, sizeof(b2DynamicTree));
+	m_edgeTree = new (mem) b2DynamicTree(m_allocator);
+
+	b2Transform identity;
+	identity.SetIdentity();
+
+	// Create all leaves first and build the tree once.
+	m_edgeTree->BeginBulkInsert();
+	int32 edgeCount = GetChildCount();
+	for (int32 i = 0; i < edgeCount; ++i)
+	{
+		b2AABB aabb;
+		ComputeAABB(&aabb, identity, i);
+
+		int32 proxyId = m_edgeTree->CreateProxy(aabb, NULL);
+		b2Assert(proxyId == i);
+		B2_NOT_USED(proxyId);
+
+		if (i == 0)
+		{
+			m_edgeBounds = aabb;
+		}
+		else
+		{
+			m_edgeBounds.Combine(aabb);
+		}
+	}
+	m_edgeTree->EndBulkInsert();
+}
+
+void b2ChainShape::GetEdgeAABB(b2AABB* aabb, const b2Transform& xf, int32 childIndex) const
+{
+	b2Assert(m_edgeTree != NULL);
+	b2TransformAABB(aabb, m_edgeTree->GetFatAABB(childIndex), xf.q, xf.p);
+}
+
+void b2ChainShape::ComputeEdgeTreeAABB(b2AABB* aabb, const b2Transform& xf) const
+{
+	b2Assert(m_edgeTree != NULL);
+	b2TransformAABB(aabb, m_edgeBounds, xf.q, xf.p);
+}
+
+// Clips the ray against every edge the tree reports and keeps the closest hit.
+struct b2ChainRayCastCallback
+{
+	float32 RayCastCallback(const b2RayCastInput& input, int32 proxyId)
+	{
+		b2RayCastInput edgeInput = worldInput;
+		edgeInput.maxFraction = input.maxFraction;
+
+		b2RayCastOutput output;
+		if (chain->RayCast(&output, edgeInput, *transform, proxyId))
+		{
+			*result = output;
+			hit = true;
+			return output.fraction;
+		}
+
+		return input.maxFraction;
+	}
+
+	const b2ChainShape* chain;
+	const b2Transform* transform;
+	b2RayCastInput worldInput;
+	b2RayCastOutput* result;
+	bool hit;
+};
+
+bool b2ChainShape::RayCastEdges(b2RayCastOutput* output, const b2RayCastInput& input,
+								const b2Transform& xf) const
+{
+	b2Assert(m_edgeTree != NULL);
+
+	b2ChainRayCastCallback callback;
+	callback.chain = this;
+	callback.transform = &xf;
+	callback.worldInput = input;
+	callback.result = output;
+	callback.hit = false;
+
+	// The tree is in the local frame. The fractions are the same in both frames.
+	b2RayCastInput localInput;
+	localInput.p1 = b2MulT(xf, input.p1);
+	localInput.p2 = b2MulT(xf, input.p2);
+	localInput.maxFraction = input.maxFraction;
+	m_edgeTree->RayCast(&callback, localInput);
+
+	return callback.hit;
+}
+
 int32 b2ChainShape::GetChildCount() const
 {
 	// edge count = vertex count - 1
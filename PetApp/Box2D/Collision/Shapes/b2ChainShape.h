@@ -20,13 +20,15 @@
 #define B2_CHAIN_SHAPE_H
 
 #include <Box2D/Collision/Shapes/b2Shape.h>
+#include <Box2D/Collision/b2DynamicTree.h>
 
 class b2EdgeShape;
 
 /// A chain shape is a free form sequence of line segments.
 /// The chain has two-sided collision, so you can use inside and outside collision.
 /// Therefore, you may use any winding order.
-/// Since there may be many vertices, they are allocated using b2Alloc.
+/// Since there may be many vertices, they are allocated using b2Alloc, or from
+/// the block allocator of the world once the chain is attached to a fixture.
 /// Connectivity information is used to create smooth collisions.
 /// WARNING: The chain will not collide properly if there are self-intersections.
 class b2ChainShape : public b2Shape
@@ -34,7 +36,7 @@ class b2ChainShape : public b2Shape
 public:
 	b2ChainShape();
 
-	/// The destructor frees the vertices using b2Free.
+	/// The destructor frees the vertices and the edge tree.
 	~b2ChainShape();
 
 	/// Create a loop. This automatically adjusts connectivity.
@@ -55,7 +57,32 @@ public:
 	/// Don't call this for loops.
 	void SetNextVertex(const b2Vec2& nextVertex);
 
-	/// Implement b2Shape. Vertices are cloned using b2Alloc.
+	/// Build a bounding volume tree over the edges, turning the chain into a static mesh.
+	/// A fixture with such a chain uses a single broad-phase proxy and finds the
+	/// overlapping edges with this tree, which keeps huge terrains out of the world tree.
+	/// Only use this on static bodies, which b2Body::CreateFixture and b2Body::SetType
+	/// assert. The tree is cloned with the shape.
+	void CreateEdgeTree();
+
+	/// Does this chain have an edge tree?
+	bool HasEdgeTree() const { return m_edgeTree != NULL; }
+
+	/// Query the edges whose fat AABBs overlap a world AABB. The callback receives
+	/// the edge (child) index. Requires an edge tree.
+	template <typename T>
+	void QueryEdges(T* callback, const b2AABB& aabb, const b2Transform& transform) const;
+
+	/// Get the fat AABB of an edge in world coordinates. Requires an edge tree.
+	void GetEdgeAABB(b2AABB* aabb, const b2Transform& transform, int32 childIndex) const;
+
+	/// Compute the AABB of all edges. Requires an edge tree.
+	void ComputeEdgeTreeAABB(b2AABB* aabb, const b2Transform& transform) const;
+
+	/// Ray cast against all edges using the edge tree and return the closest hit.
+	bool RayCastEdges(b2RayCastOutput* output, const b2RayCastInput& input,
+					const b2Transform& transform) const;
+
+	/// Implement b2Shape. The vertices and the edge tree are cloned into the allocator.
 	b2Shape* Clone(b2BlockAllocator* allocator) const;
 
 	/// @see b2Shape::GetChildCount
@@ -87,6 +114,15 @@ public:
 
 	b2Vec2 m_prevVertex, m_nextVertex;
 	bool m_hasPrevVertex, m_hasNextVertex;
+
+	/// Optional edge tree. Proxy ids are edge indices.
+	b2DynamicTree* m_edgeTree;
+
+	/// The allocator of the vertices and the edge tree, or NULL for b2Alloc.
+	b2BlockAllocator* m_allocator;
+
+	/// The local bounds of all edges.
+	b2AABB m_edgeBounds;
 };
 
 inline b2ChainShape::b2ChainShape()
@@ -97,6 +133,23 @@ inline b2ChainShape::b2ChainShape()
 	m_count = 0;
 	m_hasPrevVertex = false;
 	m_hasNextVertex = false;
+	m_edgeTree = NULL;
+	m_allocator = NULL;
+}
+
+template <typename T>
+inline void b2ChainShape::QueryEdges(T* callback, const b2AABB& aabb, const b2Transform& xf) const
+{
+	b2Assert(m_edgeTree != NULL);
+
+	// Move the query box into the local frame of the chain.
+	b2Rot qInv;
+	qInv.s = -xf.q.s;
+	qInv.c = xf.q.c;
+
+	b2AABB localAABB;
+	b2TransformAABB(&localAABB, aabb, qInv, b2MulT(xf.q, -xf.p));
+	m_edgeTree->Query(callback, localAABB);
 }
 
 #endif
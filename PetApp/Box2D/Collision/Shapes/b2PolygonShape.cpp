@@ -17,6 +17,7 @@
 */
 
 #include <Box2D/Collision/Shapes/b2PolygonShape.h>
+#include <Box2D/Common/b2MathBatch.h>
 #include <new>
 
 b2Shape* b2PolygonShape::Clone(b2BlockAllocator* allocator) const
@@ -332,15 +333,8 @@ void b2PolygonShape::ComputeAABB(b2AABB* aabb, const b2Transform& xf, int32 chil
 {
 	B2_NOT_USED(childIndex);
 
-	b2Vec2 lower = b2Mul(xf, m_vertices[0]);
-	b2Vec2 upper = lower;
-
-	for (int32 i = 1; i < m_count; ++i)
-	{
-		b2Vec2 v = b2Mul(xf, m_vertices[i]);
-		lower = b2Min(lower, v);
-		upper = b2Max(upper, v);
-	}
+	b2Vec2 lower, upper;
+	b2TransformBounds(&lower, &upper, xf, m_vertices, m_count);
 
 	b2Vec2 r(m_radius, m_radius);
 	aabb->lowerBound = lower - r;
@@ -29,6 +29,9 @@ b2BroadPhase::b2BroadPhase()
 	m_moveCapacity = 16;
 	m_moveCount = 0;
 	m_moveBuffer = (int32*)b2Alloc(m_moveCapacity * sizeof(int32));
+
+	m_rebalanceIterations = 0;
+	m_filtering = true;
 }
 
 b2BroadPhase::~b2BroadPhase()
@@ -37,6 +40,35 @@ b2BroadPhase::~b2BroadPhase()
 	b2Free(m_pairBuffer);
 }
 
+void b2BroadPhase::Copy(const b2BroadPhase& broadPhase)
+{
+	m_tree.Copy(broadPhase.m_tree);
+	m_proxyCount = broadPhase.m_proxyCount;
+
+	if (m_moveCapacity < broadPhase.m_moveCapacity)
+	{
+		b2Free(m_moveBuffer);
+		m_moveCapacity = broadPhase.m_moveCapacity;
+		m_moveBuffer = (int32*)b2Alloc(m_moveCapacity * sizeof(int32));
+	}
+	m_moveCount = broadPhase.m_moveCount;
+	memcpy(m_moveBuffer, broadPhase.m_moveBuffer, m_moveCount * sizeof(int32));
+
+	// The pair buffer only lives during UpdatePairs.
+	m_pairCount = 0;
+
+	m_rebalanceIterations = broadPhase.m_rebalanceIterations;
+	m_filtering = broadPhase.m_filtering;
+}
+
+void b2BroadPhase::Reset()
+{
+	m_tree.Reset();
+	m_proxyCount = 0;
+	m_moveCount = 0;
+	m_pairCount = 0;
+}
+
 int32 b2BroadPhase::CreateProxy(const b2AABB& aabb, void* userData)
 {
 	int32 proxyId = m_tree.CreateProxy(aabb, userData);
@@ -101,6 +133,12 @@ bool b2BroadPhase::QueryCallback(int32 proxyId)
 		return true;
 	}
 
+	// Reject filtered pairs before they reach the pair buffer.
+	if (m_filtering && m_tree.ShouldCollide(proxyId, m_queryProxyId) == false)
+	{
+		return true;
+	}
+
 	// Grow the pair buffer as needed.
 	if (m_pairCount == m_pairCapacity)
 	{
@@ -52,6 +52,11 @@ public:
 	/// Destroy a proxy. It is up to the client to remove any pairs.
 	void DestroyProxy(int32 proxyId);
 
+	/// Defer tree updates for the proxies created or destroyed until EndBulkInsert,
+	/// which then builds the tree once. Pairs are still reported by the next UpdatePairs.
+	void BeginBulkInsert() { m_tree.BeginBulkInsert(); }
+	void EndBulkInsert() { m_tree.EndBulkInsert(); }
+
 	/// Call MoveProxy as many times as you like, then when you are done
 	/// call UpdatePairs to finalized the proxy pairs (for your time step).
 	void MoveProxy(int32 proxyId, const b2AABB& aabb, const b2Vec2& displacement);
@@ -59,12 +64,34 @@ public:
 	/// Call to trigger a re-processing of it's pairs on the next call to UpdatePairs.
 	void TouchProxy(int32 proxyId);
 
+	/// Set the collision filter of a proxy. Call TouchProxy to find the pairs
+	/// the new filter allows.
+	void SetProxyFilter(int32 proxyId, b2FilterBits categoryBits, b2FilterBits maskBits, int16 groupIndex)
+	{
+		m_tree.SetFilter(proxyId, categoryBits, maskBits, groupIndex);
+	}
+
+	/// Enable/disable rejecting pairs by the proxy filters while querying the tree,
+	/// before the pairs are buffered and sorted. This is enabled by default.
+	void SetFiltering(bool flag) { m_filtering = flag; }
+	bool GetFiltering() const { return m_filtering; }
+
 	/// Get the fat AABB for a proxy.
 	const b2AABB& GetFatAABB(int32 proxyId) const;
 
 	/// Get user data from a proxy. Returns NULL if the id is invalid.
 	void* GetUserData(int32 proxyId) const;
 
+	/// Set the user data of a proxy.
+	void SetUserData(int32 proxyId, void* userData) { m_tree.SetUserData(proxyId, userData); }
+
+	/// Replace this broad-phase with a copy of another, including the buffered
+	/// moves. Proxy user data is copied as is.
+	void Copy(const b2BroadPhase& broadPhase);
+
+	/// Destroy all proxies at once, keeping the tree nodes and buffers.
+	void Reset();
+
 	/// Test overlap of fat AABBs.
 	bool TestOverlap(int32 proxyIdA, int32 proxyIdB) const;
 
@@ -99,6 +126,23 @@ public:
 	/// Get the quality metric of the embedded tree.
 	float32 GetTreeQuality() const;
 
+	/// Enable/disable adaptive fat AABB margins in the embedded tree.
+	void SetAdaptiveMargins(bool flag) { m_tree.SetAdaptiveMargins(flag); }
+	bool GetAdaptiveMargins() const { return m_tree.GetAdaptiveMargins(); }
+
+	/// Get the number of proxy re-insertions performed by the embedded tree.
+	int32 GetReinsertCount() const { return m_tree.GetReinsertCount(); }
+
+	/// Set the number of leaves re-inserted at the end of each UpdatePairs call
+	/// to incrementally restore the tree quality. Zero disables this.
+	void SetRebalanceIterations(int32 iterations) { m_rebalanceIterations = iterations; }
+	int32 GetRebalanceIterations() const { return m_rebalanceIterations; }
+
+	/// Rebuild the embedded tree from scratch. This does not change any fat AABB
+	/// so no pairs are created or destroyed.
+	/// @param bottomUp use the agglomerative builder instead of the binned SAH builder.
+	void RebuildTree(bool bottomUp = false);
+
 	/// Shift the world origin. Useful for large worlds.
 	/// The shift formula is: position -= newOrigin
 	/// @param newOrigin the new origin with respect to the old origin
@@ -126,6 +170,10 @@ private:
 	int32 m_pairCount;
 
 	int32 m_queryProxyId;
+
+	int32 m_rebalanceIterations;
+
+	bool m_filtering;
 };
 
 /// This is used to sort pairs.
@@ -166,6 +214,18 @@ inline int32 b2BroadPhase::GetProxyCount() const
 	return m_proxyCount;
 }
 
+inline void b2BroadPhase::RebuildTree(bool bottomUp)
+{
+	if (bottomUp)
+	{
+		m_tree.RebuildBottomUp();
+	}
+	else
+	{
+		m_tree.RebuildTopDown();
+	}
+}
+
 inline int32 b2BroadPhase::GetTreeHeight() const
 {
 	return m_tree.GetHeight();
@@ -234,7 +294,10 @@ void b2BroadPhase::UpdatePairs(T* callback)
 	}
 
 	// Try to keep the tree balanced.
-	//m_tree.Rebalance(4);
+	if (m_rebalanceIterations > 0)
+	{
+		m_tree.Rebalance(m_rebalanceIterations);
+	}
 }
 
 template <typename T>
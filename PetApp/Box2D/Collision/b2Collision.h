@@ -249,6 +249,9 @@ bool b2TestOverlap(	const b2Shape* shapeA, int32 indexA,
 					const b2Shape* shapeB, int32 indexB,
 					const b2Transform& xfA, const b2Transform& xfB);
 
+/// Compute the AABB that bounds a box after rotating it by q and translating it by p.
+void b2TransformAABB(b2AABB* out, const b2AABB& aabb, const b2Rot& q, const b2Vec2& p);
+
 // ---------------- Inline Functions ------------------------------------------
 
 inline bool b2AABB::IsValid() const
@@ -259,6 +262,16 @@ inline bool b2AABB::IsValid() const
 	return valid;
 }
 
+inline void b2TransformAABB(b2AABB* out, const b2AABB& aabb, const b2Rot& q, const b2Vec2& p)
+{
+	b2Vec2 c = aabb.GetCenter();
+	b2Vec2 e = aabb.GetExtents();
+	b2Vec2 center = b2Mul(q, c) + p;
+	b2Vec2 extents(b2Abs(q.c) * e.x + b2Abs(q.s) * e.y, b2Abs(q.s) * e.x + b2Abs(q.c) * e.y);
+	out->lowerBound = center - extents;
+	out->upperBound = center + extents;
+}
+
 inline bool b2TestOverlap(const b2AABB& a, const b2AABB& b)
 {
 	b2Vec2 d1, d2;
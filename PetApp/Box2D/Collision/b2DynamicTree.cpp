@@ -17,36 +17,128 @@
 */
 
 #include <Box2D/Collision/b2DynamicTree.h>
+#include <Box2D/Common/b2BlockAllocator.h>
 #include <memory.h>
+#include <algorithm>
 
-b2DynamicTree::b2DynamicTree()
+b2DynamicTree::b2DynamicTree(b2BlockAllocator* allocator)
 {
 	m_root = b2_nullNode;
 
+	m_allocator = allocator;
 	m_nodeCapacity = 16;
 	m_nodeCount = 0;
-	m_nodes = (b2TreeNode*)b2Alloc(m_nodeCapacity * sizeof(b2TreeNode));
+	m_nodes = AllocateNodes(m_nodeCapacity);
 	memset(m_nodes, 0, m_nodeCapacity * sizeof(b2TreeNode));
+	BuildFreeList();
 
-	// Build a linked list for the free list.
-	for (int32 i = 0; i < m_nodeCapacity - 1; ++i)
+	m_path = 0;
+
+	m_insertionCount = 0;
+
+	m_adaptiveMargins = false;
+	m_reinsertCount = 0;
+
+	m_bulkInsert = false;
+	m_bulkCount = 0;
+}
+
+b2DynamicTree::~b2DynamicTree()
+{
+	// This frees the entire tree in one shot.
+	FreeNodes(m_nodes, m_nodeCapacity);
+}
+
+b2TreeNode* b2DynamicTree::AllocateNodes(int32 capacity)
+{
+	if (m_allocator)
+	{
+		return (b2TreeNode*)m_allocator->Allocate(capacity * sizeof(b2TreeNode));
+	}
+
+	return (b2TreeNode*)b2Alloc(capacity * sizeof(b2TreeNode));
+}
+
+void b2DynamicTree::FreeNodes(b2TreeNode* nodes, int32 capacity)
+{
+	if (m_allocator)
+	{
+		m_allocator->Free(nodes, capacity * sizeof(b2TreeNode));
+		return;
+	}
+
+	b2Free(nodes);
+}
+
+void b2DynamicTree::BuildFreeList()
+{
+	// Build a linked list for the free list. The parent
+	// pointer becomes the "next" pointer.
+	for (int32 i = m_nodeCount; i < m_nodeCapacity - 1; ++i)
 	{
 		m_nodes[i].next = i + 1;
 		m_nodes[i].height = -1;
 	}
 	m_nodes[m_nodeCapacity-1].next = b2_nullNode;
 	m_nodes[m_nodeCapacity-1].height = -1;
-	m_freeList = 0;
+	m_freeList = m_nodeCount;
+}
 
-	m_path = 0;
+void b2DynamicTree::Copy(const b2DynamicTree& tree)
+{
+	b2Assert(tree.m_bulkInsert == false);
 
+	if (m_nodeCapacity != tree.m_nodeCapacity)
+	{
+		FreeNodes(m_nodes, m_nodeCapacity);
+		m_nodes = AllocateNodes(tree.m_nodeCapacity);
+	}
+
+	// Nodes are relocatable, so one copy suffices.
+	memcpy(m_nodes, tree.m_nodes, tree.m_nodeCapacity * sizeof(b2TreeNode));
+
+	m_root = tree.m_root;
+	m_nodeCount = tree.m_nodeCount;
+	m_nodeCapacity = tree.m_nodeCapacity;
+	m_freeList = tree.m_freeList;
+	m_path = tree.m_path;
+	m_insertionCount = tree.m_insertionCount;
+	m_adaptiveMargins = tree.m_adaptiveMargins;
+	m_reinsertCount = tree.m_reinsertCount;
+	m_bulkInsert = false;
+	m_bulkCount = 0;
+}
+
+void b2DynamicTree::Reset()
+{
+	b2Assert(m_bulkInsert == false);
+
+	m_root = b2_nullNode;
+	m_nodeCount = 0;
+	BuildFreeList();
+
+	m_path = 0;
 	m_insertionCount = 0;
+	m_reinsertCount = 0;
 }
 
-b2DynamicTree::~b2DynamicTree()
+void b2DynamicTree::Relocate(b2BlockAllocator* allocator)
 {
-	// This frees the entire tree in one shot.
-	b2Free(m_nodes);
+	b2Assert(m_allocator != NULL && m_bulkInsert == false);
+
+	const b2TreeNode* sourceNodes = m_nodes;
+	m_allocator = allocator;
+
+	int32 size = m_nodeCapacity * sizeof(b2TreeNode);
+	if (size > b2_maxBlockSize)
+	{
+		m_nodes = (b2TreeNode*)allocator->Allocate(size);
+		memcpy(m_nodes, sourceNodes, size);
+	}
+	else
+	{
+		m_nodes = (b2TreeNode*)allocator->Relocate(sourceNodes);
+	}
 }
 
 // Allocate a node from the pool. Grow the pool if necessary.
@@ -59,21 +151,12 @@ int32 b2DynamicTree::AllocateNode()
 
 		// The free list is empty. Rebuild a bigger pool.
 		b2TreeNode* oldNodes = m_nodes;
+		int32 oldCapacity = m_nodeCapacity;
 		m_nodeCapacity *= 2;
-		m_nodes = (b2TreeNode*)b2Alloc(m_nodeCapacity * sizeof(b2TreeNode));
+		m_nodes = AllocateNodes(m_nodeCapacity);
 		memcpy(m_nodes, oldNodes, m_nodeCount * sizeof(b2TreeNode));
-		b2Free(oldNodes);
-
-		// Build a linked list for the free list. The parent
-		// pointer becomes the "next" pointer.
-		for (int32 i = m_nodeCount; i < m_nodeCapacity - 1; ++i)
-		{
-			m_nodes[i].next = i + 1;
-			m_nodes[i].height = -1;
-		}
-		m_nodes[m_nodeCapacity-1].next = b2_nullNode;
-		m_nodes[m_nodeCapacity-1].height = -1;
-		m_freeList = m_nodeCount;
+		FreeNodes(oldNodes, oldCapacity);
+		BuildFreeList();
 	}
 
 	// Peel a node off the free list.
@@ -84,6 +167,10 @@ int32 b2DynamicTree::AllocateNode()
 	m_nodes[nodeId].child2 = b2_nullNode;
 	m_nodes[nodeId].height = 0;
 	m_nodes[nodeId].userData = NULL;
+	m_nodes[nodeId].displacement = 0.0f;
+	m_nodes[nodeId].categoryBits = 0x0001;
+	m_nodes[nodeId].maskBits = b2FilterBits(~0);
+	m_nodes[nodeId].groupIndex = 0;
 	++m_nodeCount;
 	return nodeId;
 }
@@ -107,42 +194,100 @@ int32 b2DynamicTree::CreateProxy(const b2AABB& aabb, void* userData)
 	int32 proxyId = AllocateNode();
 
 	// Fatten the aabb.
-	b2Vec2 r(b2_aabbExtension, b2_aabbExtension);
+	float32 extension = b2_aabbExtension;
+	if (m_adaptiveMargins)
+	{
+		extension = ComputeMargin(aabb, 0.0f);
+	}
+
+	b2Vec2 r(extension, extension);
 	m_nodes[proxyId].aabb.lowerBound = aabb.lowerBound - r;
 	m_nodes[proxyId].aabb.upperBound = aabb.upperBound + r;
 	m_nodes[proxyId].userData = userData;
 	m_nodes[proxyId].height = 0;
 
+	if (m_bulkInsert)
+	{
+		// The leaf is linked in by EndBulkInsert.
+		++m_bulkCount;
+		return proxyId;
+	}
+
 	InsertLeaf(proxyId);
 
 	return proxyId;
 }
 
+void b2DynamicTree::BeginBulkInsert()
+{
+	b2Assert(m_bulkInsert == false);
+	m_bulkInsert = true;
+	m_bulkCount = 0;
+}
+
+void b2DynamicTree::EndBulkInsert()
+{
+	b2Assert(m_bulkInsert == true);
+	m_bulkInsert = false;
+
+	if (m_bulkCount > 0)
+	{
+		RebuildTopDown();
+		m_bulkCount = 0;
+	}
+}
+
 void b2DynamicTree::DestroyProxy(int32 proxyId)
 {
 	b2Assert(0 <= proxyId && proxyId < m_nodeCapacity);
 	b2Assert(m_nodes[proxyId].IsLeaf());
 
+	if (m_bulkInsert)
+	{
+		// The tree is rebuilt without this leaf by EndBulkInsert.
+		FreeNode(proxyId);
+		++m_bulkCount;
+		return;
+	}
+
 	RemoveLeaf(proxyId);
 	FreeNode(proxyId);
 }
 
+// Compute the adaptive margin for a proxy. Large proxies and fast proxies get
+// a bigger margin, small slow proxies get a tight one.
+float32 b2DynamicTree::ComputeMargin(const b2AABB& aabb, float32 displacement) const
+{
+	b2Vec2 extents = aabb.GetExtents();
+	float32 size = b2Max(extents.x, extents.y);
+	float32 margin = b2_aabbSizeFactor * size + displacement;
+	return b2Clamp(margin, b2_aabbMinExtension, b2_aabbMaxExtension);
+}
+
 bool b2DynamicTree::MoveProxy(int32 proxyId, const b2AABB& aabb, const b2Vec2& displacement)
 {
+	b2Assert(m_bulkInsert == false);
 	b2Assert(0 <= proxyId && proxyId < m_nodeCapacity);
 
 	b2Assert(m_nodes[proxyId].IsLeaf());
 
-	if (m_nodes[proxyId].aabb.Contains(aabb))
+	if (m_adaptiveMargins == false && m_nodes[proxyId].aabb.Contains(aabb))
 	{
 		return false;
 	}
 
-	RemoveLeaf(proxyId);
+	float32 extension = b2_aabbExtension;
+	if (m_adaptiveMargins)
+	{
+		// Track recent motion so a single jump does not blow up the margin.
+		float32 d0 = m_nodes[proxyId].displacement;
+		m_nodes[proxyId].displacement = d0 + b2_aabbDisplacementSmoothing * (displacement.Length() - d0);
+		extension = ComputeMargin(aabb, m_nodes[proxyId].displacement);
+	}
 
 	// Extend AABB.
 	b2AABB b = aabb;
-	b2Vec2 r(b2_aabbExtension, b2_aabbExtension);
+	b2Vec2 r(extension, extension);
 	b.lowerBound = b.lowerBound - r;
 	b.upperBound = b.upperBound + r;
 
@@ -167,9 +312,32 @@ bool b2DynamicTree::MoveProxy(int32 proxyId, const b2AABB& aabb, const b2Vec2& d
 		b.upperBound.y += d.y;
 	}
 
+	if (m_adaptiveMargins)
+	{
+		const b2AABB& treeAABB = m_nodes[proxyId].aabb;
+		if (treeAABB.Contains(aabb))
+		{
+			// The tree AABB still contains the object, but it may be far too large
+			// because the object was moving fast and has since slowed down.
+			b2AABB hugeAABB;
+			hugeAABB.lowerBound = b.lowerBound - 4.0f * r;
+			hugeAABB.upperBound = b.upperBound + 4.0f * r;
+
+			if (hugeAABB.Contains(treeAABB))
+			{
+				return false;
+			}
+
+			// Otherwise shrink the tree AABB.
+		}
+	}
+
+	RemoveLeaf(proxyId);
+
 	m_nodes[proxyId].aabb = b;
 
 	InsertLeaf(proxyId);
+	++m_reinsertCount;
 	return true;
 }
 
@@ -691,9 +859,64 @@ int32 b2DynamicTree::GetMaxBalance() const
 	return maxBalance;
 }
 
+// Interleave the lower 16 bits of x and y.
+static inline uint32 b2MortonCode(uint32 x, uint32 y)
+{
+	x &= 0x0000ffff;
+	x = (x | (x << 8)) & 0x00ff00ff;
+	x = (x | (x << 4)) & 0x0f0f0f0f;
+	x = (x | (x << 2)) & 0x33333333;
+	x = (x | (x << 1)) & 0x55555555;
+
+	y &= 0x0000ffff;
+	y = (y | (y << 8)) & 0x00ff00ff;
+	y = (y | (y << 4)) & 0x0f0f0f0f;
+	y = (y | (y << 2)) & 0x33333333;
+	y = (y | (y << 1)) & 0x55555555;
+
+	return x | (y << 1);
+}
+
+struct b2MortonLeaf
+{
+	uint32 code;
+	int32 index;
+};
+
+inline bool b2MortonLessThan(const b2MortonLeaf& leaf1, const b2MortonLeaf& leaf2)
+{
+	return leaf1.code < leaf2.code;
+}
+
+// Allocate a parent node for two root nodes and link them to it.
+int32 b2DynamicTree::CreateParent(int32 child1, int32 child2)
+{
+	int32 parentIndex = AllocateNode();
+	b2TreeNode* parent = m_nodes + parentIndex;
+	parent->child1 = child1;
+	parent->child2 = child2;
+	parent->height = 1 + b2Max(m_nodes[child1].height, m_nodes[child2].height);
+	parent->aabb.Combine(m_nodes[child1].aabb, m_nodes[child2].aabb);
+	parent->parent = b2_nullNode;
+
+	m_nodes[child1].parent = parentIndex;
+	m_nodes[child2].parent = parentIndex;
+
+	return parentIndex;
+}
+
+// Agglomerative clustering over a spatially sorted leaf order. Leaves are sorted
+// along a Morton curve, then each cluster only searches a small window of its
+// neighbors in that order for the cheapest merge. Mutual best matches are merged
+// and the pass repeats. This is O(n log n) instead of the O(n^3) all-pairs search.
 void b2DynamicTree::RebuildBottomUp()
 {
-	int32* nodes = (int32*)b2Alloc(m_nodeCount * sizeof(int32));
+	if (m_nodeCount == 0)
+	{
+		return;
+	}
+
+	b2MortonLeaf* leaves = (b2MortonLeaf*)b2Alloc(m_nodeCount * sizeof(b2MortonLeaf));
 	int32 count = 0;
 
 	// Build array of leaves. Free the rest.
@@ -708,7 +931,7 @@ void b2DynamicTree::RebuildBottomUp()
 		if (m_nodes[i].IsLeaf())
 		{
 			m_nodes[i].parent = b2_nullNode;
-			nodes[count] = i;
+			leaves[count].index = i;
 			++count;
 		}
 		else
@@ -717,56 +940,366 @@ void b2DynamicTree::RebuildBottomUp()
 		}
 	}
 
+	// Quantize the leaf centers to 16 bits per axis and sort them.
+	b2Vec2 lower = m_nodes[leaves[0].index].aabb.GetCenter();
+	b2Vec2 upper = lower;
+	for (int32 i = 1; i < count; ++i)
+	{
+		b2Vec2 c = m_nodes[leaves[i].index].aabb.GetCenter();
+		lower = b2Min(lower, c);
+		upper = b2Max(upper, c);
+	}
+
+	b2Vec2 extent = upper - lower;
+	float32 scaleX = extent.x > b2_epsilon ? 65535.0f / extent.x : 0.0f;
+	float32 scaleY = extent.y > b2_epsilon ? 65535.0f / extent.y : 0.0f;
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2Vec2 c = m_nodes[leaves[i].index].aabb.GetCenter();
+		uint32 x = uint32(scaleX * (c.x - lower.x));
+		uint32 y = uint32(scaleY * (c.y - lower.y));
+		leaves[i].code = b2MortonCode(x, y);
+	}
+
+	std::sort(leaves, leaves + count, b2MortonLessThan);
+
+	int32* nodes = (int32*)b2Alloc(count * sizeof(int32));
+	int32* nearest = (int32*)b2Alloc(count * sizeof(int32));
+	for (int32 i = 0; i < count; ++i)
+	{
+		nodes[i] = leaves[i].index;
+	}
+	b2Free(leaves);
+
+	const int32 k_searchRadius = 8;
+
 	while (count > 1)
 	{
-		float32 minCost = b2_maxFloat;
-		int32 iMin = -1, jMin = -1;
+		// Find the cheapest merge partner of every cluster within the window. On
+		// ties prefer the partner nearer in curve order, then the lower slot, so
+		// coincident boxes still pair up with their neighbors.
 		for (int32 i = 0; i < count; ++i)
 		{
-			b2AABB aabbi = m_nodes[nodes[i]].aabb;
+			const b2AABB& aabbi = m_nodes[nodes[i]].aabb;
+			int32 j1 = b2Max(i - k_searchRadius, 0);
+			int32 j2 = b2Min(i + k_searchRadius, count - 1);
 
-			for (int32 j = i + 1; j < count; ++j)
+			float32 minCost = b2_maxFloat;
+			int32 jMin = -1;
+			for (int32 j = j1; j <= j2; ++j)
 			{
-				b2AABB aabbj = m_nodes[nodes[j]].aabb;
+				if (j == i)
+				{
+					continue;
+				}
+
 				b2AABB b;
-				b.Combine(aabbi, aabbj);
+				b.Combine(aabbi, m_nodes[nodes[j]].aabb);
 				float32 cost = b.GetPerimeter();
-				if (cost < minCost)
+
+				if (cost < minCost || (cost == minCost && b2Abs(j - i) < b2Abs(jMin - i)))
 				{
-					iMin = i;
 					jMin = j;
 					minCost = cost;
 				}
 			}
+
+			nearest[i] = jMin;
 		}
 
-		int32 index1 = nodes[iMin];
-		int32 index2 = nodes[jMin];
-		b2TreeNode* child1 = m_nodes + index1;
-		b2TreeNode* child2 = m_nodes + index2;
+		// Merge mutual nearest neighbors. The new parent takes the lower slot
+		// so the spatial order is preserved. Merged clusters are marked in nearest.
+		int32 mergeCount = 0;
+		for (int32 i = 0; i < count; ++i)
+		{
+			int32 j = nearest[i];
+			if (j < i || nearest[j] != i)
+			{
+				continue;
+			}
 
-		int32 parentIndex = AllocateNode();
-		b2TreeNode* parent = m_nodes + parentIndex;
-		parent->child1 = index1;
-		parent->child2 = index2;
-		parent->height = 1 + b2Max(child1->height, child2->height);
-		parent->aabb.Combine(child1->aabb, child2->aabb);
-		parent->parent = b2_nullNode;
+			nodes[i] = CreateParent(nodes[i], nodes[j]);
+			nodes[j] = b2_nullNode;
+			nearest[i] = b2_nullNode;
+			nearest[j] = b2_nullNode;
+			++mergeCount;
+		}
 
-		child1->parent = parentIndex;
-		child2->parent = parentIndex;
+		// Chains of nearest neighbors, such as leaves with geometric spacing, have
+		// few mutual pairs. Then also merge each free cluster with its best partner
+		// if that one is still free. Every cluster left over has a merged cluster
+		// in its window, so each pass merges a fixed fraction of the clusters and
+		// there are O(log n) passes.
+		if (4 * mergeCount < count)
+		{
+			for (int32 i = 0; i < count; ++i)
+			{
+				int32 j = nearest[i];
+				if (j == b2_nullNode || nearest[j] == b2_nullNode)
+				{
+					continue;
+				}
 
-		nodes[jMin] = nodes[count-1];
-		nodes[iMin] = parentIndex;
-		--count;
+				int32 lower = b2Min(i, j);
+				int32 upper = b2Max(i, j);
+				nodes[lower] = CreateParent(nodes[lower], nodes[upper]);
+				nodes[upper] = b2_nullNode;
+				nearest[i] = b2_nullNode;
+				nearest[j] = b2_nullNode;
+			}
+		}
+
+		// Compact the cluster array.
+		int32 newCount = 0;
+		for (int32 i = 0; i < count; ++i)
+		{
+			if (nodes[i] != b2_nullNode)
+			{
+				nodes[newCount] = nodes[i];
+				++newCount;
+			}
+		}
+		count = newCount;
 	}
 
 	m_root = nodes[0];
+	b2Free(nearest);
 	b2Free(nodes);
 
 	Validate();
 }
 
+// Leaf record used by the top-down builder. The AABB and center are copied out
+// of the node pool so that partitioning works on contiguous memory.
+struct b2TreeBuildLeaf
+{
+	b2AABB aabb;
+	b2Vec2 center;
+	int32 index;
+};
+
+// Recursively build a sub-tree over the given leaves. The centroids of the leaves
+// are binned along the longest axis and the split with the lowest surface area
+// cost is chosen. Returns the root of the sub-tree.
+int32 b2DynamicTree::BuildTopDown(b2TreeBuildLeaf* leaves, int32 count)
+{
+	b2Assert(count > 0);
+
+	if (count == 1)
+	{
+		return leaves[0].index;
+	}
+
+	// Bound the leaf centroids.
+	b2Vec2 lower = leaves[0].center;
+	b2Vec2 upper = lower;
+	for (int32 i = 1; i < count; ++i)
+	{
+		lower = b2Min(lower, leaves[i].center);
+		upper = b2Max(upper, leaves[i].center);
+	}
+
+	b2Vec2 extent = upper - lower;
+	int32 axis = extent.x > extent.y ? 0 : 1;
+	float32 axisLower = lower(axis);
+	float32 axisExtent = extent(axis);
+
+	int32 splitCount = count / 2;
+
+	if (axisExtent > b2_epsilon)
+	{
+		const int32 k_binCount = 16;
+
+		struct b2TreeBin
+		{
+			b2AABB aabb;
+			int32 count;
+		};
+
+		// An inverted box that any combine replaces.
+		b2AABB empty;
+		empty.lowerBound.Set(b2_maxFloat, b2_maxFloat);
+		empty.upperBound.Set(-b2_maxFloat, -b2_maxFloat);
+
+		b2TreeBin bins[k_binCount];
+		for (int32 i = 0; i < k_binCount; ++i)
+		{
+			bins[i].aabb = empty;
+			bins[i].count = 0;
+		}
+
+		float32 binScale = k_binCount / axisExtent;
+		for (int32 i = 0; i < count; ++i)
+		{
+			int32 binIndex = int32(binScale * (leaves[i].center(axis) - axisLower));
+			binIndex = b2Clamp(binIndex, 0, k_binCount - 1);
+
+			b2TreeBin* bin = bins + binIndex;
+			bin->aabb.Combine(leaves[i].aabb);
+			++bin->count;
+		}
+
+		// Sweep from the right to get the cost of every right partition.
+		float32 rightCosts[k_binCount];
+		b2AABB rightAABB = empty;
+		int32 rightCount = 0;
+		for (int32 i = k_binCount - 1; i > 0; --i)
+		{
+			rightAABB.Combine(bins[i].aabb);
+			rightCount += bins[i].count;
+
+			rightCosts[i] = rightCount > 0 ? rightCount * rightAABB.GetPerimeter() : 0.0f;
+		}
+
+		// Sweep from the left and pick the cheapest split plane.
+		float32 minCost = b2_maxFloat;
+		int32 bestBin = -1;
+		b2AABB leftAABB = empty;
+		int32 leftCount = 0;
+		for (int32 i = 0; i < k_binCount - 1; ++i)
+		{
+			leftAABB.Combine(bins[i].aabb);
+			leftCount += bins[i].count;
+
+			if (leftCount == 0 || leftCount == count)
+			{
+				continue;
+			}
+
+			float32 cost = leftCount * leftAABB.GetPerimeter() + rightCosts[i + 1];
+			if (cost < minCost)
+			{
+				minCost = cost;
+				bestBin = i;
+			}
+		}
+
+		if (bestBin != -1)
+		{
+			// Partition the leaves in place.
+			int32 i1 = 0;
+			int32 i2 = count;
+			while (i1 < i2)
+			{
+				int32 binIndex = int32(binScale * (leaves[i1].center(axis) - axisLower));
+				binIndex = b2Clamp(binIndex, 0, k_binCount - 1);
+
+				if (binIndex <= bestBin)
+				{
+					++i1;
+				}
+				else
+				{
+					--i2;
+					b2Swap(leaves[i1], leaves[i2]);
+				}
+			}
+
+			splitCount = i1;
+		}
+	}
+
+	b2Assert(0 < splitCount && splitCount < count);
+
+	int32 child1 = BuildTopDown(leaves, splitCount);
+	int32 child2 = BuildTopDown(leaves + splitCount, count - splitCount);
+
+	int32 parentIndex = AllocateNode();
+	b2TreeNode* parent = m_nodes + parentIndex;
+	parent->child1 = child1;
+	parent->child2 = child2;
+	parent->height = 1 + b2Max(m_nodes[child1].height, m_nodes[child2].height);
+	parent->aabb.Combine(m_nodes[child1].aabb, m_nodes[child2].aabb);
+	parent->parent = b2_nullNode;
+
+	m_nodes[child1].parent = parentIndex;
+	m_nodes[child2].parent = parentIndex;
+
+	return parentIndex;
+}
+
+void b2DynamicTree::RebuildTopDown()
+{
+	if (m_nodeCount == 0)
+	{
+		m_root = b2_nullNode;
+		return;
+	}
+
+	b2TreeBuildLeaf* leaves = (b2TreeBuildLeaf*)b2Alloc(m_nodeCount * sizeof(b2TreeBuildLeaf));
+	int32 count = 0;
+
+	// Build array of leaves. Free the rest.
+	for (int32 i = 0; i < m_nodeCapacity; ++i)
+	{
+		if (m_nodes[i].height < 0)
+		{
+			// free node in pool
+			continue;
+		}
+
+		if (m_nodes[i].IsLeaf())
+		{
+			m_nodes[i].parent = b2_nullNode;
+			leaves[count].aabb = m_nodes[i].aabb;
+			leaves[count].center = m_nodes[i].aabb.GetCenter();
+			leaves[count].index = i;
+			++count;
+		}
+		else
+		{
+			FreeNode(i);
+		}
+	}
+
+	if (count == 0)
+	{
+		// Every leaf was destroyed during a bulk update.
+		m_root = b2_nullNode;
+		b2Free(leaves);
+		return;
+	}
+
+	m_root = BuildTopDown(leaves, count);
+	m_nodes[m_root].parent = b2_nullNode;
+
+	b2Free(leaves);
+}
+
+void b2DynamicTree::Rebalance(int32 iterations)
+{
+	if (m_root == b2_nullNode)
+	{
+		return;
+	}
+
+	for (int32 i = 0; i < iterations; ++i)
+	{
+		// Walk down to a leaf, using the bits of m_path to pick a child at each level.
+		int32 node = m_root;
+		uint32 bit = 0;
+		while (m_nodes[node].IsLeaf() == false)
+		{
+			if ((m_path >> bit) & 1)
+			{
+				node = m_nodes[node].child2;
+			}
+			else
+			{
+				node = m_nodes[node].child1;
+			}
+
+			bit = (bit + 1) & (8 * sizeof(uint32) - 1);
+		}
+		++m_path;
+
+		// Re-inserting the leaf lets it find a cheaper sibling and
+		// re-balances the ancestors on the way.
+		RemoveLeaf(node);
+		InsertLeaf(node);
+	}
+}
+
 void b2DynamicTree::ShiftOrigin(const b2Vec2& newOrigin)
 {
 	// Build array of leaves. Free the rest.
@@ -24,6 +24,9 @@
 
 #define b2_nullNode (-1)
 
+class b2BlockAllocator;
+struct b2TreeBuildLeaf;
+
 /// A node in the dynamic tree. The client does not interact with this directly.
 struct b2TreeNode
 {
@@ -48,6 +51,14 @@ struct b2TreeNode
 
 	// leaf = 0, free node = -1
 	int32 height;
+
+	// Leaf only: running average of the per-step displacement length.
+	float32 displacement;
+
+	// Leaf only: collision filter, see b2Filter.
+	b2FilterBits categoryBits;
+	b2FilterBits maskBits;
+	int16 groupIndex;
 };
 
 /// A dynamic AABB tree broad-phase, inspired by Nathanael Presson's btDbvt.
@@ -61,8 +72,9 @@ struct b2TreeNode
 class b2DynamicTree
 {
 public:
-	/// Constructing the tree initializes the node pool.
-	b2DynamicTree();
+	/// Constructing the tree initializes the node pool. The pool comes from the
+	/// allocator if one is given, otherwise from b2Alloc.
+	b2DynamicTree(b2BlockAllocator* allocator = NULL);
 
 	/// Destroy the tree, freeing the node pool.
 	~b2DynamicTree();
@@ -70,22 +82,61 @@ public:
 	/// Create a proxy. Provide a tight fitting AABB and a userData pointer.
 	int32 CreateProxy(const b2AABB& aabb, void* userData);
 
+	/// Begin a bulk insertion. Proxies created until EndBulkInsert are not linked
+	/// into the tree and proxies destroyed are freed without unlinking them. No
+	/// proxy may be moved and the tree may not be queried before EndBulkInsert.
+	void BeginBulkInsert();
+
+	/// End a bulk insertion. If any proxy was created or destroyed the whole tree is
+	/// rebuilt once with RebuildTopDown instead of paying for one update per proxy.
+	void EndBulkInsert();
+
 	/// Destroy a proxy. This asserts if the id is invalid.
 	void DestroyProxy(int32 proxyId);
 
 	/// Move a proxy with a swepted AABB. If the proxy has moved outside of its fattened AABB,
 	/// then the proxy is removed from the tree and re-inserted. Otherwise
 	/// the function returns immediately.
+	/// With adaptive margins the proxy is also re-inserted when its fattened AABB
+	/// has become much larger than needed.
 	/// @return true if the proxy was re-inserted.
 	bool MoveProxy(int32 proxyId, const b2AABB& aabb1, const b2Vec2& displacement);
 
+	/// Enable/disable adaptive fat AABB margins. When enabled each proxy is fattened
+	/// according to its size and recent displacement instead of the fixed b2_aabbExtension.
+	void SetAdaptiveMargins(bool flag) { m_adaptiveMargins = flag; }
+	bool GetAdaptiveMargins() const { return m_adaptiveMargins; }
+
+	/// Get the number of times a moved proxy was re-inserted into the tree.
+	/// This counter is never reset by the tree.
+	int32 GetReinsertCount() const { return m_reinsertCount; }
+
 	/// Get proxy user data.
 	/// @return the proxy user data or 0 if the id is invalid.
 	void* GetUserData(int32 proxyId) const;
 
+	/// Set proxy user data.
+	void SetUserData(int32 proxyId, void* userData);
+
+	/// Replace this tree with a copy of another tree. User data is copied as is.
+	void Copy(const b2DynamicTree& tree);
+
+	/// Destroy all proxies at once, keeping the node pool.
+	void Reset();
+
+	/// Fix up a tree whose memory was copied by b2BlockAllocator::BeginCopy. The node
+	/// pool is mapped into the allocator, or copied if it is a large allocation.
+	void Relocate(b2BlockAllocator* allocator);
+
 	/// Get the fat AABB for a proxy.
 	const b2AABB& GetFatAABB(int32 proxyId) const;
 
+	/// Set the collision filter of a proxy. New proxies collide with everything.
+	void SetFilter(int32 proxyId, b2FilterBits categoryBits, b2FilterBits maskBits, int16 groupIndex);
+
+	/// Test the collision filters of two proxies using the b2Filter rules.
+	bool ShouldCollide(int32 proxyIdA, int32 proxyIdB) const;
+
 	/// Query an AABB for overlapping proxies. The callback class
 	/// is called for each proxy that overlaps the supplied AABB.
 	template <typename T>
@@ -115,9 +166,20 @@ public:
 	/// Get the ratio of the sum of the node areas to the root area.
 	float32 GetAreaRatio() const;
 
-	/// Build an optimal tree. Very expensive. For testing.
+	/// Rebuild the tree bottom-up by agglomerative clustering of the leaves.
+	/// This is O(n log n) and usually gives a slightly better tree than RebuildTopDown.
 	void RebuildBottomUp();
 
+	/// Rebuild the tree from scratch using a binned surface area heuristic.
+	/// This is O(n log n) and is meant for level load or after bulk changes.
+	void RebuildTopDown();
+
+	/// Incrementally improve the tree by removing and re-inserting a bounded
+	/// number of leaves. The leaves are visited in a rotating order so that
+	/// repeated calls eventually touch the whole tree.
+	/// @param iterations the number of leaves to re-insert.
+	void Rebalance(int32 iterations);
+
 	/// Shift the world origin. Useful for large worlds.
 	/// The shift formula is: position -= newOrigin
 	/// @param newOrigin the new origin with respect to the old origin
@@ -128,11 +190,24 @@ private:
 	int32 AllocateNode();
 	void FreeNode(int32 node);
 
+	b2TreeNode* AllocateNodes(int32 capacity);
+	void FreeNodes(b2TreeNode* nodes, int32 capacity);
+
+	// Thread the nodes from m_nodeCount on into the free list.
+	void BuildFreeList();
+
+	float32 ComputeMargin(const b2AABB& aabb, float32 displacement) const;
+
 	void InsertLeaf(int32 node);
 	void RemoveLeaf(int32 node);
 
 	int32 Balance(int32 index);
 
+	int32 BuildTopDown(b2TreeBuildLeaf* leaves, int32 count);
+
+	// Allocate a parent node for two root nodes.
+	int32 CreateParent(int32 child1, int32 child2);
+
 	int32 ComputeHeight() const;
 	int32 ComputeHeight(int32 nodeId) const;
 
@@ -141,6 +216,8 @@ private:
 
 	int32 m_root;
 
+	b2BlockAllocator* m_allocator;
+
 	b2TreeNode* m_nodes;
 	int32 m_nodeCount;
 	int32 m_nodeCapacity;
@@ -151,6 +228,12 @@ private:
 	uint32 m_path;
 
 	int32 m_insertionCount;
+
+	bool m_adaptiveMargins;
+	int32 m_reinsertCount;
+
+	bool m_bulkInsert;
+	int32 m_bulkCount;
 };
 
 inline void* b2DynamicTree::GetUserData(int32 proxyId) const
@@ -159,12 +242,40 @@ inline void* b2DynamicTree::GetUserData(int32 proxyId) const
 	return m_nodes[proxyId].userData;
 }
 
+inline void b2DynamicTree::SetUserData(int32 proxyId, void* userData)
+{
+	b2Assert(0 <= proxyId && proxyId < m_nodeCapacity);
+	m_nodes[proxyId].userData = userData;
+}
+
 inline const b2AABB& b2DynamicTree::GetFatAABB(int32 proxyId) const
 {
 	b2Assert(0 <= proxyId && proxyId < m_nodeCapacity);
 	return m_nodes[proxyId].aabb;
 }
 
+inline void b2DynamicTree::SetFilter(int32 proxyId, b2FilterBits categoryBits, b2FilterBits maskBits, int16 groupIndex)
+{
+	b2Assert(0 <= proxyId && proxyId < m_nodeCapacity);
+	b2TreeNode* node = m_nodes + proxyId;
+	node->categoryBits = categoryBits;
+	node->maskBits = maskBits;
+	node->groupIndex = groupIndex;
+}
+
+inline bool b2DynamicTree::ShouldCollide(int32 proxyIdA, int32 proxyIdB) const
+{
+	const b2TreeNode* nodeA = m_nodes + proxyIdA;
+	const b2TreeNode* nodeB = m_nodes + proxyIdB;
+
+	if (nodeA->groupIndex == nodeB->groupIndex && nodeA->groupIndex != 0)
+	{
+		return nodeA->groupIndex > 0;
+	}
+
+	return (nodeA->maskBits & nodeB->categoryBits) != 0 && (nodeA->categoryBits & nodeB->maskBits) != 0;
+}
+
 template <typename T>
 inline void b2DynamicTree::Query(T* callback, const b2AABB& aabb) const
 {
@@ -25,9 +25,10 @@
 
 #include <stdio.h>
 
-float32 b2_toiTime, b2_toiMaxTime;
-int32 b2_toiCalls, b2_toiIters, b2_toiMaxIters;
-int32 b2_toiRootIters, b2_toiMaxRootIters;
+// Statistics are kept per thread because worlds may be stepped on several threads.
+thread_local float32 b2_toiTime, b2_toiMaxTime;
+thread_local int32 b2_toiCalls, b2_toiIters, b2_toiMaxIters;
+thread_local int32 b2_toiRootIters, b2_toiMaxRootIters;
 
 //
 struct b2SeparationFunction
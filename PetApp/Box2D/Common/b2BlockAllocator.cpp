@@ -20,6 +20,7 @@
 #include <limits.h>
 #include <memory.h>
 #include <stddef.h>
+#include <mutex>
 
 int32 b2BlockAllocator::s_blockSizes[b2_blockSizes] = 
 {
@@ -41,6 +42,9 @@ int32 b2BlockAllocator::s_blockSizes[b2_blockSizes] =
 uint8 b2BlockAllocator::s_blockSizeLookup[b2_maxBlockSize + 1];
 bool b2BlockAllocator::s_blockSizeLookupInitialized;
 
+// Allocators may be constructed on several threads at once.
+static std::once_flag b2_blockSizeLookupOnce;
+
 struct b2Chunk
 {
 	int32 blockSize;
@@ -52,41 +56,76 @@ struct b2Block
 	b2Block* next;
 };
 
+// Large allocations are linked so the allocator can release them.
+struct b2LargeBlock
+{
+	b2LargeBlock* prev;
+	b2LargeBlock* next;
+};
+
+// The header size keeps large allocations 16 byte aligned.
+static const int32 b2_largeHeaderSize = 16;
+
+struct b2ChunkMap
+{
+	const int8* source;
+	int8* target;
+};
+
+// A chunk overlaps at most two chunk sized address windows. The copy map is a hash
+// table of the chunks keyed by window, so Relocate is a short probe.
+static inline uint32 b2ChunkHash(const void* p, uint32 mask)
+{
+	size_t window = (size_t)p / b2_chunkSize;
+	return ((uint32)window * 2654435761u) & mask;
+}
+
 b2BlockAllocator::b2BlockAllocator()
 {
 	b2Assert(b2_blockSizes < UCHAR_MAX);
 
 	m_chunkSpace = b2_chunkArrayIncrement;
 	m_chunkCount = 0;
+	m_chunkReserve = 0;
 	m_chunks = (b2Chunk*)b2Alloc(m_chunkSpace * sizeof(b2Chunk));
 	
 	memset(m_chunks, 0, m_chunkSpace * sizeof(b2Chunk));
 	memset(m_freeLists, 0, sizeof(m_freeLists));
 
-	if (s_blockSizeLookupInitialized == false)
+	m_largeList = NULL;
+
+	m_copyMap = NULL;
+	m_copyCount = 0;
+
+	std::call_once(b2_blockSizeLookupOnce, InitializeBlockSizeLookup);
+}
+
+void b2BlockAllocator::InitializeBlockSizeLookup()
+{
+	int32 j = 0;
+	for (int32 i = 1; i <= b2_maxBlockSize; ++i)
 	{
-		int32 j = 0;
-		for (int32 i = 1; i <= b2_maxBlockSize; ++i)
+		b2Assert(j < b2_blockSizes);
+		if (i <= s_blockSizes[j])
 		{
-			b2Assert(j < b2_blockSizes);
-			if (i <= s_blockSizes[j])
-			{
-				s_blockSizeLookup[i] = (uint8)j;
-			}
-			else
-			{
-				++j;
-				s_blockSizeLookup[i] = (uint8)j;
-			}
+			s_blockSizeLookup[i] = (uint8)j;
+		}
+		else
+		{
+			++j;
+			s_blockSizeLookup[i] = (uint8)j;
 		}
-
-		s_blockSizeLookupInitialized = true;
 	}
+
+	s_blockSizeLookupInitialized = true;
 }
 
 b2BlockAllocator::~b2BlockAllocator()
 {
-	for (int32 i = 0; i < m_chunkCount; ++i)
+	EndCopy();
+	FreeLargeBlocks();
+
+	for (int32 i = 0; i < m_chunkReserve; ++i)
 	{
 		b2Free(m_chunks[i].blocks);
 	}
@@ -103,7 +142,15 @@ void* b2BlockAllocator::Allocate(int32 size)
 
 	if (size > b2_maxBlockSize)
 	{
-		return b2Alloc(size);
+		b2LargeBlock* block = (b2LargeBlock*)b2Alloc(b2_largeHeaderSize + size);
+		block->prev = NULL;
+		block->next = m_largeList;
+		if (m_largeList)
+		{
+			m_largeList->prev = block;
+		}
+		m_largeList = block;
+		return (int8*)block + b2_largeHeaderSize;
 	}
 
 	int32 index = s_blockSizeLookup[size];
@@ -127,8 +174,13 @@ void* b2BlockAllocator::Allocate(int32 size)
 			b2Free(oldChunks);
 		}
 
+		// Reuse the memory of a chunk that was released by Reset.
 		b2Chunk* chunk = m_chunks + m_chunkCount;
-		chunk->blocks = (b2Block*)b2Alloc(b2_chunkSize);
+		if (m_chunkCount == m_chunkReserve)
+		{
+			chunk->blocks = (b2Block*)b2Alloc(b2_chunkSize);
+			++m_chunkReserve;
+		}
 #if defined(_DEBUG)
 		memset(chunk->blocks, 0xcd, b2_chunkSize);
 #endif
@@ -163,7 +215,22 @@ void b2BlockAllocator::Free(void* p, int32 size)
 
 	if (size > b2_maxBlockSize)
 	{
-		b2Free(p);
+		b2LargeBlock* block = (b2LargeBlock*)((int8*)p - b2_largeHeaderSize);
+		if (block->prev)
+		{
+			block->prev->next = block->next;
+		}
+		else
+		{
+			m_largeList = block->next;
+		}
+
+		if (block->next)
+		{
+			block->next->prev = block->prev;
+		}
+
+		b2Free(block);
 		return;
 	}
 
@@ -203,13 +270,136 @@ void b2BlockAllocator::Free(void* p, int32 size)
 
 void b2BlockAllocator::Clear()
 {
-	for (int32 i = 0; i < m_chunkCount; ++i)
+	FreeLargeBlocks();
+
+	for (int32 i = 0; i < m_chunkReserve; ++i)
 	{
 		b2Free(m_chunks[i].blocks);
 	}
 
 	m_chunkCount = 0;
+	m_chunkReserve = 0;
 	memset(m_chunks, 0, m_chunkSpace * sizeof(b2Chunk));
 
 	memset(m_freeLists, 0, sizeof(m_freeLists));
 }
+
+void b2BlockAllocator::Reset()
+{
+	b2Assert(m_copyMap == NULL);
+
+	FreeLargeBlocks();
+
+	// The chunks are threaded again when Allocate reuses them.
+	m_chunkCount = 0;
+	memset(m_freeLists, 0, sizeof(m_freeLists));
+}
+
+void b2BlockAllocator::FreeLargeBlocks()
+{
+	b2LargeBlock* block = m_largeList;
+	while (block)
+	{
+		b2LargeBlock* next = block->next;
+		b2Free(block);
+		block = next;
+	}
+
+	m_largeList = NULL;
+}
+
+void b2BlockAllocator::BeginCopy(const b2BlockAllocator& source)
+{
+	b2Assert(m_copyMap == NULL);
+
+	Clear();
+
+	if (m_chunkSpace < source.m_chunkSpace)
+	{
+		b2Free(m_chunks);
+		m_chunkSpace = source.m_chunkSpace;
+		m_chunks = (b2Chunk*)b2Alloc(m_chunkSpace * sizeof(b2Chunk));
+		memset(m_chunks, 0, m_chunkSpace * sizeof(b2Chunk));
+	}
+
+	m_chunkCount = source.m_chunkCount;
+	m_chunkReserve = m_chunkCount;
+
+	m_copyCount = 16;
+	while (m_copyCount < 4 * m_chunkCount)
+	{
+		m_copyCount *= 2;
+	}
+	m_copyMap = (b2ChunkMap*)b2Alloc(m_copyCount * sizeof(b2ChunkMap));
+	memset(m_copyMap, 0, m_copyCount * sizeof(b2ChunkMap));
+	uint32 mask = m_copyCount - 1;
+
+	for (int32 i = 0; i < m_chunkCount; ++i)
+	{
+		const b2Chunk* sourceChunk = source.m_chunks + i;
+		b2Chunk* chunk = m_chunks + i;
+		chunk->blockSize = sourceChunk->blockSize;
+		chunk->blocks = (b2Block*)b2Alloc(b2_chunkSize);
+		memcpy(chunk->blocks, sourceChunk->blocks, b2_chunkSize);
+
+		const int8* first = (const int8*)sourceChunk->blocks;
+		const int8* last = first + b2_chunkSize - 1;
+		for (int32 k = 0; k < 2; ++k)
+		{
+			const int8* p = k == 0 ? first : last;
+			if (k == 1 && (size_t)first / b2_chunkSize == (size_t)last / b2_chunkSize)
+			{
+				break;
+			}
+
+			uint32 slot = b2ChunkHash(p, mask);
+			while (m_copyMap[slot].source != NULL)
+			{
+				slot = (slot + 1) & mask;
+			}
+
+			m_copyMap[slot].source = first;
+			m_copyMap[slot].target = (int8*)chunk->blocks;
+		}
+	}
+
+	// The free lists are threaded through the copied blocks.
+	for (int32 i = 0; i < b2_blockSizes; ++i)
+	{
+		m_freeLists[i] = (b2Block*)Relocate(source.m_freeLists[i]);
+		for (b2Block* block = m_freeLists[i]; block; block = block->next)
+		{
+			block->next = (b2Block*)Relocate(block->next);
+		}
+	}
+}
+
+void* b2BlockAllocator::Relocate(const void* p) const
+{
+	if (p == NULL)
+	{
+		return NULL;
+	}
+
+	const int8* q = (const int8*)p;
+	uint32 mask = m_copyCount - 1;
+	for (uint32 slot = b2ChunkHash(q, mask); m_copyMap[slot].source != NULL; slot = (slot + 1) & mask)
+	{
+		const b2ChunkMap* map = m_copyMap + slot;
+		if (map->source <= q && q < map->source + b2_chunkSize)
+		{
+			return map->target + (q - map->source);
+		}
+	}
+
+	// The pointer is not in a block of the copy source.
+	b2Assert(false);
+	return NULL;
+}
+
+void b2BlockAllocator::EndCopy()
+{
+	b2Free(m_copyMap);
+	m_copyMap = NULL;
+	m_copyCount = 0;
+}
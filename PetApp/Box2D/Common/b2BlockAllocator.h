@@ -28,6 +28,8 @@ const int32 b2_chunkArrayIncrement = 128;
 
 struct b2Block;
 struct b2Chunk;
+struct b2ChunkMap;
+struct b2LargeBlock;
 
 /// This is a small object allocator used for allocating small
 /// objects that persist for more than one time step.
@@ -39,21 +41,55 @@ public:
 	~b2BlockAllocator();
 
 	/// Allocate memory. This will use b2Alloc if the size is larger than b2_maxBlockSize.
+	/// Such large allocations are still owned by the allocator and released by Clear and
+	/// Reset.
 	void* Allocate(int32 size);
 
 	/// Free memory. This will use b2Free if the size is larger than b2_maxBlockSize.
 	void Free(void* p, int32 size);
 
+	/// Free all memory.
 	void Clear();
 
+	/// Free all allocations at once, keeping the chunks for reuse. This does not
+	/// visit the blocks, so it takes the same time however many objects were allocated.
+	/// Large allocations are returned to b2Free.
+	void Reset();
+
+	/// Make this allocator a copy of another allocator with one memcpy per chunk.
+	/// Pointers into the blocks of the source can be mapped with Relocate until
+	/// EndCopy is called. Large allocations (see Allocate) are not copied.
+	void BeginCopy(const b2BlockAllocator& source);
+
+	/// Map a pointer into a block of the copy source to the same place in this
+	/// allocator.
+	void* Relocate(const void* p) const;
+
+	/// Free the relocation table of BeginCopy.
+	void EndCopy();
+
 private:
 
+	static void InitializeBlockSizeLookup();
+
+	void FreeLargeBlocks();
+
 	b2Chunk* m_chunks;
 	int32 m_chunkCount;
 	int32 m_chunkSpace;
 
+	// The number of chunks with memory. The chunks from m_chunkCount on are
+	// unused since a Reset.
+	int32 m_chunkReserve;
+
+	b2LargeBlock* m_largeList;
+
 	b2Block* m_freeLists[b2_blockSizes];
 
+	// Source to target chunk addresses while copying, hashed by source.
+	b2ChunkMap* m_copyMap;
+	int32 m_copyCount;
+
 	static int32 s_blockSizes[b2_blockSizes];
 	static uint8 s_blockSizeLookup[b2_maxBlockSize + 1];
 	static bool s_blockSizeLookupInitialized;
@@ -179,6 +179,37 @@ struct b2Vec3
 	float32 x, y, z;
 };
 
+/// A double precision 2D column vector. This is used for positions in large worlds
+/// where float32 coordinates relative to a fixed origin lose precision.
+struct b2Vec2d
+{
+	/// Default constructor does nothing (for performance).
+	b2Vec2d() {}
+
+	/// Construct using coordinates.
+	b2Vec2d(float64 x, float64 y) : x(x), y(y) {}
+
+	/// Set this vector to all zeros.
+	void SetZero() { x = 0.0; y = 0.0; }
+
+	/// Set this vector to some specified coordinates.
+	void Set(float64 x_, float64 y_) { x = x_; y = y_; }
+
+	/// Add a single precision offset to this vector.
+	void operator += (const b2Vec2& v)
+	{
+		x += v.x; y += v.y;
+	}
+
+	/// Subtract a single precision offset from this vector.
+	void operator -= (const b2Vec2& v)
+	{
+		x -= v.x; y -= v.y;
+	}
+
+	float64 x, y;
+};
+
 /// A 2-by-2 matrix. Stored in column-major order.
 struct b2Mat22
 {
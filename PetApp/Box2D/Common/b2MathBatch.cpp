@@ -0,0 +1,111 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Common/b2MathBatch.h>
+
+// Points are processed in pairs with one b2Vec2 in each half of a b2FloatW:
+// (x0, y0, x1, y1). A rotation is then
+//   (c, c, c, c) * (x0, y0, x1, y1) + (-s, s, -s, s) * (y0, x0, y1, x1)
+// which is the same arithmetic as b2Mul.
+struct b2PairTransform
+{
+	explicit b2PairTransform(const b2Transform& xf)
+	{
+		c = b2SplatW(xf.q.c);
+		s = b2SetW(-xf.q.s, xf.q.s, -xf.q.s, xf.q.s);
+		p = b2SetW(xf.p.x, xf.p.y, xf.p.x, xf.p.y);
+	}
+
+	b2FloatW Apply(b2FloatW v) const
+	{
+		return b2AddW(b2AddW(b2MulW(c, v), b2MulW(s, b2SwapPairsW(v))), p);
+	}
+
+	b2FloatW c, s, p;
+};
+
+// Load two points, or the last point twice.
+static inline b2FloatW b2LoadPair(const b2Vec2* points, int32 index, int32 count)
+{
+	if (index + 1 < count)
+	{
+		return b2LoadW(&points[index].x);
+	}
+
+	return b2SetW(points[index].x, points[index].y, points[index].x, points[index].y);
+}
+
+// Reduce packed bounds to a single pair.
+static inline void b2StoreBounds(b2Vec2* lower, b2Vec2* upper, b2FloatW lo, b2FloatW hi)
+{
+	float32 l[4], u[4];
+	b2StoreW(l, b2MinW(lo, b2HighPairW(lo)));
+	b2StoreW(u, b2MaxW(hi, b2HighPairW(hi)));
+	lower->Set(l[0], l[1]);
+	upper->Set(u[0], u[1]);
+}
+
+void b2TransformPoints(b2Vec2* out, const b2Transform& xf, const b2Vec2* points, int32 count)
+{
+	b2PairTransform transform(xf);
+
+	int32 i = 0;
+	for (; i + 1 < count; i += 2)
+	{
+		b2StoreW(&out[i].x, transform.Apply(b2LoadW(&points[i].x)));
+	}
+
+	if (i < count)
+	{
+		out[i] = b2Mul(xf, points[i]);
+	}
+}
+
+void b2ComputeBounds(b2Vec2* lower, b2Vec2* upper, const b2Vec2* points, int32 count)
+{
+	b2Assert(count > 0);
+
+	b2FloatW lo = b2LoadPair(points, 0, count);
+	b2FloatW hi = lo;
+	for (int32 i = 2; i < count; i += 2)
+	{
+		b2FloatW v = b2LoadPair(points, i, count);
+		lo = b2MinW(lo, v);
+		hi = b2MaxW(hi, v);
+	}
+
+	b2StoreBounds(lower, upper, lo, hi);
+}
+
+void b2TransformBounds(b2Vec2* lower, b2Vec2* upper, const b2Transform& xf, const b2Vec2* points, int32 count)
+{
+	b2Assert(count > 0);
+
+	b2PairTransform transform(xf);
+
+	b2FloatW lo = transform.Apply(b2LoadPair(points, 0, count));
+	b2FloatW hi = lo;
+	for (int32 i = 2; i < count; i += 2)
+	{
+		b2FloatW v = transform.Apply(b2LoadPair(points, i, count));
+		lo = b2MinW(lo, v);
+		hi = b2MaxW(hi, v);
+	}
+
+	b2StoreBounds(lower, upper, lo, hi);
+}
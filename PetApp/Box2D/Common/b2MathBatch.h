@@ -0,0 +1,235 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_MATH_BATCH_H
+#define B2_MATH_BATCH_H
+
+#include <Box2D/Common/b2Math.h>
+
+/// Define B2_NO_SIMD to use the scalar fallback on every platform.
+#if !defined(B2_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define B2_SIMD_SSE2 1
+#include <emmintrin.h>
+#else
+#define B2_SIMD_SSE2 0
+#endif
+
+/// The number of lanes in a b2FloatW.
+#define b2_simdWidth	4
+
+#if B2_SIMD_SSE2
+
+/// Four floats that are processed together.
+typedef __m128 b2FloatW;
+
+inline b2FloatW b2LoadW(const float32* p) { return _mm_loadu_ps(p); }
+inline void b2StoreW(float32* p, b2FloatW a) { _mm_storeu_ps(p, a); }
+inline b2FloatW b2SplatW(float32 s) { return _mm_set1_ps(s); }
+inline b2FloatW b2SetW(float32 a, float32 b, float32 c, float32 d) { return _mm_setr_ps(a, b, c, d); }
+inline b2FloatW b2AddW(b2FloatW a, b2FloatW b) { return _mm_add_ps(a, b); }
+inline b2FloatW b2SubW(b2FloatW a, b2FloatW b) { return _mm_sub_ps(a, b); }
+inline b2FloatW b2MulW(b2FloatW a, b2FloatW b) { return _mm_mul_ps(a, b); }
+inline b2FloatW b2DivW(b2FloatW a, b2FloatW b) { return _mm_div_ps(a, b); }
+inline b2FloatW b2SqrtW(b2FloatW a) { return _mm_sqrt_ps(a); }
+inline b2FloatW b2AbsW(b2FloatW a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+inline b2FloatW b2NegW(b2FloatW a) { return _mm_xor_ps(_mm_set1_ps(-0.0f), a); }
+
+/// Per lane a < b ? a : b, like b2Min.
+inline b2FloatW b2MinW(b2FloatW a, b2FloatW b) { return _mm_min_ps(a, b); }
+
+/// Per lane a > b ? a : b, like b2Max.
+inline b2FloatW b2MaxW(b2FloatW a, b2FloatW b) { return _mm_max_ps(a, b); }
+
+/// Per lane a > b as a mask for b2SelectW.
+inline b2FloatW b2GreaterW(b2FloatW a, b2FloatW b) { return _mm_cmpgt_ps(a, b); }
+
+/// Per lane mask ? a : b.
+inline b2FloatW b2SelectW(b2FloatW mask, b2FloatW a, b2FloatW b)
+{
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+/// Swap the lanes of each pair: (a, b, c, d) becomes (b, a, d, c). This swaps
+/// x and y of two packed b2Vec2.
+inline b2FloatW b2SwapPairsW(b2FloatW a) { return _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)); }
+
+/// Move the high pair to the low pair: (a, b, c, d) becomes (c, d, c, d).
+inline b2FloatW b2HighPairW(b2FloatW a) { return _mm_movehl_ps(a, a); }
+
+#else
+
+/// Four floats that are processed together.
+struct b2FloatW
+{
+	float32 v[4];
+};
+
+inline b2FloatW b2LoadW(const float32* p)
+{
+	b2FloatW r = { { p[0], p[1], p[2], p[3] } };
+	return r;
+}
+
+inline void b2StoreW(float32* p, b2FloatW a)
+{
+	p[0] = a.v[0]; p[1] = a.v[1]; p[2] = a.v[2]; p[3] = a.v[3];
+}
+
+inline b2FloatW b2SetW(float32 a, float32 b, float32 c, float32 d)
+{
+	b2FloatW r = { { a, b, c, d } };
+	return r;
+}
+
+inline b2FloatW b2SplatW(float32 s) { return b2SetW(s, s, s, s); }
+
+inline b2FloatW b2AddW(b2FloatW a, b2FloatW b)
+{
+	b2FloatW r;
+	for (int32 i = 0; i < 4; ++i)
+	{
+		r.v[i] = a.v[i] + b.v[i];
+	}
+	return r;
+}
+
+inline b2FloatW b2SubW(b2FloatW a, b2FloatW b)
+{
+	b2FloatW r;
+	for (int32 i = 0; i < 4; ++i)
+	{
+		r.v[i] = a.v[i] - b.v[i];
+	}
+	return r;
+}
+
+inline b2FloatW b2MulW(b2FloatW a, b2FloatW b)
+{
+	b2FloatW r;
+	for (int32 i = 0; i < 4; ++i)
+	{
+		r.v[i] = a.v[i] * b.v[i];
+	}
+	return r;
+}
+
+inline b2FloatW b2DivW(b2FloatW a, b2FloatW b)
+{
+	b2FloatW r;
+	for (int32 i = 0; i < 4; ++i)
+	{
+		r.v[i] = a.v[i] / b.v[i];
+	}
+	return r;
+}
+
+inline b2FloatW b2SqrtW(b2FloatW a)
+{
+	b2FloatW r;
+	for (int32 i = 0; i < 4; ++i)
+	{
+		r.v[i] = b2Sqrt(a.v[i]);
+	}
+	return r;
+}
+
+inline b2FloatW b2AbsW(b2FloatW a)
+{
+	b2FloatW r;
+	for (int32 i = 0; i < 4; ++i)
+	{
+		r.v[i] = b2Abs(a.v[i]);
+	}
+	return r;
+}
+
+inline b2FloatW b2NegW(b2FloatW a)
+{
+	b2FloatW r;
+	for (int32 i = 0; i < 4; ++i)
+	{
+		r.v[i] = -a.v[i];
+	}
+	return r;
+}
+
+/// Per lane a < b ? a : b, like b2Min.
+inline b2FloatW b2MinW(b2FloatW a, b2FloatW b)
+{
+	b2FloatW r;
+	for (int32 i = 0; i < 4; ++i)
+	{
+		r.v[i] = b2Min(a.v[i], b.v[i]);
+	}
+	return r;
+}
+
+/// Per lane a > b ? a : b, like b2Max.
+inline b2FloatW b2MaxW(b2FloatW a, b2FloatW b)
+{
+	b2FloatW r;
+	for (int32 i = 0; i < 4; ++i)
+	{
+		r.v[i] = b2Max(a.v[i], b.v[i]);
+	}
+	return r;
+}
+
+/// Per lane a > b as a mask for b2SelectW. The scalar mask is 1 or 0.
+inline b2FloatW b2GreaterW(b2FloatW a, b2FloatW b)
+{
+	b2FloatW r;
+	for (int32 i = 0; i < 4; ++i)
+	{
+		r.v[i] = a.v[i] > b.v[i] ? 1.0f : 0.0f;
+	}
+	return r;
+}
+
+/// Per lane mask ? a : b.
+inline b2FloatW b2SelectW(b2FloatW mask, b2FloatW a, b2FloatW b)
+{
+	b2FloatW r;
+	for (int32 i = 0; i < 4; ++i)
+	{
+		r.v[i] = mask.v[i] != 0.0f ? a.v[i] : b.v[i];
+	}
+	return r;
+}
+
+/// Swap the lanes of each pair: (a, b, c, d) becomes (b, a, d, c). This swaps
+/// x and y of two packed b2Vec2.
+inline b2FloatW b2SwapPairsW(b2FloatW a) { return b2SetW(a.v[1], a.v[0], a.v[3], a.v[2]); }
+
+/// Move the high pair to the low pair: (a, b, c, d) becomes (c, d, c, d).
+inline b2FloatW b2HighPairW(b2FloatW a) { return b2SetW(a.v[2], a.v[3], a.v[2], a.v[3]); }
+
+#endif
+
+/// Transform an array of points: out[i] = b2Mul(xf, points[i]). The arrays may
+/// be the same. The results match b2Mul exactly.
+void b2TransformPoints(b2Vec2* out, const b2Transform& xf, const b2Vec2* points, int32 count);
+
+/// Compute the bounds of an array of points. The count must be positive.
+void b2ComputeBounds(b2Vec2* lower, b2Vec2* upper, const b2Vec2* points, int32 count);
+
+/// Compute the bounds of an array of points after transforming them by xf,
+/// without storing the transformed points. The count must be positive.
+void b2TransformBounds(b2Vec2* lower, b2Vec2* upper, const b2Transform& xf, const b2Vec2* points, int32 count);
+
+#endif
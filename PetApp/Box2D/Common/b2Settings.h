@@ -35,6 +35,14 @@ typedef unsigned int uint32;
 typedef float float32;
 typedef double float64;
 
+/// Collision filter bits. Define B2_WIDE_FILTER_BITS to get 64 collision
+/// categories instead of 16.
+#ifdef B2_WIDE_FILTER_BITS
+typedef unsigned long long b2FilterBits;
+#else
+typedef uint16 b2FilterBits;
+#endif
+
 #define	b2_maxFloat		FLT_MAX
 #define	b2_epsilon		FLT_EPSILON
 #define b2_pi			3.14159265359f
@@ -49,6 +57,11 @@ typedef double float64;
 /// not change this value.
 #define b2_maxManifoldPoints	2
 
+/// The number of joints solved together by the batched joint solver. Joints of
+/// one batch never share a dynamic body, so a batch is solved with one b2FloatW
+/// per component. This must match b2_simdWidth.
+#define b2_jointBatchWidth		4
+
 /// The maximum number of vertices on a convex polygon. You cannot increase
 /// this too much because b2BlockAllocator has a maximum object size.
 #define b2_maxPolygonVertices	8
@@ -63,6 +76,20 @@ typedef double float64;
 /// This is a dimensionless multiplier.
 #define b2_aabbMultiplier		2.0f
 
+/// Adaptive AABB margins (see b2DynamicTree::SetAdaptiveMargins). The margin of a proxy
+/// is a fraction of its half-size plus its smoothed per-step displacement, clamped
+/// to [b2_aabbMinExtension, b2_aabbMaxExtension]. These are in meters.
+#define b2_aabbMinExtension		0.02f
+#define b2_aabbMaxExtension		1.0f
+
+/// The fraction of the proxy half-size used for the adaptive AABB margin.
+/// This is a dimensionless multiplier.
+#define b2_aabbSizeFactor		0.2f
+
+/// Weight of the newest displacement in the running average used by adaptive
+/// AABB margins. This is a dimensionless multiplier in (0, 1].
+#define b2_aabbDisplacementSmoothing	0.25f
+
 /// A small length used as a collision and constraint tolerance. Usually it is
 /// chosen to be numerically significant, but visually insignificant.
 #define b2_linearSlop			0.005f
@@ -113,6 +140,10 @@ typedef double float64;
 #define b2_baumgarte				0.2f
 #define b2_toiBaugarte				0.75f
 
+/// The slowest rate of multi-rate stepping. A body at rate level n is solved every
+/// 2^n steps.
+#define b2_maxRateLevel				2
+
 
 // Sleep
 
@@ -20,25 +20,23 @@
 
 #if defined(_WIN32)
 
-float64 b2Timer::s_invFrequency = 0.0f;
-
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
 
-b2Timer::b2Timer()
+static float64 b2QueryInvFrequency()
 {
 	LARGE_INTEGER largeInteger;
+	QueryPerformanceFrequency(&largeInteger);
+	float64 frequency = float64(largeInteger.QuadPart);
+	return frequency > 0.0f ? 1000.0f / frequency : 0.0f;
+}
 
-	if (s_invFrequency == 0.0f)
-	{
-		QueryPerformanceFrequency(&largeInteger);
-		s_invFrequency = float64(largeInteger.QuadPart);
-		if (s_invFrequency > 0.0f)
-		{
-			s_invFrequency = 1000.0f / s_invFrequency;
-		}
-	}
+// Set during static initialization so that timers can be created on several threads.
+float64 b2Timer::s_invFrequency = b2QueryInvFrequency();
 
+b2Timer::b2Timer()
+{
+	LARGE_INTEGER largeInteger;
 	QueryPerformanceCounter(&largeInteger);
 	m_start = float64(largeInteger.QuadPart);
 }
@@ -19,8 +19,6 @@
 #include <Box2D/Dynamics/Contacts/b2ChainAndCircleContact.h>
 #include <Box2D/Common/b2BlockAllocator.h>
 #include <Box2D/Dynamics/b2Fixture.h>
-#include <Box2D/Collision/Shapes/b2ChainShape.h>
-#include <Box2D/Collision/Shapes/b2EdgeShape.h>
 
 #include <new>
 
@@ -41,13 +39,6 @@ b2ChainAndCircleContact::b2ChainAndCircleContact(b2Fixture* fixtureA, int32 inde
 {
 	b2Assert(m_fixtureA->GetType() == b2Shape::e_chain);
 	b2Assert(m_fixtureB->GetType() == b2Shape::e_circle);
-}
 
-void b2ChainAndCircleContact::Evaluate(b2Manifold* manifold, const b2Transform& xfA, const b2Transform& xfB)
-{
-	b2ChainShape* chain = (b2ChainShape*)m_fixtureA->GetShape();
-	b2EdgeShape edge;
-	chain->GetChildEdge(&edge, m_indexA);
-	b2CollideEdgeAndCircle(	manifold, &edge, xfA,
-							(b2CircleShape*)m_fixtureB->GetShape(), xfB);
+	m_pairType = e_chainAndCirclePair;
 }
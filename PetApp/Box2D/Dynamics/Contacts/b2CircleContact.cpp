@@ -42,11 +42,6 @@ b2CircleContact::b2CircleContact(b2Fixture* fixtureA, b2Fixture* fixtureB)
 {
 	b2Assert(m_fixtureA->GetType() == b2Shape::e_circle);
 	b2Assert(m_fixtureB->GetType() == b2Shape::e_circle);
-}
 
-void b2CircleContact::Evaluate(b2Manifold* manifold, const b2Transform& xfA, const b2Transform& xfB)
-{
-	b2CollideCircles(manifold,
-					(b2CircleShape*)m_fixtureA->GetShape(), xfA,
-					(b2CircleShape*)m_fixtureB->GetShape(), xfB);
+	m_pairType = e_circlePair;
 }
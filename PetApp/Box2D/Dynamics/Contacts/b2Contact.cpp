@@ -34,74 +34,77 @@
 #include <Box2D/Dynamics/b2Fixture.h>
 #include <Box2D/Dynamics/b2World.h>
 
-b2ContactRegister b2Contact::s_registers[b2Shape::e_typeCount][b2Shape::e_typeCount];
-bool b2Contact::s_initialized = false;
-
-void b2Contact::InitializeRegisters()
-{
-	AddType(b2CircleContact::Create, b2CircleContact::Destroy, b2Shape::e_circle, b2Shape::e_circle);
-	AddType(b2PolygonAndCircleContact::Create, b2PolygonAndCircleContact::Destroy, b2Shape::e_polygon, b2Shape::e_circle);
-	AddType(b2PolygonContact::Create, b2PolygonContact::Destroy, b2Shape::e_polygon, b2Shape::e_polygon);
-	AddType(b2EdgeAndCircleContact::Create, b2EdgeAndCircleContact::Destroy, b2Shape::e_edge, b2Shape::e_circle);
-	AddType(b2EdgeAndPolygonContact::Create, b2EdgeAndPolygonContact::Destroy, b2Shape::e_edge, b2Shape::e_polygon);
-	AddType(b2ChainAndCircleContact::Create, b2ChainAndCircleContact::Destroy, b2Shape::e_chain, b2Shape::e_circle);
-	AddType(b2ChainAndPolygonContact::Create, b2ChainAndPolygonContact::Destroy, b2Shape::e_chain, b2Shape::e_polygon);
-}
-
-void b2Contact::AddType(b2ContactCreateFcn* createFcn, b2ContactDestroyFcn* destoryFcn,
-						b2Shape::Type type1, b2Shape::Type type2)
+// Create a contact of type T with the fixtures in the order T expects.
+template <typename T>
+static inline b2Contact* b2CreateContact(b2Fixture* fixtureA, int32 indexA, b2Fixture* fixtureB, int32 indexB,
+										 bool swap, b2BlockAllocator* allocator)
 {
-	b2Assert(0 <= type1 && type1 < b2Shape::e_typeCount);
-	b2Assert(0 <= type2 && type2 < b2Shape::e_typeCount);
-	
-	s_registers[type1][type2].createFcn = createFcn;
-	s_registers[type1][type2].destroyFcn = destoryFcn;
-	s_registers[type1][type2].primary = true;
-
-	if (type1 != type2)
+	if (swap)
 	{
-		s_registers[type2][type1].createFcn = createFcn;
-		s_registers[type2][type1].destroyFcn = destoryFcn;
-		s_registers[type2][type1].primary = false;
+		return T::Create(fixtureB, indexB, fixtureA, indexA, allocator);
 	}
+
+	return T::Create(fixtureA, indexA, fixtureB, indexB, allocator);
 }
 
 b2Contact* b2Contact::Create(b2Fixture* fixtureA, int32 indexA, b2Fixture* fixtureB, int32 indexB, b2BlockAllocator* allocator)
 {
-	if (s_initialized == false)
-	{
-		InitializeRegisters();
-		s_initialized = true;
-	}
-
 	b2Shape::Type type1 = fixtureA->GetType();
 	b2Shape::Type type2 = fixtureB->GetType();
 
 	b2Assert(0 <= type1 && type1 < b2Shape::e_typeCount);
 	b2Assert(0 <= type2 && type2 < b2Shape::e_typeCount);
-	
-	b2ContactCreateFcn* createFcn = s_registers[type1][type2].createFcn;
-	if (createFcn)
+
+	// The second shape of a pair is a circle or a polygon, and a circle only comes
+	// first when paired with another circle.
+	bool swap = type2 == b2Shape::e_edge || type2 == b2Shape::e_chain ||
+				(type1 == b2Shape::e_circle && type2 == b2Shape::e_polygon);
+	b2Shape::Type typeA = swap ? type2 : type1;
+	b2Shape::Type typeB = swap ? type1 : type2;
+
+	switch (typeA)
 	{
-		if (s_registers[type1][type2].primary)
+	case b2Shape::e_circle:
+		return b2CreateContact<b2CircleContact>(fixtureA, indexA, fixtureB, indexB, swap, allocator);
+
+	case b2Shape::e_polygon:
+		if (typeB == b2Shape::e_circle)
 		{
-			return createFcn(fixtureA, indexA, fixtureB, indexB, allocator);
+			return b2CreateContact<b2PolygonAndCircleContact>(fixtureA, indexA, fixtureB, indexB, swap, allocator);
 		}
-		else
+		return b2CreateContact<b2PolygonContact>(fixtureA, indexA, fixtureB, indexB, swap, allocator);
+
+	case b2Shape::e_edge:
+		if (typeB == b2Shape::e_circle)
 		{
-			return createFcn(fixtureB, indexB, fixtureA, indexA, allocator);
+			return b2CreateContact<b2EdgeAndCircleContact>(fixtureA, indexA, fixtureB, indexB, swap, allocator);
 		}
+		if (typeB == b2Shape::e_polygon)
+		{
+			return b2CreateContact<b2EdgeAndPolygonContact>(fixtureA, indexA, fixtureB, indexB, swap, allocator);
+		}
+		break;
+
+	case b2Shape::e_chain:
+		if (typeB == b2Shape::e_circle)
+		{
+			return b2CreateContact<b2ChainAndCircleContact>(fixtureA, indexA, fixtureB, indexB, swap, allocator);
+		}
+		if (typeB == b2Shape::e_polygon)
+		{
+			return b2CreateContact<b2ChainAndPolygonContact>(fixtureA, indexA, fixtureB, indexB, swap, allocator);
+		}
+		break;
+
+	default:
+		break;
 	}
-	else
-	{
-		return NULL;
-	}
+
+	return NULL;
 }
 
 void b2Contact::Destroy(b2Contact* contact, b2BlockAllocator* allocator)
 {
-	b2Assert(s_initialized == true);
-
 	b2Fixture* fixtureA = contact->m_fixtureA;
 	b2Fixture* fixtureB = contact->m_fixtureB;
 
@@ -113,14 +116,40 @@ void b2Contact::Destroy(b2Contact* contact, b2BlockAllocator* allocator)
 		fixtureB->GetBody()->SetAwake(true);
 	}
 
-	b2Shape::Type typeA = fixtureA->GetType();
-	b2Shape::Type typeB = fixtureB->GetType();
+	switch (contact->m_pairType)
+	{
+	case e_circlePair:
+		b2CircleContact::Destroy(contact, allocator);
+		break;
+
+	case e_polygonAndCirclePair:
+		b2PolygonAndCircleContact::Destroy(contact, allocator);
+		break;
+
+	case e_polygonPair:
+		b2PolygonContact::Destroy(contact, allocator);
+		break;
+
+	case e_edgeAndCirclePair:
+		b2EdgeAndCircleContact::Destroy(contact, allocator);
+		break;
 
-	b2Assert(0 <= typeA && typeB < b2Shape::e_typeCount);
-	b2Assert(0 <= typeA && typeB < b2Shape::e_typeCount);
+	case e_edgeAndPolygonPair:
+		b2EdgeAndPolygonContact::Destroy(contact, allocator);
+		break;
 
-	b2ContactDestroyFcn* destroyFcn = s_registers[typeA][typeB].destroyFcn;
-	destroyFcn(contact, allocator);
+	case e_chainAndCirclePair:
+		b2ChainAndCircleContact::Destroy(contact, allocator);
+		break;
+
+	case e_chainAndPolygonPair:
+		b2ChainAndPolygonContact::Destroy(contact, allocator);
+		break;
+
+	default:
+		b2Assert(false);
+		break;
+	}
 }
 
 b2Contact::b2Contact(b2Fixture* fA, int32 indexA, b2Fixture* fB, int32 indexB)
@@ -149,6 +178,7 @@ b2Contact::b2Contact(b2Fixture* fA, int32 indexA, b2Fixture* fB, int32 indexB)
 	m_nodeB.other = NULL;
 
 	m_toiCount = 0;
+	m_poolStep = 0;
 
 	m_friction = b2MixFriction(m_fixtureA->m_friction, m_fixtureB->m_friction);
 	m_restitution = b2MixRestitution(m_fixtureA->m_restitution, m_fixtureB->m_restitution);
@@ -158,8 +188,10 @@ b2Contact::b2Contact(b2Fixture* fA, int32 indexA, b2Fixture* fB, int32 indexB)
 
 // Update the contact manifold and touching status.
 // Note: do not assume the fixture AABBs are overlapping or are valid.
+template <typename T>
 void b2Contact::Update(b2ContactListener* listener)
 {
+
 	b2Manifold oldManifold = m_manifold;
 
 	// Re-enable this contact.
@@ -189,7 +221,8 @@ void b2Contact::Update(b2ContactListener* listener)
 	}
 	else
 	{
-		Evaluate(&m_manifold, xfA, xfB);
+		// Qualified call, so this is not dispatched through the vtable.
+		static_cast<T*>(this)->T::Evaluate(&m_manifold, xfA, xfB);
 		touching = m_manifold.pointCount > 0;
 
 		// Match old contact ids to new contact ids and copy the
@@ -245,3 +278,49 @@ void b2Contact::Update(b2ContactListener* listener)
 		listener->PreSolve(this, &oldManifold);
 	}
 }
+
+template void b2Contact::Update<b2CircleContact>(b2ContactListener* listener);
+template void b2Contact::Update<b2PolygonAndCircleContact>(b2ContactListener* listener);
+template void b2Contact::Update<b2PolygonContact>(b2ContactListener* listener);
+template void b2Contact::Update<b2EdgeAndCircleContact>(b2ContactListener* listener);
+template void b2Contact::Update<b2EdgeAndPolygonContact>(b2ContactListener* listener);
+template void b2Contact::Update<b2ChainAndCircleContact>(b2ContactListener* listener);
+template void b2Contact::Update<b2ChainAndPolygonContact>(b2ContactListener* listener);
+
+void b2Contact::Update(b2ContactListener* listener)
+{
+	switch (m_pairType)
+	{
+	case e_circlePair:
+		Update<b2CircleContact>(listener);
+		break;
+
+	case e_polygonAndCirclePair:
+		Update<b2PolygonAndCircleContact>(listener);
+		break;
+
+	case e_polygonPair:
+		Update<b2PolygonContact>(listener);
+		break;
+
+	case e_edgeAndCirclePair:
+		Update<b2EdgeAndCircleContact>(listener);
+		break;
+
+	case e_edgeAndPolygonPair:
+		Update<b2EdgeAndPolygonContact>(listener);
+		break;
+
+	case e_chainAndCirclePair:
+		Update<b2ChainAndCircleContact>(listener);
+		break;
+
+	case e_chainAndPolygonPair:
+		Update<b2ChainAndPolygonContact>(listener);
+		break;
+
+	default:
+		b2Assert(false);
+		break;
+	}
+}
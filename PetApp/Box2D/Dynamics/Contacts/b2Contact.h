@@ -46,18 +46,6 @@ inline float32 b2MixRestitution(float32 restitution1, float32 restitution2)
 	return restitution1 > restitution2 ? restitution1 : restitution2;
 }
 
-typedef b2Contact* b2ContactCreateFcn(	b2Fixture* fixtureA, int32 indexA,
-										b2Fixture* fixtureB, int32 indexB,
-										b2BlockAllocator* allocator);
-typedef void b2ContactDestroyFcn(b2Contact* contact, b2BlockAllocator* allocator);
-
-struct b2ContactRegister
-{
-	b2ContactCreateFcn* createFcn;
-	b2ContactDestroyFcn* destroyFcn;
-	bool primary;
-};
-
 /// A contact edge is used to connect bodies and contacts together
 /// in a contact graph where each body is a node and each contact
 /// is an edge. A contact edge belongs to a doubly linked list
@@ -97,6 +85,11 @@ public:
 	/// Has this contact been disabled?
 	bool IsEnabled() const;
 
+	/// Is this contact kept in the recycle pool? Pooled contacts stay in the
+	/// body contact lists but are not in the world contact list and never touch.
+	/// See b2World::SetContactRecycling.
+	bool IsPooled() const;
+
 	/// Get the next contact in the world's contact list.
 	b2Contact* GetNext();
 	const b2Contact* GetNext() const;
@@ -170,29 +163,46 @@ protected:
 		e_bulletHitFlag		= 0x0010,
 
 		// This contact has a valid TOI in m_toi
-		e_toiFlag			= 0x0020
+		e_toiFlag			= 0x0020,
+
+		// This contact is kept in the recycle pool of the contact manager
+		e_pooledFlag		= 0x0040
+	};
+
+	// Shape pair types. Contacts are created, updated and destroyed by switching on
+	// the pair type, so the narrow phase makes no indirect calls.
+	enum PairType
+	{
+		e_circlePair,
+		e_polygonAndCirclePair,
+		e_polygonPair,
+		e_edgeAndCirclePair,
+		e_edgeAndPolygonPair,
+		e_chainAndCirclePair,
+		e_chainAndPolygonPair,
+		e_pairTypeCount
 	};
 
 	/// Flag this contact for filtering. Filtering will occur the next time step.
 	void FlagForFiltering();
 
-	static void AddType(b2ContactCreateFcn* createFcn, b2ContactDestroyFcn* destroyFcn,
-						b2Shape::Type typeA, b2Shape::Type typeB);
-	static void InitializeRegisters();
 	static b2Contact* Create(b2Fixture* fixtureA, int32 indexA, b2Fixture* fixtureB, int32 indexB, b2BlockAllocator* allocator);
-	static void Destroy(b2Contact* contact, b2Shape::Type typeA, b2Shape::Type typeB, b2BlockAllocator* allocator);
 	static void Destroy(b2Contact* contact, b2BlockAllocator* allocator);
 
 	b2Contact() : m_fixtureA(NULL), m_fixtureB(NULL) {}
 	b2Contact(b2Fixture* fixtureA, int32 indexA, b2Fixture* fixtureB, int32 indexB);
 	virtual ~b2Contact() {}
 
+	// Update the manifold with the Evaluate of the concrete contact type T. This is
+	// instantiated for each pair type and calls Evaluate without virtual dispatch.
+	template <typename T>
 	void Update(b2ContactListener* listener);
 
-	static b2ContactRegister s_registers[b2Shape::e_typeCount][b2Shape::e_typeCount];
-	static bool s_initialized;
+	// Update the manifold, dispatching on the pair type.
+	void Update(b2ContactListener* listener);
 
 	uint32 m_flags;
+	int32 m_pairType;
 
 	// World pool and list pointers.
 	b2Contact* m_prev;
@@ -213,6 +223,9 @@ protected:
 	int32 m_toiCount;
 	float32 m_toi;
 
+	// The Collide call at which this contact entered the recycle pool.
+	int32 m_poolStep;
+
 	float32 m_friction;
 	float32 m_restitution;
 
@@ -261,6 +274,11 @@ inline bool b2Contact::IsTouching() const
 	return (m_flags & e_touchingFlag) == e_touchingFlag;
 }
 
+inline bool b2Contact::IsPooled() const
+{
+	return (m_flags & e_pooledFlag) == e_pooledFlag;
+}
+
 inline b2Contact* b2Contact::GetNext()
 {
 	return m_next;
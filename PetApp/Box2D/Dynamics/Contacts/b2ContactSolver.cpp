@@ -23,6 +23,7 @@
 #include <Box2D/Dynamics/b2Fixture.h>
 #include <Box2D/Dynamics/b2World.h>
 #include <Box2D/Common/b2StackAllocator.h>
+#include <Box2D/Common/b2MathBatch.h>
 
 #define B2_DEBUG_SOLVER 0
 
@@ -134,6 +135,74 @@ b2ContactSolver::~b2ContactSolver()
 	m_allocator->Free(m_positionConstraints);
 }
 
+// Compute the world normal and points like b2WorldManifold::Initialize. The clip
+// points of a face manifold are transformed together.
+static void b2ComputeWorldPoints(b2Vec2* normal, b2Vec2* points, const b2ContactPositionConstraint* pc,
+								 const b2Transform& xfA, const b2Transform& xfB)
+{
+	float32 radiusA = pc->radiusA;
+	float32 radiusB = pc->radiusB;
+
+	switch (pc->type)
+	{
+	case b2Manifold::e_circles:
+		{
+			b2Vec2 n(1.0f, 0.0f);
+			b2Vec2 pointA = b2Mul(xfA, pc->localPoint);
+			b2Vec2 pointB = b2Mul(xfB, pc->localPoints[0]);
+			if (b2DistanceSquared(pointA, pointB) > b2_epsilon * b2_epsilon)
+			{
+				n = pointB - pointA;
+				n.Normalize();
+			}
+
+			b2Vec2 cA = pointA + radiusA * n;
+			b2Vec2 cB = pointB - radiusB * n;
+			points[0] = 0.5f * (cA + cB);
+			*normal = n;
+		}
+		break;
+
+	case b2Manifold::e_faceA:
+		{
+			b2Vec2 n = b2Mul(xfA.q, pc->localNormal);
+			b2Vec2 planePoint = b2Mul(xfA, pc->localPoint);
+
+			b2Vec2 clipPoints[b2_maxManifoldPoints];
+			b2TransformPoints(clipPoints, xfB, pc->localPoints, pc->pointCount);
+
+			for (int32 i = 0; i < pc->pointCount; ++i)
+			{
+				b2Vec2 cA = clipPoints[i] + (radiusA - b2Dot(clipPoints[i] - planePoint, n)) * n;
+				b2Vec2 cB = clipPoints[i] - radiusB * n;
+				points[i] = 0.5f * (cA + cB);
+			}
+			*normal = n;
+		}
+		break;
+
+	case b2Manifold::e_faceB:
+		{
+			b2Vec2 n = b2Mul(xfB.q, pc->localNormal);
+			b2Vec2 planePoint = b2Mul(xfB, pc->localPoint);
+
+			b2Vec2 clipPoints[b2_maxManifoldPoints];
+			b2TransformPoints(clipPoints, xfA, pc->localPoints, pc->pointCount);
+
+			for (int32 i = 0; i < pc->pointCount; ++i)
+			{
+				b2Vec2 cB = clipPoints[i] + (radiusB - b2Dot(clipPoints[i] - planePoint, n)) * n;
+				b2Vec2 cA = clipPoints[i] - radiusA * n;
+				points[i] = 0.5f * (cA + cB);
+			}
+
+			// Ensure normal points from A to B.
+			*normal = -n;
+		}
+		break;
+	}
+}
+
 // Initialize position dependent portions of the velocity constraints.
 void b2ContactSolver::InitializeVelocityConstraints()
 {
@@ -142,10 +211,6 @@ void b2ContactSolver::InitializeVelocityConstraints()
 		b2ContactVelocityConstraint* vc = m_velocityConstraints + i;
 		b2ContactPositionConstraint* pc = m_positionConstraints + i;
 
-		float32 radiusA = pc->radiusA;
-		float32 radiusB = pc->radiusB;
-		b2Manifold* manifold = m_contacts[vc->contactIndex]->GetManifold();
-
 		int32 indexA = vc->indexA;
 		int32 indexB = vc->indexB;
 
@@ -166,7 +231,7 @@ void b2ContactSolver::InitializeVelocityConstraints()
 		b2Vec2 vB = m_velocities[indexB].v;
 		float32 wB = m_velocities[indexB].w;
 
-		b2Assert(manifold->pointCount > 0);
+		b2Assert(pc->pointCount > 0);
 
 		b2Transform xfA, xfB;
 		xfA.q.Set(aA);
@@ -174,18 +239,16 @@ void b2ContactSolver::InitializeVelocityConstraints()
 		xfA.p = cA - b2Mul(xfA.q, localCenterA);
 		xfB.p = cB - b2Mul(xfB.q, localCenterB);
 
-		b2WorldManifold worldManifold;
-		worldManifold.Initialize(manifold, xfA, radiusA, xfB, radiusB);
-
-		vc->normal = worldManifold.normal;
+		b2Vec2 worldPoints[b2_maxManifoldPoints];
+		b2ComputeWorldPoints(&vc->normal, worldPoints, pc, xfA, xfB);
 
 		int32 pointCount = vc->pointCount;
 		for (int32 j = 0; j < pointCount; ++j)
 		{
 			b2VelocityConstraintPoint* vcp = vc->points + j;
 
-			vcp->rA = worldManifold.points[j] - cA;
-			vcp->rB = worldManifold.points[j] - cB;
+			vcp->rA = worldPoints[j] - cA;
+			vcp->rB = worldPoints[j] - cB;
 
 			float32 rnA = b2Cross(vcp->rA, vc->normal);
 			float32 rnB = b2Cross(vcp->rB, vc->normal);
@@ -206,6 +269,7 @@ void b2ContactSolver::InitializeVelocityConstraints()
 			// Setup a velocity bias for restitution.
 			vcp->velocityBias = 0.0f;
 			float32 vRel = b2Dot(vc->normal, vB + b2Cross(wB, vcp->rB) - vA - b2Cross(wA, vcp->rA));
+			vcp->relativeVelocity = vRel;
 			if (vRel < -b2_velocityThreshold)
 			{
 				vcp->velocityBias = -vc->restitution * vRel;
@@ -37,6 +37,7 @@ struct b2VelocityConstraintPoint
 	float32 normalMass;
 	float32 tangentMass;
 	float32 velocityBias;
+	float32 relativeVelocity;
 };
 
 struct b2ContactVelocityConstraint
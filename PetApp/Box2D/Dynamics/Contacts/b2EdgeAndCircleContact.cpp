@@ -39,11 +39,6 @@ b2EdgeAndCircleContact::b2EdgeAndCircleContact(b2Fixture* fixtureA, b2Fixture* f
 {
 	b2Assert(m_fixtureA->GetType() == b2Shape::e_edge);
 	b2Assert(m_fixtureB->GetType() == b2Shape::e_circle);
-}
 
-void b2EdgeAndCircleContact::Evaluate(b2Manifold* manifold, const b2Transform& xfA, const b2Transform& xfB)
-{
-	b2CollideEdgeAndCircle(	manifold,
-								(b2EdgeShape*)m_fixtureA->GetShape(), xfA,
-								(b2CircleShape*)m_fixtureB->GetShape(), xfB);
+	m_pairType = e_edgeAndCirclePair;
 }
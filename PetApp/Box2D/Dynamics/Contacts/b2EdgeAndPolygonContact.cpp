@@ -39,11 +39,6 @@ b2EdgeAndPolygonContact::b2EdgeAndPolygonContact(b2Fixture* fixtureA, b2Fixture*
 {
 	b2Assert(m_fixtureA->GetType() == b2Shape::e_edge);
 	b2Assert(m_fixtureB->GetType() == b2Shape::e_polygon);
-}
 
-void b2EdgeAndPolygonContact::Evaluate(b2Manifold* manifold, const b2Transform& xfA, const b2Transform& xfB)
-{
-	b2CollideEdgeAndPolygon(	manifold,
-								(b2EdgeShape*)m_fixtureA->GetShape(), xfA,
-								(b2PolygonShape*)m_fixtureB->GetShape(), xfB);
+	m_pairType = e_edgeAndPolygonPair;
 }
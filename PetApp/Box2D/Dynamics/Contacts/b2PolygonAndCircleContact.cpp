@@ -39,11 +39,6 @@ b2PolygonAndCircleContact::b2PolygonAndCircleContact(b2Fixture* fixtureA, b2Fixt
 {
 	b2Assert(m_fixtureA->GetType() == b2Shape::e_polygon);
 	b2Assert(m_fixtureB->GetType() == b2Shape::e_circle);
-}
 
-void b2PolygonAndCircleContact::Evaluate(b2Manifold* manifold, const b2Transform& xfA, const b2Transform& xfB)
-{
-	b2CollidePolygonAndCircle(	manifold,
-								(b2PolygonShape*)m_fixtureA->GetShape(), xfA,
-								(b2CircleShape*)m_fixtureB->GetShape(), xfB);
+	m_pairType = e_polygonAndCirclePair;
 }
@@ -42,11 +42,6 @@ b2PolygonContact::b2PolygonContact(b2Fixture* fixtureA, b2Fixture* fixtureB)
 {
 	b2Assert(m_fixtureA->GetType() == b2Shape::e_polygon);
 	b2Assert(m_fixtureB->GetType() == b2Shape::e_polygon);
-}
 
-void b2PolygonContact::Evaluate(b2Manifold* manifold, const b2Transform& xfA, const b2Transform& xfB)
-{
-	b2CollidePolygons(	manifold,
-						(b2PolygonShape*)m_fixtureA->GetShape(), xfA,
-						(b2PolygonShape*)m_fixtureB->GetShape(), xfB);
+	m_pairType = e_polygonPair;
 }
@@ -0,0 +1,697 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include <Box2D/Dynamics/Joints/b2ArticulationSolver.h>
+#include <Box2D/Dynamics/Joints/b2RevoluteJoint.h>
+#include <Box2D/Dynamics/Joints/b2WeldJoint.h>
+#include <Box2D/Common/b2StackAllocator.h>
+
+#define b2_nullArticulationNode	(-1)
+
+// Levenberg-Marquardt damping of the position step, relative to the summed
+// inverse masses of a joint.
+#define b2_articulationDamping		0.01f
+
+// A^T * B
+static inline b2Mat33 b2MulT33(const b2Mat33& A, const b2Mat33& B)
+{
+	b2Mat33 C;
+	C.ex.Set(b2Dot(A.ex, B.ex), b2Dot(A.ey, B.ex), b2Dot(A.ez, B.ex));
+	C.ey.Set(b2Dot(A.ex, B.ey), b2Dot(A.ey, B.ey), b2Dot(A.ez, B.ey));
+	C.ez.Set(b2Dot(A.ex, B.ez), b2Dot(A.ey, B.ez), b2Dot(A.ez, B.ez));
+	return C;
+}
+
+// A * B
+static inline b2Mat33 b2Mul33(const b2Mat33& A, const b2Mat33& B)
+{
+	return b2Mat33(b2Mul(A, B.ex), b2Mul(A, B.ey), b2Mul(A, B.ez));
+}
+
+// A^T * v
+static inline b2Vec3 b2MulT(const b2Mat33& A, const b2Vec3& v)
+{
+	return b2Vec3(b2Dot(A.ex, v), b2Dot(A.ey, v), b2Dot(A.ez, v));
+}
+
+static inline b2Mat33 b2Transpose33(const b2Mat33& A)
+{
+	b2Mat33 B;
+	B.ex.Set(A.ex.x, A.ey.x, A.ez.x);
+	B.ey.Set(A.ex.y, A.ey.y, A.ez.y);
+	B.ez.Set(A.ex.z, A.ey.z, A.ez.z);
+	return B;
+}
+
+// Solver data shared by the supported joint types.
+struct b2ArticulatedJoint
+{
+	int32 indexA, indexB;
+	float32 invMassA, invMassB;
+	float32 invIA, invIB;
+	b2Vec2 rA, rB;
+	b2Vec2 localAnchorA, localAnchorB;
+	b2Vec2 localCenterA, localCenterB;
+	float32 referenceAngle;
+	int32 rows;
+};
+
+void b2ArticulationSolver::GetJointData(b2ArticulatedJoint* out, b2Joint* joint)
+{
+	if (joint->GetType() == e_revoluteJoint)
+	{
+		b2RevoluteJoint* j = (b2RevoluteJoint*)joint;
+		out->indexA = j->m_indexA;
+		out->indexB = j->m_indexB;
+		out->invMassA = j->m_invMassA;
+		out->invMassB = j->m_invMassB;
+		out->invIA = j->m_invIA;
+		out->invIB = j->m_invIB;
+		out->rA = j->m_rA;
+		out->rB = j->m_rB;
+		out->localAnchorA = j->m_localAnchorA;
+		out->localAnchorB = j->m_localAnchorB;
+		out->localCenterA = j->m_localCenterA;
+		out->localCenterB = j->m_localCenterB;
+		out->referenceAngle = j->m_referenceAngle;
+		out->rows = 2;
+	}
+	else
+	{
+		b2WeldJoint* j = (b2WeldJoint*)joint;
+		out->indexA = j->m_indexA;
+		out->indexB = j->m_indexB;
+		out->invMassA = j->m_invMassA;
+		out->invMassB = j->m_invMassB;
+		out->invIA = j->m_invIA;
+		out->invIB = j->m_invIB;
+		out->rA = j->m_rA;
+		out->rB = j->m_rB;
+		out->localAnchorA = j->m_localAnchorA;
+		out->localAnchorB = j->m_localAnchorB;
+		out->localCenterA = j->m_localCenterA;
+		out->localCenterB = j->m_localCenterB;
+		out->referenceAngle = j->m_referenceAngle;
+		out->rows = 3;
+	}
+}
+
+b2ArticulationSolver::b2ArticulationSolver()
+{
+	m_allocator = NULL;
+	m_nodes = NULL;
+	m_nodeCount = 0;
+	m_jointCount = 0;
+}
+
+bool b2ArticulationSolver::IsSupported(b2Joint* joint)
+{
+	switch (joint->GetType())
+	{
+	case e_revoluteJoint:
+		{
+			b2RevoluteJoint* j = (b2RevoluteJoint*)joint;
+			bool motor = j->m_enableMotor && j->m_limitState != e_equalLimits;
+			bool limit = j->m_enableLimit && j->m_limitState != e_inactiveLimit;
+			return motor == false && limit == false;
+		}
+
+	case e_weldJoint:
+		return ((b2WeldJoint*)joint)->m_frequencyHz == 0.0f;
+
+	default:
+		return false;
+	}
+}
+
+void b2ArticulationSolver::Initialize(b2Joint** joints, int32 count, int32 bodyCount, bool* accepted, b2StackAllocator* allocator)
+{
+	m_allocator = allocator;
+	m_nodes = NULL;
+	m_nodeCount = 0;
+	m_jointCount = 0;
+
+	for (int32 i = 0; i < count; ++i)
+	{
+		accepted[i] = false;
+	}
+
+	if (count == 0)
+	{
+		return;
+	}
+
+	int32 capacity = count + b2Min(2 * count, bodyCount);
+	m_nodes = (b2ArticulationNode*)m_allocator->Allocate(capacity * sizeof(b2ArticulationNode));
+
+	// Scratch arrays. Items are numbered bodies first, then joints.
+	int32 intCount = (bodyCount + 1) + bodyCount + bodyCount + count + (bodyCount + 1) + 2 * count + 6 * capacity;
+	int32* scratch = (int32*)m_allocator->Allocate(intCount * sizeof(int32) + 2 * bodyCount * sizeof(float32));
+	int32* sets = scratch;
+	int32* bodyItem = sets + bodyCount + 1;
+	int32* itemBody = bodyItem + bodyCount;
+	int32* jointIndex = itemBody + bodyCount;
+	int32* adjacencyOffset = jointIndex + count;
+	int32* adjacency = adjacencyOffset + bodyCount + 1;
+	int32* stack = adjacency + 2 * count;
+	int32* stackParent = stack + capacity;
+	int32* order = stackParent + capacity;
+	int32* itemParent = order + capacity;
+	int32* itemNode = itemParent + capacity;
+	int32* visited = itemNode + capacity;
+	float32* itemMass = (float32*)(visited + capacity);
+	float32* itemI = itemMass + bodyCount;
+
+	// Union-find over the dynamic bodies. All bodies without mass share the
+	// last set, so a second anchor to the ground closes a loop.
+	const int32 ground = bodyCount;
+	for (int32 i = 0; i <= bodyCount; ++i)
+	{
+		sets[i] = i;
+	}
+
+	for (int32 i = 0; i < bodyCount; ++i)
+	{
+		bodyItem[i] = b2_nullArticulationNode;
+	}
+
+	int32 bodyItemCount = 0;
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2Joint* joint = joints[i];
+		if (IsSupported(joint) == false)
+		{
+			continue;
+		}
+
+		b2ArticulatedJoint j;
+		GetJointData(&j, joint);
+
+		// Bodies with fixed rotation have a singular mass matrix.
+		bool dynamicA = j.invMassA > 0.0f && j.invIA > 0.0f;
+		bool dynamicB = j.invMassB > 0.0f && j.invIB > 0.0f;
+		bool staticA = j.invMassA == 0.0f && j.invIA == 0.0f;
+		bool staticB = j.invMassB == 0.0f && j.invIB == 0.0f;
+		if ((dynamicA || staticA) == false || (dynamicB || staticB) == false || (staticA && staticB))
+		{
+			continue;
+		}
+
+		int32 a = dynamicA ? j.indexA : ground;
+		int32 b = dynamicB ? j.indexB : ground;
+
+		while (sets[a] != a)
+		{
+			sets[a] = sets[sets[a]];
+			a = sets[a];
+		}
+
+		while (sets[b] != b)
+		{
+			sets[b] = sets[sets[b]];
+			b = sets[b];
+		}
+
+		if (a == b)
+		{
+			continue;
+		}
+
+		sets[a] = b;
+		accepted[i] = true;
+		jointIndex[m_jointCount++] = i;
+
+		if (dynamicA && bodyItem[j.indexA] == b2_nullArticulationNode)
+		{
+			itemBody[bodyItemCount] = j.indexA;
+			itemMass[bodyItemCount] = 1.0f / j.invMassA;
+			itemI[bodyItemCount] = 1.0f / j.invIA;
+			bodyItem[j.indexA] = bodyItemCount++;
+		}
+
+		if (dynamicB && bodyItem[j.indexB] == b2_nullArticulationNode)
+		{
+			itemBody[bodyItemCount] = j.indexB;
+			itemMass[bodyItemCount] = 1.0f / j.invMassB;
+			itemI[bodyItemCount] = 1.0f / j.invIB;
+			bodyItem[j.indexB] = bodyItemCount++;
+		}
+	}
+
+	if (m_jointCount == 0)
+	{
+		m_allocator->Free(scratch);
+		m_allocator->Free(m_nodes);
+		m_nodes = NULL;
+		return;
+	}
+
+	m_nodeCount = bodyItemCount + m_jointCount;
+	b2Assert(m_nodeCount <= capacity);
+
+	// Joint items of each body item.
+	for (int32 i = 0; i <= bodyItemCount; ++i)
+	{
+		adjacencyOffset[i] = 0;
+	}
+
+	for (int32 k = 0; k < m_jointCount; ++k)
+	{
+		b2ArticulatedJoint j;
+		GetJointData(&j, joints[jointIndex[k]]);
+		if (bodyItem[j.indexA] != b2_nullArticulationNode && j.invMassA > 0.0f)
+		{
+			++adjacencyOffset[bodyItem[j.indexA] + 1];
+		}
+		if (bodyItem[j.indexB] != b2_nullArticulationNode && j.invMassB > 0.0f)
+		{
+			++adjacencyOffset[bodyItem[j.indexB] + 1];
+		}
+	}
+
+	for (int32 i = 0; i < bodyItemCount; ++i)
+	{
+		adjacencyOffset[i + 1] += adjacencyOffset[i];
+	}
+
+	// The offsets are advanced while filling and restored afterwards.
+	for (int32 k = 0; k < m_jointCount; ++k)
+	{
+		b2ArticulatedJoint j;
+		GetJointData(&j, joints[jointIndex[k]]);
+		if (j.invMassA > 0.0f)
+		{
+			adjacency[adjacencyOffset[bodyItem[j.indexA]]++] = bodyItemCount + k;
+		}
+		if (j.invMassB > 0.0f)
+		{
+			adjacency[adjacencyOffset[bodyItem[j.indexB]]++] = bodyItemCount + k;
+		}
+	}
+
+	for (int32 i = bodyItemCount; i > 0; --i)
+	{
+		adjacencyOffset[i] = adjacencyOffset[i - 1];
+	}
+	adjacencyOffset[0] = 0;
+
+	for (int32 i = 0; i < m_nodeCount; ++i)
+	{
+		visited[i] = 0;
+	}
+
+	// Depth first pre-order. A joint anchored to a body without mass has a
+	// zero pivot as a leaf, so it must be the root of its tree.
+	int32 orderCount = 0;
+	for (int32 pass = 0; pass < 2; ++pass)
+	{
+		for (int32 root = 0; root < m_nodeCount; ++root)
+		{
+			if (visited[root])
+			{
+				continue;
+			}
+
+			if (pass == 0)
+			{
+				if (root < bodyItemCount)
+				{
+					continue;
+				}
+
+				b2ArticulatedJoint j;
+				GetJointData(&j, joints[jointIndex[root - bodyItemCount]]);
+				if (j.invMassA > 0.0f && j.invMassB > 0.0f)
+				{
+					continue;
+				}
+			}
+
+			int32 stackCount = 0;
+			stack[stackCount] = root;
+			stackParent[stackCount] = b2_nullArticulationNode;
+			++stackCount;
+			visited[root] = 1;
+
+			while (stackCount > 0)
+			{
+				--stackCount;
+				int32 item = stack[stackCount];
+				itemParent[item] = stackParent[stackCount];
+				order[orderCount++] = item;
+
+				if (item < bodyItemCount)
+				{
+					for (int32 e = adjacencyOffset[item]; e < adjacencyOffset[item + 1]; ++e)
+					{
+						int32 next = adjacency[e];
+						if (visited[next] == 0)
+						{
+							visited[next] = 1;
+							stack[stackCount] = next;
+							stackParent[stackCount] = item;
+							++stackCount;
+						}
+					}
+				}
+				else
+				{
+					b2ArticulatedJoint j;
+					GetJointData(&j, joints[jointIndex[item - bodyItemCount]]);
+					int32 next[2] =
+					{
+						j.invMassA > 0.0f ? bodyItem[j.indexA] : b2_nullArticulationNode,
+						j.invMassB > 0.0f ? bodyItem[j.indexB] : b2_nullArticulationNode
+					};
+
+					for (int32 e = 0; e < 2; ++e)
+					{
+						if (next[e] != b2_nullArticulationNode && visited[next[e]] == 0)
+						{
+							visited[next[e]] = 1;
+							stack[stackCount] = next[e];
+							stackParent[stackCount] = item;
+							++stackCount;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	b2Assert(orderCount == m_nodeCount);
+
+	// Reverse pre-order puts every child before its parent.
+	for (int32 k = 0; k < m_nodeCount; ++k)
+	{
+		itemNode[order[k]] = m_nodeCount - 1 - k;
+	}
+
+	for (int32 item = 0; item < m_nodeCount; ++item)
+	{
+		b2ArticulationNode* node = m_nodes + itemNode[item];
+		node->parent = itemParent[item] == b2_nullArticulationNode ? b2_nullArticulationNode : itemNode[itemParent[item]];
+
+		if (item < bodyItemCount)
+		{
+			node->joint = NULL;
+			node->body = itemBody[item];
+			node->mass = itemMass[item];
+			node->I = itemI[item];
+			node->indexA = b2_nullArticulationNode;
+			node->indexB = b2_nullArticulationNode;
+			node->rows = 0;
+		}
+		else
+		{
+			b2Joint* joint = joints[jointIndex[item - bodyItemCount]];
+			b2ArticulatedJoint j;
+			GetJointData(&j, joint);
+			node->joint = joint;
+			node->body = b2_nullArticulationNode;
+			node->mass = j.invMassA + j.invMassB;
+			node->I = 0.0f;
+			node->indexA = j.indexA;
+			node->indexB = j.indexB;
+			node->rows = j.rows;
+		}
+	}
+
+	m_allocator->Free(scratch);
+}
+
+void b2ArticulationSolver::Destroy()
+{
+	if (m_nodes)
+	{
+		m_allocator->Free(m_nodes);
+		m_nodes = NULL;
+	}
+}
+
+// Constraint rows of a joint node with respect to one of its bodies.
+void b2ArticulationSolver::GetJacobian(b2Mat33* J, const b2ArticulationNode* node, int32 body)
+{
+	float32 sign;
+	b2Vec2 r;
+	if (body == node->indexA)
+	{
+		sign = -1.0f;
+		r = node->rA;
+	}
+	else
+	{
+		b2Assert(body == node->indexB);
+		sign = 1.0f;
+		r = node->rB;
+	}
+
+	J->ex.Set(sign, 0.0f, 0.0f);
+	J->ey.Set(0.0f, sign, 0.0f);
+	J->ez.Set(-sign * r.y, sign * r.x, node->rows == 3 ? sign : 0.0f);
+}
+
+void b2ArticulationSolver::Factor(float32 damping)
+{
+	for (int32 i = 0; i < m_nodeCount; ++i)
+	{
+		b2ArticulationNode* node = m_nodes + i;
+		if (node->joint)
+		{
+			// Hard constraints have a zero diagonal, damped constraints a small
+			// negative one. An unused row is decoupled with a unit pivot.
+			float32 d = -damping * node->mass;
+			node->D.SetZero();
+			node->D.ex.x = d;
+			node->D.ey.y = d;
+			node->D.ez.z = d;
+			if (node->rows == 2)
+			{
+				node->D.ez.z = 1.0f;
+			}
+		}
+		else
+		{
+			node->D.ex.Set(node->mass, 0.0f, 0.0f);
+			node->D.ey.Set(0.0f, node->mass, 0.0f);
+			node->D.ez.Set(0.0f, 0.0f, node->I);
+		}
+	}
+
+	for (int32 i = 0; i < m_nodeCount; ++i)
+	{
+		b2ArticulationNode* node = m_nodes + i;
+
+		b2Mat33 invD;
+		node->D.GetSymInverse33(&invD);
+		node->D = invD;
+
+		if (node->parent == b2_nullArticulationNode)
+		{
+			continue;
+		}
+
+		b2ArticulationNode* parent = m_nodes + node->parent;
+
+		b2Mat33 H;
+		if (node->joint)
+		{
+			GetJacobian(&H, node, parent->body);
+		}
+		else
+		{
+			b2Mat33 J;
+			GetJacobian(&J, parent, node->body);
+			H = b2Transpose33(J);
+		}
+
+		node->L = b2Mul33(invD, H);
+
+		b2Mat33 S = b2MulT33(H, node->L);
+		parent->D.ex -= S.ex;
+		parent->D.ey -= S.ey;
+		parent->D.ez -= S.ez;
+	}
+}
+
+void b2ArticulationSolver::Solve()
+{
+	for (int32 i = 0; i < m_nodeCount; ++i)
+	{
+		const b2ArticulationNode* node = m_nodes + i;
+		if (node->parent != b2_nullArticulationNode)
+		{
+			m_nodes[node->parent].x -= b2MulT(node->L, node->x);
+		}
+	}
+
+	for (int32 i = m_nodeCount - 1; i >= 0; --i)
+	{
+		b2ArticulationNode* node = m_nodes + i;
+		node->x = b2Mul(node->D, node->x);
+		if (node->parent != b2_nullArticulationNode)
+		{
+			node->x -= b2Mul(node->L, m_nodes[node->parent].x);
+		}
+	}
+}
+
+void b2ArticulationSolver::InitVelocityConstraints(const b2SolverData& data)
+{
+	B2_NOT_USED(data);
+
+	for (int32 i = 0; i < m_nodeCount; ++i)
+	{
+		b2ArticulationNode* node = m_nodes + i;
+		if (node->joint)
+		{
+			b2ArticulatedJoint j;
+			GetJointData(&j, node->joint);
+			node->rA = j.rA;
+			node->rB = j.rB;
+		}
+	}
+
+	// The Jacobians are fixed during the velocity iterations.
+	Factor(0.0f);
+}
+
+void b2ArticulationSolver::SolveVelocityConstraints(const b2SolverData& data)
+{
+	for (int32 i = 0; i < m_nodeCount; ++i)
+	{
+		b2ArticulationNode* node = m_nodes + i;
+		if (node->joint == NULL)
+		{
+			node->x.SetZero();
+			continue;
+		}
+
+		b2Vec2 vA = data.velocities[node->indexA].v;
+		float32 wA = data.velocities[node->indexA].w;
+		b2Vec2 vB = data.velocities[node->indexB].v;
+		float32 wB = data.velocities[node->indexB].w;
+
+		b2Vec2 Cdot1 = vB + b2Cross(wB, node->rB) - vA - b2Cross(wA, node->rA);
+		float32 Cdot2 = node->rows == 3 ? wB - wA : 0.0f;
+		node->x.Set(-Cdot1.x, -Cdot1.y, -Cdot2);
+	}
+
+	Solve();
+
+	// Body nodes receive the velocity change, joint nodes the negated impulse.
+	for (int32 i = 0; i < m_nodeCount; ++i)
+	{
+		const b2ArticulationNode* node = m_nodes + i;
+		if (node->joint == NULL)
+		{
+			data.velocities[node->body].v += b2Vec2(node->x.x, node->x.y);
+			data.velocities[node->body].w += node->x.z;
+		}
+		else if (node->rows == 2)
+		{
+			b2RevoluteJoint* joint = (b2RevoluteJoint*)node->joint;
+			joint->m_impulse.x -= node->x.x;
+			joint->m_impulse.y -= node->x.y;
+		}
+		else
+		{
+			b2WeldJoint* joint = (b2WeldJoint*)node->joint;
+			joint->m_impulse -= node->x;
+		}
+	}
+}
+
+bool b2ArticulationSolver::SolvePositionConstraints(const b2SolverData& data)
+{
+	float32 linearError = 0.0f;
+	float32 angularError = 0.0f;
+
+	for (int32 i = 0; i < m_nodeCount; ++i)
+	{
+		b2ArticulationNode* node = m_nodes + i;
+		if (node->joint == NULL)
+		{
+			node->x.SetZero();
+			continue;
+		}
+
+		b2ArticulatedJoint j;
+		GetJointData(&j, node->joint);
+
+		b2Vec2 cA = data.positions[node->indexA].c;
+		float32 aA = data.positions[node->indexA].a;
+		b2Vec2 cB = data.positions[node->indexB].c;
+		float32 aB = data.positions[node->indexB].a;
+
+		b2Rot qA(aA), qB(aB);
+		node->rA = b2Mul(qA, j.localAnchorA - j.localCenterA);
+		node->rB = b2Mul(qB, j.localAnchorB - j.localCenterB);
+
+		b2Vec2 C1 = cB + node->rB - cA - node->rA;
+		float32 C2 = node->rows == 3 ? aB - aA - j.referenceAngle : 0.0f;
+
+		linearError = b2Max(linearError, C1.Length());
+		angularError = b2Max(angularError, b2Abs(C2));
+
+		node->x.Set(-C1.x, -C1.y, -C2);
+	}
+
+	// One Newton step on the whole tree.
+	// A little damping keeps the step small in directions where the
+	// linearization is nearly singular, such as stretching a straight chain.
+	Factor(b2_articulationDamping);
+	Solve();
+
+	// Light bodies can take large rotations where the linearization is poor.
+	// Scale the whole step down to the usual correction limits.
+	float32 maxLinear = 0.0f;
+	float32 maxAngular = 0.0f;
+	for (int32 i = 0; i < m_nodeCount; ++i)
+	{
+		const b2ArticulationNode* node = m_nodes + i;
+		if (node->joint == NULL)
+		{
+			maxLinear = b2Max(maxLinear, b2Vec2(node->x.x, node->x.y).Length());
+			maxAngular = b2Max(maxAngular, b2Abs(node->x.z));
+		}
+	}
+
+	float32 scale = 1.0f;
+	if (maxLinear > b2_maxLinearCorrection)
+	{
+		scale = b2_maxLinearCorrection / maxLinear;
+	}
+	if (maxAngular * scale > b2_maxAngularCorrection)
+	{
+		scale = b2_maxAngularCorrection / maxAngular;
+	}
+
+	for (int32 i = 0; i < m_nodeCount; ++i)
+	{
+		const b2ArticulationNode* node = m_nodes + i;
+		if (node->joint == NULL)
+		{
+			data.positions[node->body].c += scale * b2Vec2(node->x.x, node->x.y);
+			data.positions[node->body].a += scale * node->x.z;
+		}
+	}
+
+	return linearError <= b2_linearSlop && angularError <= b2_angularSlop;
+}
@@ -0,0 +1,93 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#ifndef B2_ARTICULATION_SOLVER_H
+#define B2_ARTICULATION_SOLVER_H
+
+#include <Box2D/Common/b2Math.h>
+#include <Box2D/Dynamics/b2TimeStep.h>
+
+class b2Joint;
+class b2StackAllocator;
+struct b2ArticulatedJoint;
+
+/// A node of the body/joint graph. Body nodes hold the mass matrix, joint nodes
+/// hold the constraint rows. Revolute joints use the first two rows only.
+struct b2ArticulationNode
+{
+	b2Mat33 D;			// pivot block, replaced by its inverse in Factor
+	b2Mat33 L;			// inverse(D) * H(node, parent)
+	b2Vec3 x;			// right hand side and solution
+	b2Vec2 rA;
+	b2Vec2 rB;
+	b2Joint* joint;		// NULL for body nodes
+	int32 indexA;
+	int32 indexB;
+	int32 body;			// island body index for body nodes
+	float32 mass;		// body mass, or the summed inverse masses of a joint
+	float32 I;
+	int32 rows;			// constraint rows of a joint node
+	int32 parent;		// parent node or -1 for a root
+};
+
+/// Direct solver for tree-structured joint graphs (Baraff, "Linear-Time Dynamics
+/// using Lagrange Multipliers"). The system [M J'; J 0] is ordered leaves first so
+/// the block LDL' factorization has no fill-in and costs O(n).
+///
+/// Revolute joints without an active motor or limit and rigid weld joints are
+/// accepted. A joint that would close a loop, including a loop through static
+/// bodies, is left to the iterative solver.
+class b2ArticulationSolver
+{
+public:
+	b2ArticulationSolver();
+
+	/// Pick the joints handled by this solver and order the graph. The flags
+	/// are set for the accepted joints.
+	void Initialize(b2Joint** joints, int32 count, int32 bodyCount, bool* accepted, b2StackAllocator* allocator);
+
+	/// Free the node storage. Must follow the stack allocator order.
+	void Destroy();
+
+	/// Is this joint type and configuration supported?
+	static bool IsSupported(b2Joint* joint);
+
+	void InitVelocityConstraints(const b2SolverData& data);
+
+	/// Solve all accepted joints exactly for the current velocities.
+	void SolveVelocityConstraints(const b2SolverData& data);
+
+	/// Project the positions of all accepted joints with one Newton step.
+	bool SolvePositionConstraints(const b2SolverData& data);
+
+	int32 GetJointCount() const { return m_jointCount; }
+
+private:
+	static void GetJointData(b2ArticulatedJoint* out, b2Joint* joint);
+	static void GetJacobian(b2Mat33* J, const b2ArticulationNode* jointNode, int32 body);
+	void Factor(float32 damping);
+	void Solve();
+
+	b2StackAllocator* m_allocator;
+	b2ArticulationNode* m_nodes;
+	int32 m_nodeCount;
+	int32 m_jointCount;
+};
+
+#endif
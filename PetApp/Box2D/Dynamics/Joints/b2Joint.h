@@ -153,6 +153,7 @@ protected:
 	friend class b2World;
 	friend class b2Body;
 	friend class b2Island;
+	friend class b2JointSolver;
 	friend class b2GearJoint;
 
 	static b2Joint* Create(const b2JointDef* def, b2BlockAllocator* allocator);
@@ -0,0 +1,729 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include <Box2D/Dynamics/Joints/b2JointSolver.h>
+#include <Box2D/Dynamics/Joints/b2DistanceJoint.h>
+#include <Box2D/Dynamics/Joints/b2RevoluteJoint.h>
+#include <Box2D/Common/b2MathBatch.h>
+#include <Box2D/Common/b2StackAllocator.h>
+
+#include <string.h>
+
+#define b2_jointTypeCount	(e_motorJoint + 1)
+#define b2_nullBody			(-1)
+#define b2_jointBatchFloats	16
+
+static_assert(b2_jointBatchWidth == b2_simdWidth, "a joint block must fill one b2FloatW");
+
+// Velocities of one block of lanes.
+struct b2JointLanes
+{
+	float32 vAx[b2_jointBatchWidth];
+	float32 vAy[b2_jointBatchWidth];
+	float32 wA[b2_jointBatchWidth];
+	float32 vBx[b2_jointBatchWidth];
+	float32 vBy[b2_jointBatchWidth];
+	float32 wB[b2_jointBatchWidth];
+};
+
+// Carve a batch for count joints out of a single stack allocation. Every color
+// adds at most b2_jointBatchWidth - 1 empty lanes.
+static void b2AllocateBatch(b2JointBatch* batch, int32 count, b2StackAllocator* allocator)
+{
+	batch->count = 0;
+	batch->colorCount = 0;
+	batch->capacity = 0;
+	batch->joints = NULL;
+
+	if (count == 0)
+	{
+		return;
+	}
+
+	int32 capacity = count + (b2_jointBatchWidth - 1) * b2Min(count, b2_maxJointColors);
+	int32 size = capacity * (sizeof(b2Joint*) + 2 * sizeof(int32) + b2_jointBatchFloats * sizeof(float32));
+	char* memory = (char*)allocator->Allocate(size);
+
+	batch->capacity = capacity;
+	batch->joints = (b2Joint**)memory;
+	memory += capacity * sizeof(b2Joint*);
+	batch->indexA = (int32*)memory;
+	memory += capacity * sizeof(int32);
+	batch->indexB = (int32*)memory;
+	memory += capacity * sizeof(int32);
+
+	float32** fields[b2_jointBatchFloats] =
+	{
+		&batch->rAx, &batch->rAy, &batch->rBx, &batch->rBy,
+		&batch->invMassA, &batch->invMassB, &batch->invIA, &batch->invIB,
+		&batch->a1, &batch->a2, &batch->a3, &batch->a4, &batch->a5,
+		&batch->impulse1, &batch->impulse2, NULL
+	};
+
+	for (int32 i = 0; i < b2_jointBatchFloats && fields[i] != NULL; ++i)
+	{
+		*fields[i] = (float32*)memory;
+		memory += capacity * sizeof(float32);
+	}
+}
+
+static void b2FreeBatch(b2JointBatch* batch, b2StackAllocator* allocator)
+{
+	if (batch->joints)
+	{
+		allocator->Free(batch->joints);
+	}
+}
+
+// Is the velocity constraint of this joint handled by a batch?
+bool b2JointSolver::IsBatched(b2Joint* joint)
+{
+	switch (joint->GetType())
+	{
+	case e_distanceJoint:
+		return true;
+
+	case e_revoluteJoint:
+		{
+			// Only the point-to-point part is batched. Active motors and limits
+			// need the block solver.
+			b2RevoluteJoint* j = (b2RevoluteJoint*)joint;
+			if (j->m_invIA + j->m_invIB == 0.0f)
+			{
+				return true;
+			}
+
+			bool motor = j->m_enableMotor && j->m_limitState != e_equalLimits;
+			bool limit = j->m_enableLimit && j->m_limitState != e_inactiveLimit;
+			return motor == false && limit == false;
+		}
+
+	default:
+		return false;
+	}
+}
+
+// Island indices of the bodies a joint writes to. Bodies without mass are
+// never changed by the solver and may be shared within a color.
+void b2JointSolver::GetDynamicBodies(b2Joint* joint, int32* indexA, int32* indexB)
+{
+	float32 mA, iA, mB, iB;
+	if (joint->GetType() == e_distanceJoint)
+	{
+		b2DistanceJoint* j = (b2DistanceJoint*)joint;
+		*indexA = j->m_indexA;
+		*indexB = j->m_indexB;
+		mA = j->m_invMassA; iA = j->m_invIA;
+		mB = j->m_invMassB; iB = j->m_invIB;
+	}
+	else
+	{
+		b2RevoluteJoint* j = (b2RevoluteJoint*)joint;
+		*indexA = j->m_indexA;
+		*indexB = j->m_indexB;
+		mA = j->m_invMassA; iA = j->m_invIA;
+		mB = j->m_invMassB; iB = j->m_invIB;
+	}
+
+	if (mA == 0.0f && iA == 0.0f)
+	{
+		*indexA = b2_nullBody;
+	}
+
+	if (mB == 0.0f && iB == 0.0f)
+	{
+		*indexB = b2_nullBody;
+	}
+}
+
+void b2JointSolver::SetLane(b2JointBatch* batch, int32 lane, b2Joint* joint)
+{
+	batch->joints[lane] = joint;
+
+	if (joint == NULL)
+	{
+		batch->indexA[lane] = b2_nullBody;
+		batch->indexB[lane] = b2_nullBody;
+		batch->rAx[lane] = 0.0f;
+		batch->rAy[lane] = 0.0f;
+		batch->rBx[lane] = 0.0f;
+		batch->rBy[lane] = 0.0f;
+		batch->invMassA[lane] = 0.0f;
+		batch->invMassB[lane] = 0.0f;
+		batch->invIA[lane] = 0.0f;
+		batch->invIB[lane] = 0.0f;
+		batch->a1[lane] = 0.0f;
+		batch->a2[lane] = 0.0f;
+		batch->a3[lane] = 0.0f;
+		batch->a4[lane] = 0.0f;
+		batch->a5[lane] = 0.0f;
+		batch->impulse1[lane] = 0.0f;
+		batch->impulse2[lane] = 0.0f;
+		return;
+	}
+
+	if (joint->GetType() == e_distanceJoint)
+	{
+		b2DistanceJoint* j = (b2DistanceJoint*)joint;
+		batch->indexA[lane] = j->m_indexA;
+		batch->indexB[lane] = j->m_indexB;
+		batch->rAx[lane] = j->m_rA.x;
+		batch->rAy[lane] = j->m_rA.y;
+		batch->rBx[lane] = j->m_rB.x;
+		batch->rBy[lane] = j->m_rB.y;
+		batch->invMassA[lane] = j->m_invMassA;
+		batch->invMassB[lane] = j->m_invMassB;
+		batch->invIA[lane] = j->m_invIA;
+		batch->invIB[lane] = j->m_invIB;
+		batch->a1[lane] = j->m_u.x;
+		batch->a2[lane] = j->m_u.y;
+		batch->a3[lane] = j->m_mass;
+		batch->a4[lane] = j->m_bias;
+		batch->a5[lane] = j->m_gamma;
+		batch->impulse1[lane] = j->m_impulse;
+		batch->impulse2[lane] = 0.0f;
+	}
+	else
+	{
+		b2RevoluteJoint* j = (b2RevoluteJoint*)joint;
+		batch->indexA[lane] = j->m_indexA;
+		batch->indexB[lane] = j->m_indexB;
+		batch->rAx[lane] = j->m_rA.x;
+		batch->rAy[lane] = j->m_rA.y;
+		batch->rBx[lane] = j->m_rB.x;
+		batch->rBy[lane] = j->m_rB.y;
+		batch->invMassA[lane] = j->m_invMassA;
+		batch->invMassB[lane] = j->m_invMassB;
+		batch->invIA[lane] = j->m_invIA;
+		batch->invIB[lane] = j->m_invIB;
+
+		// Inverse of the upper 2x2 block, matching b2Mat33::Solve22.
+		const b2Mat33& K = j->m_mass;
+		float32 det = K.ex.x * K.ey.y - K.ey.x * K.ex.y;
+		if (det != 0.0f)
+		{
+			det = 1.0f / det;
+		}
+		batch->a1[lane] = det * K.ey.y;
+		batch->a2[lane] = -det * K.ey.x;
+		batch->a3[lane] = -det * K.ex.y;
+		batch->a4[lane] = det * K.ex.x;
+		batch->a5[lane] = 0.0f;
+		batch->impulse1[lane] = j->m_impulse.x;
+		batch->impulse2[lane] = j->m_impulse.y;
+	}
+}
+
+// Greedy coloring of the batched joints of one type. Joints that do not fit in
+// a color are moved to the scalar list.
+void b2JointSolver::BuildBatch(b2JointBatch* batch, b2JointType type, uint32* bodyMasks, int32* colors)
+{
+	if (batch->joints == NULL)
+	{
+		return;
+	}
+
+	memset(bodyMasks, 0, m_bodyCount * sizeof(uint32));
+
+	int32 colorCounts[b2_maxJointColors];
+	memset(colorCounts, 0, sizeof(colorCounts));
+
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		b2Joint* joint = m_joints[i];
+		colors[i] = b2_nullBody;
+
+		if (joint->GetType() != type || m_articulated[i] || IsBatched(joint) == false)
+		{
+			continue;
+		}
+
+		int32 indexA, indexB;
+		GetDynamicBodies(joint, &indexA, &indexB);
+
+		uint32 used = 0;
+		if (indexA != b2_nullBody)
+		{
+			used |= bodyMasks[indexA];
+		}
+		if (indexB != b2_nullBody)
+		{
+			used |= bodyMasks[indexB];
+		}
+
+		int32 color = 0;
+		while (color < b2_maxJointColors && (used & (1u << color)) != 0)
+		{
+			++color;
+		}
+
+		if (color == b2_maxJointColors)
+		{
+			m_scalarJoints[m_scalarCount++] = joint;
+			continue;
+		}
+
+		uint32 bit = 1u << color;
+		if (indexA != b2_nullBody)
+		{
+			bodyMasks[indexA] |= bit;
+		}
+		if (indexB != b2_nullBody)
+		{
+			bodyMasks[indexB] |= bit;
+		}
+
+		colors[i] = color;
+		++colorCounts[color];
+	}
+
+	// Pad every color to whole blocks so a block never spans two colors.
+	int32 offset = 0;
+	int32 fill[b2_maxJointColors];
+	batch->colorCount = 0;
+	for (int32 c = 0; c < b2_maxJointColors && colorCounts[c] > 0; ++c)
+	{
+		batch->colorOffsets[c] = offset;
+		fill[c] = offset;
+		offset += ((colorCounts[c] + b2_jointBatchWidth - 1) / b2_jointBatchWidth) * b2_jointBatchWidth;
+		batch->colorCount = c + 1;
+	}
+	batch->colorOffsets[batch->colorCount] = offset;
+	batch->count = offset;
+	b2Assert(offset <= batch->capacity);
+
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		if (colors[i] != b2_nullBody)
+		{
+			SetLane(batch, fill[colors[i]]++, m_joints[i]);
+		}
+	}
+
+	for (int32 c = 0; c < batch->colorCount; ++c)
+	{
+		while (fill[c] < batch->colorOffsets[c + 1])
+		{
+			SetLane(batch, fill[c]++, NULL);
+		}
+	}
+}
+
+static inline void b2GatherLanes(b2JointLanes* lanes, const b2JointBatch* batch, int32 base, const b2Velocity* velocities)
+{
+	for (int32 k = 0; k < b2_jointBatchWidth; ++k)
+	{
+		int32 indexA = batch->indexA[base + k];
+		int32 indexB = batch->indexB[base + k];
+
+		if (indexA != b2_nullBody)
+		{
+			lanes->vAx[k] = velocities[indexA].v.x;
+			lanes->vAy[k] = velocities[indexA].v.y;
+			lanes->wA[k] = velocities[indexA].w;
+		}
+		else
+		{
+			lanes->vAx[k] = 0.0f;
+			lanes->vAy[k] = 0.0f;
+			lanes->wA[k] = 0.0f;
+		}
+
+		if (indexB != b2_nullBody)
+		{
+			lanes->vBx[k] = velocities[indexB].v.x;
+			lanes->vBy[k] = velocities[indexB].v.y;
+			lanes->wB[k] = velocities[indexB].w;
+		}
+		else
+		{
+			lanes->vBx[k] = 0.0f;
+			lanes->vBy[k] = 0.0f;
+			lanes->wB[k] = 0.0f;
+		}
+	}
+}
+
+static inline void b2ScatterLanes(const b2JointLanes* lanes, const b2JointBatch* batch, int32 base, b2Velocity* velocities)
+{
+	for (int32 k = 0; k < b2_jointBatchWidth; ++k)
+	{
+		int32 indexA = batch->indexA[base + k];
+		int32 indexB = batch->indexB[base + k];
+
+		if (indexA != b2_nullBody)
+		{
+			velocities[indexA].v.Set(lanes->vAx[k], lanes->vAy[k]);
+			velocities[indexA].w = lanes->wA[k];
+		}
+
+		if (indexB != b2_nullBody)
+		{
+			velocities[indexB].v.Set(lanes->vBx[k], lanes->vBy[k]);
+			velocities[indexB].w = lanes->wB[k];
+		}
+	}
+}
+
+// Lane velocities as one b2FloatW per component.
+struct b2JointLanesW
+{
+	void Load(const b2JointLanes& lanes)
+	{
+		vAx = b2LoadW(lanes.vAx);
+		vAy = b2LoadW(lanes.vAy);
+		wA = b2LoadW(lanes.wA);
+		vBx = b2LoadW(lanes.vBx);
+		vBy = b2LoadW(lanes.vBy);
+		wB = b2LoadW(lanes.wB);
+	}
+
+	void Store(b2JointLanes* lanes) const
+	{
+		b2StoreW(lanes->vAx, vAx);
+		b2StoreW(lanes->vAy, vAy);
+		b2StoreW(lanes->wA, wA);
+		b2StoreW(lanes->vBx, vBx);
+		b2StoreW(lanes->vBy, vBy);
+		b2StoreW(lanes->wB, wB);
+	}
+
+	// Relative velocity of the anchors: vB + cross(wB, rB) - vA - cross(wA, rA).
+	void RelativeVelocity(b2FloatW* dvx, b2FloatW* dvy,
+		b2FloatW rAx, b2FloatW rAy, b2FloatW rBx, b2FloatW rBy) const
+	{
+		*dvx = b2AddW(b2SubW(b2SubW(vBx, b2MulW(wB, rBy)), vAx), b2MulW(wA, rAy));
+		*dvy = b2SubW(b2SubW(b2AddW(vBy, b2MulW(wB, rBx)), vAy), b2MulW(wA, rAx));
+	}
+
+	// Apply the impulse P at the anchors.
+	void ApplyImpulse(b2FloatW Px, b2FloatW Py, b2FloatW rAx, b2FloatW rAy, b2FloatW rBx, b2FloatW rBy,
+		b2FloatW mA, b2FloatW mB, b2FloatW iA, b2FloatW iB)
+	{
+		vAx = b2SubW(vAx, b2MulW(mA, Px));
+		vAy = b2SubW(vAy, b2MulW(mA, Py));
+		wA = b2SubW(wA, b2MulW(iA, b2SubW(b2MulW(rAx, Py), b2MulW(rAy, Px))));
+		vBx = b2AddW(vBx, b2MulW(mB, Px));
+		vBy = b2AddW(vBy, b2MulW(mB, Py));
+		wB = b2AddW(wB, b2MulW(iB, b2SubW(b2MulW(rBx, Py), b2MulW(rBy, Px))));
+	}
+
+	b2FloatW vAx, vAy, wA;
+	b2FloatW vBx, vBy, wB;
+};
+
+// Same math as b2DistanceJoint::SolveVelocityConstraints, one joint per lane.
+// The operations are done in the same order, so the result matches the scalar
+// solver exactly.
+static void b2SolveDistanceBatch(b2JointBatch* batch, b2Velocity* velocities)
+{
+	b2JointLanes lanes;
+	b2JointLanesW v;
+
+	for (int32 base = 0; base < batch->count; base += b2_jointBatchWidth)
+	{
+		b2GatherLanes(&lanes, batch, base, velocities);
+		v.Load(lanes);
+
+		b2FloatW rAx = b2LoadW(batch->rAx + base);
+		b2FloatW rAy = b2LoadW(batch->rAy + base);
+		b2FloatW rBx = b2LoadW(batch->rBx + base);
+		b2FloatW rBy = b2LoadW(batch->rBy + base);
+		b2FloatW ux = b2LoadW(batch->a1 + base);
+		b2FloatW uy = b2LoadW(batch->a2 + base);
+		b2FloatW mass = b2LoadW(batch->a3 + base);
+		b2FloatW bias = b2LoadW(batch->a4 + base);
+		b2FloatW gamma = b2LoadW(batch->a5 + base);
+		b2FloatW accumulated = b2LoadW(batch->impulse1 + base);
+
+		// Cdot = dot(u, v + cross(w, r))
+		b2FloatW dvx, dvy;
+		v.RelativeVelocity(&dvx, &dvy, rAx, rAy, rBx, rBy);
+		b2FloatW Cdot = b2AddW(b2MulW(ux, dvx), b2MulW(uy, dvy));
+
+		b2FloatW impulse = b2MulW(b2NegW(mass), b2AddW(b2AddW(Cdot, bias), b2MulW(gamma, accumulated)));
+		b2StoreW(batch->impulse1 + base, b2AddW(accumulated, impulse));
+
+		b2FloatW Px = b2MulW(impulse, ux);
+		b2FloatW Py = b2MulW(impulse, uy);
+
+		v.ApplyImpulse(Px, Py, rAx, rAy, rBx, rBy,
+			b2LoadW(batch->invMassA + base), b2LoadW(batch->invMassB + base),
+			b2LoadW(batch->invIA + base), b2LoadW(batch->invIB + base));
+
+		v.Store(&lanes);
+		b2ScatterLanes(&lanes, batch, base, velocities);
+	}
+}
+
+// Point-to-point part of b2RevoluteJoint::SolveVelocityConstraints, one joint per lane.
+static void b2SolveRevoluteBatch(b2JointBatch* batch, b2Velocity* velocities)
+{
+	b2JointLanes lanes;
+	b2JointLanesW v;
+
+	for (int32 base = 0; base < batch->count; base += b2_jointBatchWidth)
+	{
+		b2GatherLanes(&lanes, batch, base, velocities);
+		v.Load(lanes);
+
+		b2FloatW rAx = b2LoadW(batch->rAx + base);
+		b2FloatW rAy = b2LoadW(batch->rAy + base);
+		b2FloatW rBx = b2LoadW(batch->rBx + base);
+		b2FloatW rBy = b2LoadW(batch->rBy + base);
+		b2FloatW k11 = b2LoadW(batch->a1 + base);
+		b2FloatW k12 = b2LoadW(batch->a2 + base);
+		b2FloatW k21 = b2LoadW(batch->a3 + base);
+		b2FloatW k22 = b2LoadW(batch->a4 + base);
+
+		b2FloatW Cdotx, Cdoty;
+		v.RelativeVelocity(&Cdotx, &Cdoty, rAx, rAy, rBx, rBy);
+
+		b2FloatW Px = b2NegW(b2AddW(b2MulW(k11, Cdotx), b2MulW(k12, Cdoty)));
+		b2FloatW Py = b2NegW(b2AddW(b2MulW(k21, Cdotx), b2MulW(k22, Cdoty)));
+
+		b2StoreW(batch->impulse1 + base, b2AddW(b2LoadW(batch->impulse1 + base), Px));
+		b2StoreW(batch->impulse2 + base, b2AddW(b2LoadW(batch->impulse2 + base), Py));
+
+		v.ApplyImpulse(Px, Py, rAx, rAy, rBx, rBy,
+			b2LoadW(batch->invMassA + base), b2LoadW(batch->invMassB + base),
+			b2LoadW(batch->invIA + base), b2LoadW(batch->invIB + base));
+
+		v.Store(&lanes);
+		b2ScatterLanes(&lanes, batch, base, velocities);
+	}
+}
+
+b2JointSolver::b2JointSolver(b2Joint** joints, int32 count, int32 bodyCount, b2StackAllocator* allocator)
+{
+	m_allocator = allocator;
+	m_count = count;
+	m_scalarCount = 0;
+	m_bodyCount = bodyCount;
+	m_distanceBatch.joints = NULL;
+	m_distanceBatch.count = 0;
+	m_revoluteBatch.joints = NULL;
+	m_revoluteBatch.count = 0;
+	m_joints = NULL;
+	m_scalarJoints = NULL;
+	m_articulated = NULL;
+
+	if (count == 0)
+	{
+		return;
+	}
+
+	m_joints = (b2Joint**)m_allocator->Allocate(2 * count * sizeof(b2Joint*) + count * sizeof(bool));
+	m_scalarJoints = m_joints + count;
+	m_articulated = (bool*)(m_scalarJoints + count);
+
+	// Counting sort by type keeps each type's code and data hot.
+	int32 offsets[b2_jointTypeCount + 1];
+	memset(offsets, 0, sizeof(offsets));
+	for (int32 i = 0; i < count; ++i)
+	{
+		++offsets[joints[i]->GetType() + 1];
+	}
+
+	for (int32 i = 0; i < b2_jointTypeCount; ++i)
+	{
+		offsets[i + 1] += offsets[i];
+	}
+
+	for (int32 i = 0; i < count; ++i)
+	{
+		m_joints[offsets[joints[i]->GetType()]++] = joints[i];
+	}
+}
+
+b2JointSolver::~b2JointSolver()
+{
+	b2FreeBatch(&m_revoluteBatch, m_allocator);
+	b2FreeBatch(&m_distanceBatch, m_allocator);
+	m_articulation.Destroy();
+
+	if (m_joints)
+	{
+		m_allocator->Free(m_joints);
+	}
+}
+
+void b2JointSolver::InitVelocityConstraints(const b2SolverData& data)
+{
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		b2Joint* joint = m_joints[i];
+		switch (joint->GetType())
+		{
+		case e_distanceJoint:
+			((b2DistanceJoint*)joint)->b2DistanceJoint::InitVelocityConstraints(data);
+			break;
+
+		case e_revoluteJoint:
+			((b2RevoluteJoint*)joint)->b2RevoluteJoint::InitVelocityConstraints(data);
+			break;
+
+		default:
+			joint->InitVelocityConstraints(data);
+			break;
+		}
+	}
+
+	if (m_count == 0)
+	{
+		return;
+	}
+
+	// The direct solver takes the tree joints first, the rest are iterative.
+	if (data.step.directJoints)
+	{
+		m_articulation.Initialize(m_joints, m_count, m_bodyCount, m_articulated, m_allocator);
+		m_articulation.InitVelocityConstraints(data);
+	}
+	else
+	{
+		memset(m_articulated, 0, m_count * sizeof(bool));
+	}
+
+	int32 distanceCount = 0;
+	int32 revoluteCount = 0;
+	m_scalarCount = 0;
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		b2Joint* joint = m_joints[i];
+		if (m_articulated[i])
+		{
+			continue;
+		}
+
+		if (IsBatched(joint) == false)
+		{
+			m_scalarJoints[m_scalarCount++] = joint;
+		}
+		else if (joint->GetType() == e_distanceJoint)
+		{
+			++distanceCount;
+		}
+		else
+		{
+			++revoluteCount;
+		}
+	}
+
+	if (distanceCount + revoluteCount == 0)
+	{
+		return;
+	}
+
+	b2AllocateBatch(&m_distanceBatch, distanceCount, m_allocator);
+	b2AllocateBatch(&m_revoluteBatch, revoluteCount, m_allocator);
+
+	uint32* bodyMasks = (uint32*)m_allocator->Allocate(m_bodyCount * sizeof(uint32) + m_count * sizeof(int32));
+	int32* colors = (int32*)(bodyMasks + m_bodyCount);
+
+	BuildBatch(&m_revoluteBatch, e_revoluteJoint, bodyMasks, colors);
+	BuildBatch(&m_distanceBatch, e_distanceJoint, bodyMasks, colors);
+
+	m_allocator->Free(bodyMasks);
+}
+
+void b2JointSolver::SolveVelocityConstraints(const b2SolverData& data)
+{
+	b2SolveRevoluteBatch(&m_revoluteBatch, data.velocities);
+	b2SolveDistanceBatch(&m_distanceBatch, data.velocities);
+
+	for (int32 i = 0; i < m_scalarCount; ++i)
+	{
+		b2Joint* joint = m_scalarJoints[i];
+		if (joint->GetType() == e_revoluteJoint)
+		{
+			((b2RevoluteJoint*)joint)->b2RevoluteJoint::SolveVelocityConstraints(data);
+		}
+		else
+		{
+			joint->SolveVelocityConstraints(data);
+		}
+	}
+
+	if (m_articulation.GetJointCount() > 0)
+	{
+		m_articulation.SolveVelocityConstraints(data);
+	}
+}
+
+void b2JointSolver::StoreImpulses()
+{
+	for (int32 i = 0; i < m_revoluteBatch.count; ++i)
+	{
+		b2RevoluteJoint* joint = (b2RevoluteJoint*)m_revoluteBatch.joints[i];
+		if (joint)
+		{
+			joint->m_impulse.x = m_revoluteBatch.impulse1[i];
+			joint->m_impulse.y = m_revoluteBatch.impulse2[i];
+		}
+	}
+
+	for (int32 i = 0; i < m_distanceBatch.count; ++i)
+	{
+		b2DistanceJoint* joint = (b2DistanceJoint*)m_distanceBatch.joints[i];
+		if (joint)
+		{
+			joint->m_impulse = m_distanceBatch.impulse1[i];
+		}
+	}
+}
+
+bool b2JointSolver::SolvePositionConstraints(const b2SolverData& data)
+{
+	bool jointsOkay = true;
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		b2Joint* joint = m_joints[i];
+		if (m_articulated[i])
+		{
+			continue;
+		}
+
+		bool jointOkay;
+		switch (joint->GetType())
+		{
+		case e_distanceJoint:
+			jointOkay = ((b2DistanceJoint*)joint)->b2DistanceJoint::SolvePositionConstraints(data);
+			break;
+
+		case e_revoluteJoint:
+			jointOkay = ((b2RevoluteJoint*)joint)->b2RevoluteJoint::SolvePositionConstraints(data);
+			break;
+
+		default:
+			jointOkay = joint->SolvePositionConstraints(data);
+			break;
+		}
+
+		jointsOkay = jointsOkay && jointOkay;
+	}
+
+	if (m_articulation.GetJointCount() > 0)
+	{
+		bool articulationOkay = m_articulation.SolvePositionConstraints(data);
+		jointsOkay = jointsOkay && articulationOkay;
+	}
+
+	return jointsOkay;
+}
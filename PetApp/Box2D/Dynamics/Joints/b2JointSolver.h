@@ -0,0 +1,103 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#ifndef B2_JOINT_SOLVER_H
+#define B2_JOINT_SOLVER_H
+
+#include <Box2D/Common/b2Math.h>
+#include <Box2D/Dynamics/b2TimeStep.h>
+#include <Box2D/Dynamics/Joints/b2Joint.h>
+#include <Box2D/Dynamics/Joints/b2ArticulationSolver.h>
+
+class b2StackAllocator;
+
+/// Colors are tracked with one bit per color in a uint32 body mask.
+#define b2_maxJointColors	32
+
+/// Joint velocity constraints stored as structure-of-arrays. The joints are
+/// grouped by color so that no two joints of a color touch the same dynamic
+/// body. Each color is padded to a multiple of b2_jointBatchWidth with
+/// empty lanes (joint == NULL, zero mass).
+struct b2JointBatch
+{
+	b2Joint** joints;
+	int32* indexA;
+	int32* indexB;
+	float32* rAx;
+	float32* rAy;
+	float32* rBx;
+	float32* rBy;
+	float32* invMassA;
+	float32* invMassB;
+	float32* invIA;
+	float32* invIB;
+
+	// Distance joint: axis (a1, a2), mass, bias, gamma and impulse1.
+	// Revolute joint: inverse point mass (a1, a2, a3, a4) and impulse1/2.
+	float32* a1;
+	float32* a2;
+	float32* a3;
+	float32* a4;
+	float32* a5;
+	float32* impulse1;
+	float32* impulse2;
+
+	int32 count;
+	int32 capacity;
+	int32 colorCount;
+	int32 colorOffsets[b2_maxJointColors + 1];
+};
+
+/// Solves the joints of an island. Joints are sorted by type. With the direct
+/// solver enabled, tree-structured revolute and weld joints go to the
+/// articulation solver. Distance joints and unrestricted revolute joints are
+/// solved in colored batches and the remaining joints go through the virtual
+/// interface.
+class b2JointSolver
+{
+public:
+	b2JointSolver(b2Joint** joints, int32 count, int32 bodyCount, b2StackAllocator* allocator);
+	~b2JointSolver();
+
+	void InitVelocityConstraints(const b2SolverData& data);
+	void SolveVelocityConstraints(const b2SolverData& data);
+	void StoreImpulses();
+
+	bool SolvePositionConstraints(const b2SolverData& data);
+
+	b2StackAllocator* m_allocator;
+	b2Joint** m_joints;
+	b2Joint** m_scalarJoints;
+	bool* m_articulated;
+	b2ArticulationSolver m_articulation;
+	b2JointBatch m_distanceBatch;
+	b2JointBatch m_revoluteBatch;
+	int32 m_count;
+	int32 m_scalarCount;
+	int32 m_bodyCount;
+
+private:
+	void BuildBatch(b2JointBatch* batch, b2JointType type, uint32* bodyMasks, int32* colors);
+
+	static bool IsBatched(b2Joint* joint);
+	static void GetDynamicBodies(b2Joint* joint, int32* indexA, int32* indexB);
+	static void SetLane(b2JointBatch* batch, int32 lane, b2Joint* joint);
+};
+
+#endif
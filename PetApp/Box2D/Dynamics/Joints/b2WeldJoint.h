@@ -91,6 +91,7 @@ public:
 protected:
 
 	friend class b2Joint;
+	friend class b2ArticulationSolver;
 
 	b2WeldJoint(const b2WeldJointDef* def);
 
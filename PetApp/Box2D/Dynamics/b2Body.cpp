@@ -30,6 +30,7 @@ b2Body::b2Body(const b2BodyDef* bd, b2World* world)
 	b2Assert(b2IsValid(bd->angularVelocity));
 	b2Assert(b2IsValid(bd->angularDamping) && bd->angularDamping >= 0.0f);
 	b2Assert(b2IsValid(bd->linearDamping) && bd->linearDamping >= 0.0f);
+	b2Assert(0 <= bd->rateLevel && bd->rateLevel <= b2_maxRateLevel);
 
 	m_flags = 0;
 
@@ -66,6 +67,8 @@ b2Body::b2Body(const b2BodyDef* bd, b2World* world)
 	m_sweep.a = bd->angle;
 	m_sweep.alpha0 = 0.0f;
 
+	m_stateIndex = -1;
+
 	m_jointList = NULL;
 	m_contactList = NULL;
 	m_prev = NULL;
@@ -83,6 +86,13 @@ b2Body::b2Body(const b2BodyDef* bd, b2World* world)
 
 	m_sleepTime = 0.0f;
 
+	m_rateLevel = b2Clamp(bd->rateLevel, 0, b2_maxRateLevel);
+	m_lodSteps = 1;
+	m_lodStep = 0;
+	m_flags |= e_lodResetFlag;
+	m_lodCenter0 = m_sweep.c;
+	m_lodAngle0 = m_sweep.a;
+
 	m_type = bd->type;
 
 	if (m_type == b2_dynamicBody)
@@ -123,6 +133,16 @@ void b2Body::SetType(b2BodyType type)
 		return;
 	}
 
+	// Chains with an edge tree do not update their edges, so they must stay static.
+	for (b2Fixture* f = m_fixtureList; f; f = f->m_next)
+	{
+		b2Assert(f->m_meshProxy == false || type == b2_staticBody);
+		if (f->m_meshProxy && type != b2_staticBody)
+		{
+			return;
+		}
+	}
+
 	m_type = type;
 
 	ResetMassData();
@@ -136,6 +156,7 @@ void b2Body::SetType(b2BodyType type)
 		SynchronizeFixtures();
 	}
 
+	m_flags |= e_lodResetFlag;
 	SetAwake(true);
 
 	m_force.SetZero();
@@ -150,6 +171,7 @@ void b2Body::SetType(b2BodyType type)
 		m_world->m_contactManager.Destroy(ce0->contact);
 	}
 	m_contactList = NULL;
+	m_world->m_contactManager.DestroySensorPairs(this, NULL);
 
 	// Touch the proxies so that new contacts will be created (when appropriate)
 	b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
@@ -258,6 +280,8 @@ void b2Body::DestroyFixture(b2Fixture* fixture)
 		}
 	}
 
+	m_world->m_contactManager.DestroySensorPairs(this, fixture);
+
 	b2BlockAllocator* allocator = &m_world->m_blockAllocator;
 
 	if (m_flags & e_activeFlag)
@@ -431,6 +455,10 @@ void b2Body::SetTransform(const b2Vec2& position, float32 angle)
 	m_sweep.c0 = m_sweep.c;
 	m_sweep.a0 = angle;
 
+	// Don't interpolate from the old transform.
+	m_lodCenter0 = m_sweep.c;
+	m_lodAngle0 = angle;
+
 	b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
 	for (b2Fixture* f = m_fixtureList; f; f = f->m_next)
 	{
@@ -438,6 +466,39 @@ void b2Body::SetTransform(const b2Vec2& position, float32 angle)
 	}
 }
 
+b2Transform b2Body::GetInterpolatedTransform() const
+{
+	if (m_lodSteps <= 1 || m_world->m_multiRate == false)
+	{
+		return m_xf;
+	}
+
+	int32 count = m_lodSteps;
+	int32 elapsed = m_world->m_rateStep - m_lodStep;
+	if (elapsed >= count)
+	{
+		return m_xf;
+	}
+
+	b2Sweep sweep = m_sweep;
+	sweep.c0 = m_lodCenter0;
+	sweep.a0 = m_lodAngle0;
+
+	b2Transform xf;
+	sweep.GetTransform(&xf, float32(elapsed) / float32(count));
+	return xf;
+}
+
+b2Vec2d b2Body::GetGlobalPosition() const
+{
+	return m_world->GetGlobalPoint(m_xf.p);
+}
+
+void b2Body::SetGlobalTransform(const b2Vec2d& position, float32 angle)
+{
+	SetTransform(m_world->GetLocalPoint(position), angle);
+}
+
 void b2Body::SynchronizeFixtures()
 {
 	b2Transform xf1;
@@ -462,7 +523,7 @@ void b2Body::SetActive(bool flag)
 
 	if (flag)
 	{
-		m_flags |= e_activeFlag;
+		m_flags |= e_activeFlag | e_lodResetFlag;
 
 		// Create all proxies.
 		b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
@@ -493,6 +554,7 @@ void b2Body::SetActive(bool flag)
 			m_world->m_contactManager.Destroy(ce0->contact);
 		}
 		m_contactList = NULL;
+		m_world->m_contactManager.DestroySensorPairs(this, NULL);
 	}
 }
 
@@ -537,6 +599,7 @@ void b2Body::Dump()
 	b2Log("  bd.bullet = bool(%d);\n", m_flags & e_bulletFlag);
 	b2Log("  bd.active = bool(%d);\n", m_flags & e_activeFlag);
 	b2Log("  bd.gravityScale = %.15lef;\n", m_gravityScale);
+	b2Log("  bd.rateLevel = %d;\n", m_rateLevel);
 	b2Log("  bodies[%d] = m_world->CreateBody(&bd);\n", m_islandIndex);
 	b2Log("\n");
 	for (b2Fixture* f = m_fixtureList; f; f = f->m_next)
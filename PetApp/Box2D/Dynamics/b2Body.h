@@ -67,6 +67,7 @@ struct b2BodyDef
 		type = b2_staticBody;
 		active = true;
 		gravityScale = 1.0f;
+		rateLevel = 0;
 	}
 
 	/// The body type: static, kinematic, or dynamic.
@@ -120,6 +121,10 @@ struct b2BodyDef
 
 	/// Scale the gravity applied to this body.
 	float32 gravityScale;
+
+	/// The multi-rate stepping level, in [0, b2_maxRateLevel].
+	/// @see b2Body::SetRateLevel
+	int32 rateLevel;
 };
 
 /// A rigid body. These are created via b2World::CreateBody.
@@ -168,6 +173,14 @@ public:
 	/// @return the world position of the body's origin.
 	const b2Vec2& GetPosition() const;
 
+	/// Get the world body origin position in double precision, including the world origin.
+	/// Use this for large worlds that shift their origin.
+	b2Vec2d GetGlobalPosition() const;
+
+	/// Set the position of the body's origin from a double precision position, including
+	/// the world origin. See SetTransform.
+	void SetGlobalTransform(const b2Vec2d& position, float32 angle);
+
 	/// Get the angle in radians.
 	/// @return the current world rotation angle in radians.
 	float32 GetAngle() const;
@@ -318,6 +331,21 @@ public:
 	/// Is this body allowed to sleep
 	bool IsSleepingAllowed() const;
 
+	/// Set how often this body is solved when multi-rate stepping is enabled. At level n
+	/// the body is solved every 2^n steps with a 2^n times larger time step. A body that
+	/// touches or is jointed to a faster body is solved at the faster rate.
+	/// @param level the rate level in [0, b2_maxRateLevel].
+	/// @see b2World::SetMultiRate
+	void SetRateLevel(int32 level);
+
+	/// Get the multi-rate stepping level.
+	int32 GetRateLevel() const;
+
+	/// Get the body transform for drawing. With multi-rate stepping a slow body jumps
+	/// ahead when it is solved. This interpolates the transform over the steps until the
+	/// next solve. Otherwise this is the same as GetTransform.
+	b2Transform GetInterpolatedTransform() const;
+
 	/// Set the sleep state of the body. A sleeping body has very
 	/// low CPU cost.
 	/// @param flag set to true to wake the body, false to put it to sleep.
@@ -363,6 +391,8 @@ public:
 	/// Get the list of all contacts attached to this body.
 	/// @warning this list changes during the time step and you may
 	/// miss some collisions if you don't use b2ContactListener.
+	/// @warning with contact recycling enabled this list also holds pooled
+	/// contacts whose AABBs no longer overlap. Skip them with b2Contact::IsPooled.
 	b2ContactEdge* GetContactList();
 	const b2ContactEdge* GetContactList() const;
 
@@ -390,6 +420,8 @@ private:
 	friend class b2ContactManager;
 	friend class b2ContactSolver;
 	friend class b2Contact;
+	friend class b2StepThread;
+	friend class b2WorldStreamer;
 	
 	friend class b2DistanceJoint;
 	friend class b2FrictionJoint;
@@ -412,7 +444,8 @@ private:
 		e_bulletFlag		= 0x0008,
 		e_fixedRotationFlag	= 0x0010,
 		e_activeFlag		= 0x0020,
-		e_toiFlag			= 0x0040
+		e_toiFlag			= 0x0040,
+		e_lodResetFlag		= 0x0080
 	};
 
 	b2Body(const b2BodyDef* bd, b2World* world);
@@ -433,6 +466,9 @@ private:
 
 	int32 m_islandIndex;
 
+	// Index into the transform buffers of asynchronous stepping.
+	int32 m_stateIndex;
+
 	b2Transform m_xf;		// the body origin transform
 	b2Sweep m_sweep;		// the swept motion for CCD
 
@@ -463,6 +499,15 @@ private:
 
 	float32 m_sleepTime;
 
+	// Multi-rate stepping. The lod fields describe the last island solve:
+	// the number of steps it covered, the world rate step and the center and
+	// angle before it. e_lodResetFlag restarts the count after a wake up.
+	int32 m_rateLevel;
+	int32 m_lodSteps;
+	int32 m_lodStep;
+	b2Vec2 m_lodCenter0;
+	float32 m_lodAngle0;
+
 	void* m_userData;
 };
 
@@ -636,7 +681,7 @@ inline void b2Body::SetAwake(bool flag)
 	{
 		if ((m_flags & e_awakeFlag) == 0)
 		{
-			m_flags |= e_awakeFlag;
+			m_flags |= e_awakeFlag | e_lodResetFlag;
 			m_sleepTime = 0.0f;
 		}
 	}
@@ -684,6 +729,17 @@ inline bool b2Body::IsSleepingAllowed() const
 	return (m_flags & e_autoSleepFlag) == e_autoSleepFlag;
 }
 
+inline void b2Body::SetRateLevel(int32 level)
+{
+	b2Assert(0 <= level && level <= b2_maxRateLevel);
+	m_rateLevel = b2Clamp(level, 0, b2_maxRateLevel);
+}
+
+inline int32 b2Body::GetRateLevel() const
+{
+	return m_rateLevel;
+}
+
 inline b2Fixture* b2Body::GetFixtureList()
 {
 	return m_fixtureList;
@@ -21,6 +21,15 @@
 #include <Box2D/Dynamics/b2Fixture.h>
 #include <Box2D/Dynamics/b2WorldCallbacks.h>
 #include <Box2D/Dynamics/Contacts/b2Contact.h>
+#include <Box2D/Dynamics/Contacts/b2CircleContact.h>
+#include <Box2D/Dynamics/Contacts/b2PolygonAndCircleContact.h>
+#include <Box2D/Dynamics/Contacts/b2PolygonContact.h>
+#include <Box2D/Dynamics/Contacts/b2EdgeAndCircleContact.h>
+#include <Box2D/Dynamics/Contacts/b2EdgeAndPolygonContact.h>
+#include <Box2D/Dynamics/Contacts/b2ChainAndCircleContact.h>
+#include <Box2D/Dynamics/Contacts/b2ChainAndPolygonContact.h>
+#include <Box2D/Collision/Shapes/b2ChainShape.h>
+#include <memory.h>
 
 b2ContactFilter b2_defaultFilter;
 b2ContactListener b2_defaultListener;
@@ -29,9 +38,209 @@ b2ContactManager::b2ContactManager()
 {
 	m_contactList = NULL;
 	m_contactCount = 0;
+	m_groupContacts = NULL;
+	m_groupCapacity = 0;
+	m_falsePairCount = 0;
+	m_poolList = NULL;
+	m_poolCount = 0;
+	m_recycleSteps = 0;
+	m_collideCount = 0;
+	m_revivalCount = 0;
 	m_contactFilter = &b2_defaultFilter;
 	m_contactListener = &b2_defaultListener;
 	m_allocator = NULL;
+
+	m_sensorPass = false;
+	m_sensorPairList = NULL;
+	m_sensorPairCount = 0;
+
+	m_bufferEvents = false;
+	m_hitEventThreshold = b2_velocityThreshold;
+
+	m_beginEvents = NULL;
+	m_beginEventCount = 0;
+	m_beginEventCapacity = 0;
+
+	m_endEvents = NULL;
+	m_endEventCount = 0;
+	m_endEventCapacity = 0;
+	m_endEventMark = 0;
+
+	m_hitEvents = NULL;
+	m_hitEventCount = 0;
+	m_hitEventCapacity = 0;
+
+	m_sensorBeginEvents = NULL;
+	m_sensorBeginEventCount = 0;
+	m_sensorBeginEventCapacity = 0;
+
+	m_sensorEndEvents = NULL;
+	m_sensorEndEventCount = 0;
+	m_sensorEndEventCapacity = 0;
+	m_sensorEndEventMark = 0;
+}
+
+b2ContactManager::~b2ContactManager()
+{
+	b2Free(m_groupContacts);
+	b2Free(m_beginEvents);
+	b2Free(m_endEvents);
+	b2Free(m_hitEvents);
+	b2Free(m_sensorBeginEvents);
+	b2Free(m_sensorEndEvents);
+}
+
+// Append an element to a flat event array, doubling the capacity when full.
+template <typename T>
+static inline T* b2PushEvent(T*& events, int32& count, int32& capacity)
+{
+	if (count == capacity)
+	{
+		T* oldEvents = events;
+		capacity = capacity > 0 ? 2 * capacity : 16;
+		events = (T*)b2Alloc(capacity * sizeof(T));
+		if (oldEvents)
+		{
+			memcpy(events, oldEvents, count * sizeof(T));
+			b2Free(oldEvents);
+		}
+	}
+
+	return events + count++;
+}
+
+// Compute a representative point and normal for a touching contact, and the
+// speed at which the fixtures approach along the normal at that point.
+static void b2GetContactPoint(b2Contact* c, b2Vec2* point, b2Vec2* normal, float32* approachSpeed)
+{
+	const b2Manifold* manifold = c->GetManifold();
+	if (manifold->pointCount == 0)
+	{
+		point->SetZero();
+		normal->SetZero();
+		*approachSpeed = 0.0f;
+		return;
+	}
+
+	b2Body* bodyA = c->GetFixtureA()->GetBody();
+	b2Body* bodyB = c->GetFixtureB()->GetBody();
+
+	b2WorldManifold worldManifold;
+	worldManifold.Initialize(manifold, bodyA->GetTransform(), c->GetFixtureA()->GetShape()->m_radius,
+		bodyB->GetTransform(), c->GetFixtureB()->GetShape()->m_radius);
+
+	b2Vec2 p = worldManifold.points[0];
+	if (manifold->pointCount == 2)
+	{
+		p = 0.5f * (worldManifold.points[0] + worldManifold.points[1]);
+	}
+
+	b2Vec2 vA = bodyA->GetLinearVelocityFromWorldPoint(p);
+	b2Vec2 vB = bodyB->GetLinearVelocityFromWorldPoint(p);
+
+	*point = p;
+	*normal = worldManifold.normal;
+	*approachSpeed = -b2Dot(vB - vA, worldManifold.normal);
+}
+
+void b2ContactManager::Reset()
+{
+	m_broadPhase.Reset();
+
+	m_contactList = NULL;
+	m_contactCount = 0;
+	m_poolList = NULL;
+	m_poolCount = 0;
+	m_sensorPairList = NULL;
+	m_sensorPairCount = 0;
+
+	m_falsePairCount = 0;
+	m_collideCount = 0;
+	m_revivalCount = 0;
+
+	ClearEvents();
+}
+
+void b2ContactManager::ClearEvents()
+{
+	m_beginEventCount = 0;
+	m_endEventCount = 0;
+	m_hitEventCount = 0;
+	m_sensorBeginEventCount = 0;
+	m_sensorEndEventCount = 0;
+	m_endEventMark = 0;
+	m_sensorEndEventMark = 0;
+}
+
+// Drop the first mark events and keep the rest.
+template <typename T>
+static inline void b2DropEvents(T* events, int32& count, int32 mark)
+{
+	b2Assert(0 <= mark && mark <= count);
+	memmove(events, events + mark, (count - mark) * sizeof(T));
+	count -= mark;
+}
+
+void b2ContactManager::ClearStepEvents()
+{
+	// Only end events can be recorded outside of a step.
+	m_beginEventCount = 0;
+	m_hitEventCount = 0;
+	m_sensorBeginEventCount = 0;
+
+	b2DropEvents(m_endEvents, m_endEventCount, m_endEventMark);
+	b2DropEvents(m_sensorEndEvents, m_sensorEndEventCount, m_sensorEndEventMark);
+	m_endEventMark = 0;
+	m_sensorEndEventMark = 0;
+}
+
+void b2ContactManager::MarkStepEvents()
+{
+	m_endEventMark = m_endEventCount;
+	m_sensorEndEventMark = m_sensorEndEventCount;
+}
+
+void b2ContactManager::AddBeginEvent(b2Contact* c)
+{
+	b2ContactBeginEvent* e = b2PushEvent(m_beginEvents, m_beginEventCount, m_beginEventCapacity);
+	e->fixtureA = c->GetFixtureA();
+	e->fixtureB = c->GetFixtureB();
+	b2GetContactPoint(c, &e->point, &e->normal, &e->approachSpeed);
+}
+
+// The fixtures may be destroyed before the event is read, so copy the user data.
+void b2ContactManager::AddEndEvent(b2Contact* c)
+{
+	b2ContactEndEvent* e = b2PushEvent(m_endEvents, m_endEventCount, m_endEventCapacity);
+	e->fixtureA = c->GetFixtureA();
+	e->fixtureB = c->GetFixtureB();
+	e->fixtureUserDataA = e->fixtureA->GetUserData();
+	e->fixtureUserDataB = e->fixtureB->GetUserData();
+	e->bodyUserDataA = e->fixtureA->GetBody()->GetUserData();
+	e->bodyUserDataB = e->fixtureB->GetBody()->GetUserData();
+}
+
+static void b2SetSensorEvent(b2SensorEvent* e, b2Fixture* sensor, b2Fixture* visitor)
+{
+	e->sensor = sensor;
+	e->visitor = visitor;
+	e->sensorUserData = sensor->GetUserData();
+	e->visitorUserData = visitor->GetUserData();
+	e->sensorBodyUserData = sensor->GetBody()->GetUserData();
+	e->visitorBodyUserData = visitor->GetBody()->GetUserData();
+}
+
+void b2ContactManager::AddHitEvent(b2Contact* c, float32 approachSpeed, float32 maxImpulse)
+{
+	b2ContactHitEvent* e = b2PushEvent(m_hitEvents, m_hitEventCount, m_hitEventCapacity);
+	e->fixtureA = c->GetFixtureA();
+	e->fixtureB = c->GetFixtureB();
+
+	// The solver supplies the approach speed from before the impulses were applied.
+	float32 speed;
+	b2GetContactPoint(c, &e->point, &e->normal, &speed);
+	e->approachSpeed = approachSpeed;
+	e->maxImpulse = maxImpulse;
 }
 
 void b2ContactManager::Destroy(b2Contact* c)
@@ -41,12 +250,22 @@ void b2ContactManager::Destroy(b2Contact* c)
 	b2Body* bodyA = fixtureA->GetBody();
 	b2Body* bodyB = fixtureB->GetBody();
 
-	if (m_contactListener && c->IsTouching())
+	if (c->IsTouching())
 	{
-		m_contactListener->EndContact(c);
+		if (m_bufferEvents)
+		{
+			AddEndEvent(c);
+		}
+		else if (m_contactListener)
+		{
+			m_contactListener->EndContact(c);
+		}
 	}
 
-	// Remove from the world.
+	// Remove from the world or the recycle pool.
+	bool pooled = (c->m_flags & b2Contact::e_pooledFlag) != 0;
+	b2Contact*& list = pooled ? m_poolList : m_contactList;
+
 	if (c->m_prev)
 	{
 		c->m_prev->m_next = c->m_next;
@@ -57,9 +276,9 @@ void b2ContactManager::Destroy(b2Contact* c)
 		c->m_next->m_prev = c->m_prev;
 	}
 
-	if (c == m_contactList)
+	if (c == list)
 	{
-		m_contactList = c->m_next;
+		list = c->m_next;
 	}
 
 	// Remove from body 1
@@ -96,7 +315,118 @@ void b2ContactManager::Destroy(b2Contact* c)
 
 	// Call the factory.
 	b2Contact::Destroy(c, m_allocator);
+
+	if (pooled)
+	{
+		--m_poolCount;
+	}
+	else
+	{
+		--m_contactCount;
+	}
+}
+
+void b2ContactManager::Recycle(b2Contact* c)
+{
+	b2Assert((c->m_flags & b2Contact::e_pooledFlag) == 0);
+
+	if (c->IsTouching())
+	{
+		if (m_bufferEvents)
+		{
+			AddEndEvent(c);
+		}
+		else if (m_contactListener)
+		{
+			m_contactListener->EndContact(c);
+		}
+	}
+
+	// Remove from the world.
+	if (c->m_prev)
+	{
+		c->m_prev->m_next = c->m_next;
+	}
+
+	if (c->m_next)
+	{
+		c->m_next->m_prev = c->m_prev;
+	}
+
+	if (c == m_contactList)
+	{
+		m_contactList = c->m_next;
+	}
+
+	// Insert into the pool. The body contact edges are kept. The manifold keeps
+	// the accumulated impulses for warm starting.
+	c->m_flags &= ~(b2Contact::e_touchingFlag | b2Contact::e_islandFlag | b2Contact::e_toiFlag | b2Contact::e_bulletHitFlag);
+	c->m_flags |= b2Contact::e_pooledFlag;
+	c->m_poolStep = m_collideCount;
+
+	c->m_prev = NULL;
+	c->m_next = m_poolList;
+	if (m_poolList != NULL)
+	{
+		m_poolList->m_prev = c;
+	}
+	m_poolList = c;
+
 	--m_contactCount;
+	++m_poolCount;
+}
+
+void b2ContactManager::Revive(b2Contact* c)
+{
+	b2Assert(c->m_flags & b2Contact::e_pooledFlag);
+
+	// Remove from the pool.
+	if (c->m_prev)
+	{
+		c->m_prev->m_next = c->m_next;
+	}
+
+	if (c->m_next)
+	{
+		c->m_next->m_prev = c->m_prev;
+	}
+
+	if (c == m_poolList)
+	{
+		m_poolList = c->m_next;
+	}
+
+	// Insert into the world.
+	c->m_prev = NULL;
+	c->m_next = m_contactList;
+	if (m_contactList != NULL)
+	{
+		m_contactList->m_prev = c;
+	}
+	m_contactList = c;
+
+	// Reset the state a new contact would have, except for the manifold.
+	c->m_flags &= ~b2Contact::e_pooledFlag;
+	c->m_flags |= b2Contact::e_enabledFlag;
+	c->m_toiCount = 0;
+	c->ResetFriction();
+	c->ResetRestitution();
+	c->m_tangentSpeed = 0.0f;
+
+	c->m_fixtureA->GetBody()->SetAwake(true);
+	c->m_fixtureB->GetBody()->SetAwake(true);
+
+	--m_poolCount;
+	++m_contactCount;
+	++m_revivalCount;
+}
+
+void b2ContactManager::FlushPool()
+{
+	while (m_poolList)
+	{
+		Destroy(m_poolList);
+	}
 }
 
 // This is the top level collision call for the time step. Here
@@ -104,6 +434,32 @@ void b2ContactManager::Destroy(b2Contact* c)
 // contact list.
 void b2ContactManager::Collide()
 {
+	++m_collideCount;
+
+	// Destroy the pooled contacts that were not revived in time.
+	b2Contact* p = m_poolList;
+	while (p)
+	{
+		b2Contact* pNuke = p;
+		p = pNuke->GetNext();
+		if (m_collideCount - pNuke->m_poolStep > m_recycleSteps)
+		{
+			Destroy(pNuke);
+		}
+	}
+
+	// The contacts that persist are grouped by pair type and updated after the walk.
+	if (m_groupCapacity < 2 * m_contactCount)
+	{
+		b2Free(m_groupContacts);
+		m_groupCapacity = b2Max(2 * m_groupCapacity, 2 * m_contactCount);
+		m_groupContacts = (b2Contact**)b2Alloc(m_groupCapacity * sizeof(b2Contact*));
+	}
+
+	b2Contact** contacts = m_groupContacts;
+	int32 count = 0;
+	int32 groupCounts[b2Contact::e_pairTypeCount] = {0};
+
 	// Update awake contacts.
 	b2Contact* c = m_contactList;
 	while (c)
@@ -118,6 +474,15 @@ void b2ContactManager::Collide()
 		// Is this contact flagged for filtering?
 		if (c->m_flags & b2Contact::e_filterFlag)
 		{
+			// Has one of the fixtures become a sensor of the sensor pass?
+			if (m_sensorPass && (fixtureA->IsSensor() || fixtureB->IsSensor()))
+			{
+				b2Contact* cNuke = c;
+				c = cNuke->GetNext();
+				Destroy(cNuke);
+				continue;
+			}
+
 			// Should these bodies collide?
 			if (bodyB->ShouldCollide(bodyA) == false)
 			{
@@ -150,23 +515,102 @@ void b2ContactManager::Collide()
 			continue;
 		}
 
-		int32 proxyIdA = fixtureA->m_proxies[indexA].proxyId;
-		int32 proxyIdB = fixtureB->m_proxies[indexB].proxyId;
-		bool overlap = m_broadPhase.TestOverlap(proxyIdA, proxyIdB);
+		bool overlap = TestOverlap(fixtureA, indexA, fixtureB, indexB);
 
 		// Here we destroy contacts that cease to overlap in the broad-phase.
 		if (overlap == false)
 		{
 			b2Contact* cNuke = c;
 			c = cNuke->GetNext();
-			Destroy(cNuke);
+			if (m_recycleSteps > 0)
+			{
+				Recycle(cNuke);
+			}
+			else
+			{
+				Destroy(cNuke);
+			}
 			continue;
 		}
 
 		// The contact persists.
-		c->Update(m_contactListener);
+		contacts[count++] = c;
+		++groupCounts[c->m_pairType];
 		c = c->GetNext();
 	}
+
+	// Sort by pair type, keeping the list order within each group.
+	int32 groupStarts[b2Contact::e_pairTypeCount];
+	int32 groupEnds[b2Contact::e_pairTypeCount];
+	int32 start = 0;
+	for (int32 i = 0; i < b2Contact::e_pairTypeCount; ++i)
+	{
+		groupStarts[i] = start;
+		groupEnds[i] = start;
+		start += groupCounts[i];
+	}
+
+	b2Contact** groups = contacts + count;
+	for (int32 i = 0; i < count; ++i)
+	{
+		groups[groupEnds[contacts[i]->m_pairType]++] = contacts[i];
+	}
+
+	UpdateGroup<b2CircleContact>(groups + groupStarts[b2Contact::e_circlePair], groupCounts[b2Contact::e_circlePair]);
+	UpdateGroup<b2PolygonAndCircleContact>(groups + groupStarts[b2Contact::e_polygonAndCirclePair], groupCounts[b2Contact::e_polygonAndCirclePair]);
+	UpdateGroup<b2PolygonContact>(groups + groupStarts[b2Contact::e_polygonPair], groupCounts[b2Contact::e_polygonPair]);
+	UpdateGroup<b2EdgeAndCircleContact>(groups + groupStarts[b2Contact::e_edgeAndCirclePair], groupCounts[b2Contact::e_edgeAndCirclePair]);
+	UpdateGroup<b2EdgeAndPolygonContact>(groups + groupStarts[b2Contact::e_edgeAndPolygonPair], groupCounts[b2Contact::e_edgeAndPolygonPair]);
+	UpdateGroup<b2ChainAndCircleContact>(groups + groupStarts[b2Contact::e_chainAndCirclePair], groupCounts[b2Contact::e_chainAndCirclePair]);
+	UpdateGroup<b2ChainAndPolygonContact>(groups + groupStarts[b2Contact::e_chainAndPolygonPair], groupCounts[b2Contact::e_chainAndPolygonPair]);
+}
+
+template <typename T>
+void b2ContactManager::UpdateGroup(b2Contact** contacts, int32 count)
+{
+	if (m_bufferEvents == false)
+	{
+		for (int32 i = 0; i < count; ++i)
+		{
+			contacts[i]->Update<T>(m_contactListener);
+		}
+		return;
+	}
+
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2Contact* c = contacts[i];
+		bool wasTouching = c->IsTouching();
+		c->Update<T>(NULL);
+		AddTouchEvent(c, wasTouching);
+	}
+}
+
+void b2ContactManager::Update(b2Contact* c)
+{
+	if (m_bufferEvents == false)
+	{
+		c->Update(m_contactListener);
+		return;
+	}
+
+	bool wasTouching = c->IsTouching();
+	c->Update(NULL);
+	AddTouchEvent(c, wasTouching);
+}
+
+void b2ContactManager::AddTouchEvent(b2Contact* c, bool wasTouching)
+{
+	bool touching = c->IsTouching();
+
+	if (touching && wasTouching == false)
+	{
+		AddBeginEvent(c);
+	}
+	else if (touching == false && wasTouching)
+	{
+		AddEndEvent(c);
+	}
 }
 
 void b2ContactManager::FindNewContacts()
@@ -182,21 +626,111 @@ void b2ContactManager::AddPair(void* proxyUserDataA, void* proxyUserDataB)
 	b2Fixture* fixtureA = proxyA->fixture;
 	b2Fixture* fixtureB = proxyB->fixture;
 
-	int32 indexA = proxyA->childIndex;
-	int32 indexB = proxyB->childIndex;
+	// Are the fixtures on the same body?
+	if (fixtureA->GetBody() == fixtureB->GetBody())
+	{
+		return;
+	}
+
+	// Mesh proxies cover many edges. Find the edges that overlap the other proxy.
+	if (fixtureA->m_meshProxy || fixtureB->m_meshProxy)
+	{
+		if (fixtureA->m_meshProxy && fixtureB->m_meshProxy)
+		{
+			return;
+		}
+
+		if (fixtureA->m_meshProxy)
+		{
+			AddMeshPairs(fixtureA, proxyB);
+		}
+		else
+		{
+			AddMeshPairs(fixtureB, proxyA);
+		}
+		return;
+	}
+
+	// Track pairs that only exist because of the fat AABB margins.
+	if (AddPair(fixtureA, proxyA->childIndex, fixtureB, proxyB->childIndex) &&
+		b2TestOverlap(proxyA->aabb, proxyB->aabb) == false)
+	{
+		++m_falsePairCount;
+	}
+}
+
+// Mid-phase query of a mesh edge tree against the fat AABB of another proxy.
+struct b2MeshPairCallback
+{
+	bool QueryCallback(int32 edgeIndex)
+	{
+		manager->AddPair(mesh, edgeIndex, proxy->fixture, proxy->childIndex);
+		return true;
+	}
+
+	b2ContactManager* manager;
+	b2Fixture* mesh;
+	b2FixtureProxy* proxy;
+};
+
+void b2ContactManager::AddMeshPairs(b2Fixture* mesh, b2FixtureProxy* proxy)
+{
+	b2MeshPairCallback callback;
+	callback.manager = this;
+	callback.mesh = mesh;
+	callback.proxy = proxy;
+
+	const b2ChainShape* chain = (b2ChainShape*)mesh->GetShape();
+	chain->QueryEdges(&callback, m_broadPhase.GetFatAABB(proxy->proxyId), mesh->GetBody()->GetTransform());
+}
+
+bool b2ContactManager::TestOverlap(b2Fixture* fixtureA, int32 indexA, b2Fixture* fixtureB, int32 indexB) const
+{
+	if (fixtureA->m_meshProxy || fixtureB->m_meshProxy)
+	{
+		// Test the fat AABB of the edge against the fat AABB of the other proxy.
+		if (fixtureB->m_meshProxy)
+		{
+			b2Swap(fixtureA, fixtureB);
+			b2Swap(indexA, indexB);
+		}
+
+		b2AABB edgeAABB;
+		((b2ChainShape*)fixtureA->GetShape())->GetEdgeAABB(&edgeAABB, fixtureA->GetBody()->GetTransform(), indexA);
+		return b2TestOverlap(edgeAABB, m_broadPhase.GetFatAABB(fixtureB->m_proxies[indexB].proxyId));
+	}
+
+	int32 proxyIdA = fixtureA->m_proxies[indexA].proxyId;
+	int32 proxyIdB = fixtureB->m_proxies[indexB].proxyId;
+	return m_broadPhase.TestOverlap(proxyIdA, proxyIdB);
+}
 
+bool b2ContactManager::AddPair(b2Fixture* fixtureA, int32 indexA, b2Fixture* fixtureB, int32 indexB)
+{
 	b2Body* bodyA = fixtureA->GetBody();
 	b2Body* bodyB = fixtureB->GetBody();
 
-	// Are the fixtures on the same body?
-	if (bodyA == bodyB)
+	// With the sensor pass, sensors do not create contacts. They are handled by UpdateSensors.
+	if (m_sensorPass && (fixtureA->IsSensor() || fixtureB->IsSensor()))
 	{
-		return;
+		if (fixtureA->IsSensor() && fixtureB->IsSensor())
+		{
+			return false;
+		}
+
+		if (fixtureA->IsSensor())
+		{
+			return AddSensorPair(fixtureA, indexA, fixtureB, indexB);
+		}
+
+		return AddSensorPair(fixtureB, indexB, fixtureA, indexA);
 	}
 
 	// TODO_ERIN use a hash table to remove a potential bottleneck when both
 	// bodies have a lot of contacts.
-	// Does a contact already exist?
+	// Does a contact already exist? A pooled contact for this pair is revived
+	// instead of creating a new one.
+	b2Contact* pooled = NULL;
 	b2ContactEdge* edge = bodyB->GetContactList();
 	while (edge)
 	{
@@ -207,16 +741,17 @@ void b2ContactManager::AddPair(void* proxyUserDataA, void* proxyUserDataB)
 			int32 iA = edge->contact->GetChildIndexA();
 			int32 iB = edge->contact->GetChildIndexB();
 
-			if (fA == fixtureA && fB == fixtureB && iA == indexA && iB == indexB)
+			if ((fA == fixtureA && fB == fixtureB && iA == indexA && iB == indexB) ||
+				(fA == fixtureB && fB == fixtureA && iA == indexB && iB == indexA))
 			{
-				// A contact already exists.
-				return;
-			}
+				if ((edge->contact->m_flags & b2Contact::e_pooledFlag) == 0)
+				{
+					// A contact already exists.
+					return false;
+				}
 
-			if (fA == fixtureB && fB == fixtureA && iA == indexB && iB == indexA)
-			{
-				// A contact already exists.
-				return;
+				pooled = edge->contact;
+				break;
 			}
 		}
 
@@ -226,20 +761,27 @@ void b2ContactManager::AddPair(void* proxyUserDataA, void* proxyUserDataB)
 	// Does a joint override collision? Is at least one body dynamic?
 	if (bodyB->ShouldCollide(bodyA) == false)
 	{
-		return;
+		return false;
 	}
 
-	// Check user filtering.
-	if (m_contactFilter && m_contactFilter->ShouldCollide(fixtureA, fixtureB) == false)
+	// Check user filtering. The default filter was already applied by the broad-phase.
+	bool filtered = m_broadPhase.GetFiltering() && m_contactFilter == &b2_defaultFilter;
+	if (m_contactFilter && filtered == false && m_contactFilter->ShouldCollide(fixtureA, fixtureB) == false)
 	{
-		return;
+		return false;
+	}
+
+	if (pooled)
+	{
+		Revive(pooled);
+		return true;
 	}
 
 	// Call the factory.
 	b2Contact* c = b2Contact::Create(fixtureA, indexA, fixtureB, indexB, m_allocator);
 	if (c == NULL)
 	{
-		return;
+		return false;
 	}
 
 	// Contact creation may swap fixtures.
@@ -293,4 +835,264 @@ void b2ContactManager::AddPair(void* proxyUserDataA, void* proxyUserDataB)
 	}
 
 	++m_contactCount;
+
+	return true;
+}
+
+bool b2ContactManager::AddSensorPair(b2Fixture* sensor, int32 sensorChild, b2Fixture* visitor, int32 visitorChild)
+{
+	// Does the pair already exist?
+	for (b2SensorPair* pair = sensor->m_sensorPairList; pair; pair = pair->sensorNext)
+	{
+		if (pair->visitor == visitor && pair->sensorChild == sensorChild && pair->visitorChild == visitorChild)
+		{
+			return false;
+		}
+	}
+
+	// Does a joint override collision? Is at least one body dynamic?
+	if (visitor->GetBody()->ShouldCollide(sensor->GetBody()) == false)
+	{
+		return false;
+	}
+
+	// Check user filtering.
+	if (m_contactFilter && m_contactFilter->ShouldCollide(sensor, visitor) == false)
+	{
+		return false;
+	}
+
+	void* mem = m_allocator->Allocate(sizeof(b2SensorPair));
+	b2SensorPair* pair = (b2SensorPair*)mem;
+	pair->sensor = sensor;
+	pair->visitor = visitor;
+	pair->sensorChild = sensorChild;
+	pair->visitorChild = visitorChild;
+	pair->overlapping = false;
+	pair->filter = false;
+
+	// Insert into the world.
+	pair->prev = NULL;
+	pair->next = m_sensorPairList;
+	if (m_sensorPairList != NULL)
+	{
+		m_sensorPairList->prev = pair;
+	}
+	m_sensorPairList = pair;
+
+	// Insert into the sensor fixture.
+	pair->sensorPrev = NULL;
+	pair->sensorNext = sensor->m_sensorPairList;
+	if (sensor->m_sensorPairList != NULL)
+	{
+		sensor->m_sensorPairList->sensorPrev = pair;
+	}
+	sensor->m_sensorPairList = pair;
+
+	// Insert into the visitor fixture.
+	pair->visitorPrev = NULL;
+	pair->visitorNext = visitor->m_visitorPairList;
+	if (visitor->m_visitorPairList != NULL)
+	{
+		visitor->m_visitorPairList->visitorPrev = pair;
+	}
+	visitor->m_visitorPairList = pair;
+
+	++m_sensorPairCount;
+	return true;
+}
+
+void b2ContactManager::DestroySensorPair(b2SensorPair* pair)
+{
+	if (pair->overlapping)
+	{
+		if (m_bufferEvents)
+		{
+			b2SensorEvent* e = b2PushEvent(m_sensorEndEvents, m_sensorEndEventCount, m_sensorEndEventCapacity);
+			b2SetSensorEvent(e, pair->sensor, pair->visitor);
+		}
+		else if (m_contactListener)
+		{
+			m_contactListener->EndSensorOverlap(pair->sensor, pair->visitor);
+		}
+	}
+
+	// Remove from the world.
+	if (pair->prev)
+	{
+		pair->prev->next = pair->next;
+	}
+
+	if (pair->next)
+	{
+		pair->next->prev = pair->prev;
+	}
+
+	if (pair == m_sensorPairList)
+	{
+		m_sensorPairList = pair->next;
+	}
+
+	// Remove from the sensor fixture.
+	if (pair->sensorPrev)
+	{
+		pair->sensorPrev->sensorNext = pair->sensorNext;
+	}
+
+	if (pair->sensorNext)
+	{
+		pair->sensorNext->sensorPrev = pair->sensorPrev;
+	}
+
+	if (pair == pair->sensor->m_sensorPairList)
+	{
+		pair->sensor->m_sensorPairList = pair->sensorNext;
+	}
+
+	// Remove from the visitor fixture.
+	if (pair->visitorPrev)
+	{
+		pair->visitorPrev->visitorNext = pair->visitorNext;
+	}
+
+	if (pair->visitorNext)
+	{
+		pair->visitorNext->visitorPrev = pair->visitorPrev;
+	}
+
+	if (pair == pair->visitor->m_visitorPairList)
+	{
+		pair->visitor->m_visitorPairList = pair->visitorNext;
+	}
+
+	m_allocator->Free(pair, sizeof(b2SensorPair));
+	--m_sensorPairCount;
+}
+
+void b2ContactManager::DestroySensorPairs(const b2Body* body, const b2Fixture* fixture)
+{
+	if (fixture == NULL)
+	{
+		for (const b2Fixture* f = body->m_fixtureList; f; f = f->m_next)
+		{
+			DestroySensorPairs(body, f);
+		}
+		return;
+	}
+
+	while (fixture->m_sensorPairList)
+	{
+		DestroySensorPair(fixture->m_sensorPairList);
+	}
+
+	while (fixture->m_visitorPairList)
+	{
+		DestroySensorPair(fixture->m_visitorPairList);
+	}
+}
+
+void b2ContactManager::FilterSensorPairs(const b2Body* body, const b2Fixture* fixture)
+{
+	if (fixture == NULL)
+	{
+		for (const b2Fixture* f = body->m_fixtureList; f; f = f->m_next)
+		{
+			FilterSensorPairs(body, f);
+		}
+		return;
+	}
+
+	for (b2SensorPair* pair = fixture->m_sensorPairList; pair; pair = pair->sensorNext)
+	{
+		pair->filter = true;
+	}
+
+	for (b2SensorPair* pair = fixture->m_visitorPairList; pair; pair = pair->visitorNext)
+	{
+		pair->filter = true;
+	}
+}
+
+// Sensor pairs only need a boolean overlap test, so this skips manifolds,
+// contact callbacks and the island graph entirely.
+void b2ContactManager::UpdateSensors()
+{
+	b2SensorPair* pair = m_sensorPairList;
+	while (pair)
+	{
+		b2Fixture* sensor = pair->sensor;
+		b2Fixture* visitor = pair->visitor;
+		b2Body* sensorBody = sensor->GetBody();
+		b2Body* visitorBody = visitor->GetBody();
+
+		// Is this pair flagged for filtering?
+		if (pair->filter)
+		{
+			if (sensor->IsSensor() == false || visitor->IsSensor() ||
+				visitorBody->ShouldCollide(sensorBody) == false ||
+				(m_contactFilter && m_contactFilter->ShouldCollide(sensor, visitor) == false))
+			{
+				b2SensorPair* pairNuke = pair;
+				pair = pairNuke->next;
+				DestroySensorPair(pairNuke);
+				continue;
+			}
+
+			pair->filter = false;
+		}
+
+		bool activeA = sensorBody->IsAwake() && sensorBody->m_type != b2_staticBody;
+		bool activeB = visitorBody->IsAwake() && visitorBody->m_type != b2_staticBody;
+
+		// At least one body must be awake and it must be dynamic or kinematic.
+		if (activeA == false && activeB == false)
+		{
+			pair = pair->next;
+			continue;
+		}
+
+		// Here we destroy pairs that cease to overlap in the broad-phase.
+		if (TestOverlap(sensor, pair->sensorChild, visitor, pair->visitorChild) == false)
+		{
+			b2SensorPair* pairNuke = pair;
+			pair = pairNuke->next;
+			DestroySensorPair(pairNuke);
+			continue;
+		}
+
+		bool wasOverlapping = pair->overlapping;
+		pair->overlapping = b2TestOverlap(sensor->GetShape(), pair->sensorChild,
+			visitor->GetShape(), pair->visitorChild,
+			sensorBody->GetTransform(), visitorBody->GetTransform());
+
+		if (pair->overlapping != wasOverlapping)
+		{
+			if (m_bufferEvents)
+			{
+				b2SensorEvent* e;
+				if (pair->overlapping)
+				{
+					e = b2PushEvent(m_sensorBeginEvents, m_sensorBeginEventCount, m_sensorBeginEventCapacity);
+				}
+				else
+				{
+					e = b2PushEvent(m_sensorEndEvents, m_sensorEndEventCount, m_sensorEndEventCapacity);
+				}
+				b2SetSensorEvent(e, sensor, visitor);
+			}
+			else if (m_contactListener)
+			{
+				if (pair->overlapping)
+				{
+					m_contactListener->BeginSensorOverlap(sensor, visitor);
+				}
+				else
+				{
+					m_contactListener->EndSensorOverlap(sensor, visitor);
+				}
+			}
+		}
+
+		pair = pair->next;
+	}
 }
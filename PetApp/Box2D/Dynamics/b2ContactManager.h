@@ -20,33 +20,161 @@
 #define B2_CONTACT_MANAGER_H
 
 #include <Box2D/Collision/b2BroadPhase.h>
+#include <Box2D/Dynamics/b2WorldCallbacks.h>
 
 class b2Contact;
-class b2ContactFilter;
-class b2ContactListener;
 class b2BlockAllocator;
+struct b2FixtureProxy;
+
+// A broad-phase pair between a sensor fixture child and a solid fixture child.
+// Sensor pairs keep no manifold, only whether the shapes overlap.
+struct b2SensorPair
+{
+	b2Fixture* sensor;
+	b2Fixture* visitor;
+	int32 sensorChild;
+	int32 visitorChild;
+
+	// World sensor pair list.
+	b2SensorPair* prev;
+	b2SensorPair* next;
+
+	// Pair list of the sensor fixture.
+	b2SensorPair* sensorPrev;
+	b2SensorPair* sensorNext;
+
+	// Pair list of the visitor fixture.
+	b2SensorPair* visitorPrev;
+	b2SensorPair* visitorNext;
+
+	bool overlapping;
+	bool filter;
+};
 
 // Delegate of b2World.
 class b2ContactManager
 {
 public:
 	b2ContactManager();
+	~b2ContactManager();
 
 	// Broad-phase callback.
 	void AddPair(void* proxyUserDataA, void* proxyUserDataB);
 
+	// Create a contact or sensor pair for two fixture children if the filters allow it.
+	// Returns true if a new pair was created.
+	bool AddPair(b2Fixture* fixtureA, int32 indexA, b2Fixture* fixtureB, int32 indexB);
+
+	// Mid-phase: add the pairs between the edges of a mesh fixture and another proxy.
+	void AddMeshPairs(b2Fixture* mesh, b2FixtureProxy* proxy);
+
+	// Test the fat AABB overlap of two fixture children. This handles mesh edges.
+	bool TestOverlap(b2Fixture* fixtureA, int32 indexA, b2Fixture* fixtureB, int32 indexB) const;
+
 	void FindNewContacts();
 
 	void Destroy(b2Contact* c);
 
+	// Contact recycling. A contact whose proxies stop overlapping is moved to the
+	// pool instead of being destroyed. It stays in the body contact lists with its
+	// manifold, so it is revived with its warm starting impulses if the pair returns
+	// within m_recycleSteps steps.
+	void Recycle(b2Contact* c);
+	void Revive(b2Contact* c);
+	void FlushPool();
+
+	// Forget all contacts and proxies. Their memory is released by resetting the
+	// block allocator.
+	void Reset();
+
 	void Collide();
+
+	// Update the contact manifold and report touch changes to the listener
+	// or the event buffers.
+	void Update(b2Contact* c);
+
+	// Update a group of contacts of the same pair type. Collide sorts the contacts
+	// that persist into one group per pair type, so each group runs a loop
+	// instantiated for its contact class without indirect calls.
+	template <typename T>
+	void UpdateGroup(b2Contact** contacts, int32 count);
+
+	// Buffer a begin or end event if the touching status changed.
+	void AddTouchEvent(b2Contact* c, bool wasTouching);
+
+	// Buffered contact events. Step drops the events of the previous step when it
+	// starts and marks its own when it ends. End events recorded between steps, when
+	// contacts or sensor pairs are destroyed, are kept for the next step.
+	void ClearEvents();
+	void ClearStepEvents();
+	void MarkStepEvents();
+	void AddBeginEvent(b2Contact* c);
+	void AddEndEvent(b2Contact* c);
+	void AddHitEvent(b2Contact* c, float32 approachSpeed, float32 maxImpulse);
+
+	// Sensor overlap pass. This runs after Collide and only tests shape overlap.
+	void UpdateSensors();
+	bool AddSensorPair(b2Fixture* sensor, int32 sensorChild, b2Fixture* visitor, int32 visitorChild);
+	void DestroySensorPair(b2SensorPair* pair);
+
+	// Destroy or flag for filtering the sensor pairs of a fixture, or of all the
+	// fixtures of a body if fixture is NULL.
+	void DestroySensorPairs(const b2Body* body, const b2Fixture* fixture);
+	void FilterSensorPairs(const b2Body* body, const b2Fixture* fixture);
             
 	b2BroadPhase m_broadPhase;
 	b2Contact* m_contactList;
 	int32 m_contactCount;
+
+	// Scratch space for grouping the contacts in Collide.
+	b2Contact** m_groupContacts;
+	int32 m_groupCapacity;
+
+	// New pairs whose tight AABBs did not overlap (fat AABB false positives).
+	int32 m_falsePairCount;
+
+	// Recycled contacts, newest first. Zero recycle steps disables recycling.
+	b2Contact* m_poolList;
+	int32 m_poolCount;
+	int32 m_recycleSteps;
+	int32 m_collideCount;
+	int32 m_revivalCount;
+
 	b2ContactFilter* m_contactFilter;
 	b2ContactListener* m_contactListener;
 	b2BlockAllocator* m_allocator;
+
+	// When set, sensors use sensor pairs instead of contacts.
+	bool m_sensorPass;
+	b2SensorPair* m_sensorPairList;
+	int32 m_sensorPairCount;
+
+	// When set, contact events are appended to these arrays instead of
+	// going through the listener.
+	bool m_bufferEvents;
+	float32 m_hitEventThreshold;
+
+	b2ContactBeginEvent* m_beginEvents;
+	int32 m_beginEventCount;
+	int32 m_beginEventCapacity;
+
+	b2ContactEndEvent* m_endEvents;
+	int32 m_endEventCount;
+	int32 m_endEventCapacity;
+	int32 m_endEventMark;
+
+	b2ContactHitEvent* m_hitEvents;
+	int32 m_hitEventCount;
+	int32 m_hitEventCapacity;
+
+	b2SensorEvent* m_sensorBeginEvents;
+	int32 m_sensorBeginEventCount;
+	int32 m_sensorBeginEventCapacity;
+
+	b2SensorEvent* m_sensorEndEvents;
+	int32 m_sensorEndEventCount;
+	int32 m_sensorEndEventCapacity;
+	int32 m_sensorEndEventMark;
 };
 
 #endif
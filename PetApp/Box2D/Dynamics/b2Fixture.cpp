@@ -33,6 +33,8 @@ b2Fixture::b2Fixture()
 	m_body = NULL;
 	m_next = NULL;
 	m_proxies = NULL;
+	m_sensorPairList = NULL;
+	m_visitorPairList = NULL;
 	m_proxyCount = 0;
 	m_shape = NULL;
 	m_density = 0.0f;
@@ -53,8 +55,11 @@ void b2Fixture::Create(b2BlockAllocator* allocator, b2Body* body, const b2Fixtur
 
 	m_shape = def->shape->Clone(allocator);
 
+	m_meshProxy = m_shape->m_type == b2Shape::e_chain && ((b2ChainShape*)m_shape)->HasEdgeTree();
+	b2Assert(m_meshProxy == false || body->GetType() == b2_staticBody);
+
 	// Reserve proxy space
-	int32 childCount = m_shape->GetChildCount();
+	int32 childCount = m_meshProxy ? 1 : m_shape->GetChildCount();
 	m_proxies = (b2FixtureProxy*)allocator->Allocate(childCount * sizeof(b2FixtureProxy));
 	for (int32 i = 0; i < childCount; ++i)
 	{
@@ -72,7 +77,7 @@ void b2Fixture::Destroy(b2BlockAllocator* allocator)
 	b2Assert(m_proxyCount == 0);
 
 	// Free the proxy array.
-	int32 childCount = m_shape->GetChildCount();
+	int32 childCount = m_meshProxy ? 1 : m_shape->GetChildCount();
 	allocator->Free(m_proxies, childCount * sizeof(b2FixtureProxy));
 	m_proxies = NULL;
 
@@ -124,13 +129,14 @@ void b2Fixture::CreateProxies(b2BroadPhase* broadPhase, const b2Transform& xf)
 	b2Assert(m_proxyCount == 0);
 
 	// Create proxies in the broad-phase.
-	m_proxyCount = m_shape->GetChildCount();
+	m_proxyCount = m_meshProxy ? 1 : m_shape->GetChildCount();
 
 	for (int32 i = 0; i < m_proxyCount; ++i)
 	{
 		b2FixtureProxy* proxy = m_proxies + i;
-		m_shape->ComputeAABB(&proxy->aabb, xf, i);
+		ComputeProxyAABB(&proxy->aabb, xf, i);
 		proxy->proxyId = broadPhase->CreateProxy(proxy->aabb, proxy);
+		broadPhase->SetProxyFilter(proxy->proxyId, m_filter.categoryBits, m_filter.maskBits, m_filter.groupIndex);
 		proxy->fixture = this;
 		proxy->childIndex = i;
 	}
@@ -162,8 +168,8 @@ void b2Fixture::Synchronize(b2BroadPhase* broadPhase, const b2Transform& transfo
 
 		// Compute an AABB that covers the swept shape (may miss some rotation effect).
 		b2AABB aabb1, aabb2;
-		m_shape->ComputeAABB(&aabb1, transform1, proxy->childIndex);
-		m_shape->ComputeAABB(&aabb2, transform2, proxy->childIndex);
+		ComputeProxyAABB(&aabb1, transform1, proxy->childIndex);
+		ComputeProxyAABB(&aabb2, transform2, proxy->childIndex);
 	
 		proxy->aabb.Combine(aabb1, aabb2);
 
@@ -173,6 +179,18 @@ void b2Fixture::Synchronize(b2BroadPhase* broadPhase, const b2Transform& transfo
 	}
 }
 
+void b2Fixture::ComputeProxyAABB(b2AABB* aabb, const b2Transform& xf, int32 childIndex) const
+{
+	if (m_meshProxy)
+	{
+		// The single mesh proxy covers all the edges.
+		((b2ChainShape*)m_shape)->ComputeEdgeTreeAABB(aabb, xf);
+		return;
+	}
+
+	m_shape->ComputeAABB(aabb, xf, childIndex);
+}
+
 void b2Fixture::SetFilterData(const b2Filter& filter)
 {
 	m_filter = filter;
@@ -209,10 +227,13 @@ void b2Fixture::Refilter()
 		return;
 	}
 
+	world->m_contactManager.FilterSensorPairs(m_body, this);
+
 	// Touch each proxy so that new pairs may be created
 	b2BroadPhase* broadPhase = &world->m_contactManager.m_broadPhase;
 	for (int32 i = 0; i < m_proxyCount; ++i)
 	{
+		broadPhase->SetProxyFilter(m_proxies[i].proxyId, m_filter.categoryBits, m_filter.maskBits, m_filter.groupIndex);
 		broadPhase->TouchProxy(m_proxies[i].proxyId);
 	}
 }
@@ -223,6 +244,10 @@ void b2Fixture::SetSensor(bool sensor)
 	{
 		m_body->SetAwake(true);
 		m_isSensor = sensor;
+
+		// Sensors and solid fixtures use different pair types, so the
+		// existing pairs are replaced at the next step.
+		Refilter();
 	}
 }
 
@@ -233,8 +258,8 @@ void b2Fixture::Dump(int32 bodyIndex)
 	b2Log("    fd.restitution = %.15lef;\n", m_restitution);
 	b2Log("    fd.density = %.15lef;\n", m_density);
 	b2Log("    fd.isSensor = bool(%d);\n", m_isSensor);
-	b2Log("    fd.filter.categoryBits = uint16(%d);\n", m_filter.categoryBits);
-	b2Log("    fd.filter.maskBits = uint16(%d);\n", m_filter.maskBits);
+	b2Log("    fd.filter.categoryBits = b2FilterBits(%llu);\n", (unsigned long long)m_filter.categoryBits);
+	b2Log("    fd.filter.maskBits = b2FilterBits(%llu);\n", (unsigned long long)m_filter.maskBits);
 	b2Log("    fd.filter.groupIndex = int16(%d);\n", m_filter.groupIndex);
 
 	switch (m_shape->m_type)
@@ -301,3 +326,17 @@ void b2Fixture::Dump(int32 bodyIndex)
 	b2Log("\n");
 	b2Log("    bodies[%d]->CreateFixture(&fd);\n", bodyIndex);
 }
+
+b2AABB b2Fixture::GetAABB(int32 childIndex) const
+{
+	// The single proxy of a mesh covers all edges.
+	if (m_meshProxy)
+	{
+		b2AABB aabb;
+		((b2ChainShape*)m_shape)->GetEdgeAABB(&aabb, m_body->GetTransform(), childIndex);
+		return aabb;
+	}
+
+	b2Assert(0 <= childIndex && childIndex < m_proxyCount);
+	return m_proxies[childIndex].aabb;
+}
@@ -27,6 +27,7 @@ class b2BlockAllocator;
 class b2Body;
 class b2BroadPhase;
 class b2Fixture;
+struct b2SensorPair;
 
 /// This holds contact filtering data.
 struct b2Filter
@@ -34,16 +35,16 @@ struct b2Filter
 	b2Filter()
 	{
 		categoryBits = 0x0001;
-		maskBits = 0xFFFF;
+		maskBits = b2FilterBits(~0);
 		groupIndex = 0;
 	}
 
 	/// The collision category bits. Normally you would just set one bit.
-	uint16 categoryBits;
+	b2FilterBits categoryBits;
 
 	/// The collision mask bits. This states the categories that this
 	/// shape would accept for collision.
-	uint16 maskBits;
+	b2FilterBits maskBits;
 
 	/// Collision groups allow a certain group of objects to never collide (negative)
 	/// or always collide (positive). Zero means no collision group. Non-zero group
@@ -117,7 +118,10 @@ public:
 	b2Shape* GetShape();
 	const b2Shape* GetShape() const;
 
-	/// Set if this fixture is a sensor.
+	/// Set if this fixture is a sensor. With the sensor pass enabled sensors do not
+	/// create contacts; their overlaps are reported through
+	/// b2ContactListener::BeginSensorOverlap and EndSensorOverlap.
+	/// @see b2World::SetSensorPass
 	void SetSensor(bool sensor);
 
 	/// Is this fixture a sensor (non-solid)?
@@ -190,7 +194,9 @@ public:
 	/// Get the fixture's AABB. This AABB may be enlarge and/or stale.
 	/// If you need a more accurate AABB, compute it using the shape and
 	/// the body transform.
-	const b2AABB& GetAABB(int32 childIndex) const;
+	/// A chain with an edge tree has a single proxy, see b2ChainShape::CreateEdgeTree.
+	/// Its children still map to the edges, with the fat AABBs of the edge tree.
+	b2AABB GetAABB(int32 childIndex) const;
 
 	/// Dump this fixture to the log file.
 	void Dump(int32 bodyIndex);
@@ -201,6 +207,7 @@ protected:
 	friend class b2World;
 	friend class b2Contact;
 	friend class b2ContactManager;
+	friend class b2WorldStreamer;
 
 	b2Fixture();
 
@@ -215,6 +222,8 @@ protected:
 
 	void Synchronize(b2BroadPhase* broadPhase, const b2Transform& xf1, const b2Transform& xf2);
 
+	void ComputeProxyAABB(b2AABB* aabb, const b2Transform& xf, int32 childIndex) const;
+
 	float32 m_density;
 
 	b2Fixture* m_next;
@@ -226,12 +235,21 @@ protected:
 	float32 m_restitution;
 
 	b2FixtureProxy* m_proxies;
+
+	// Sensor pairs of this fixture as the sensor and as the visitor.
+	b2SensorPair* m_sensorPairList;
+	b2SensorPair* m_visitorPairList;
+
 	int32 m_proxyCount;
 
 	b2Filter m_filter;
 
 	bool m_isSensor;
 
+	// The shape is a chain with an edge tree. It has a single proxy and the
+	// contact manager finds the overlapping edges.
+	bool m_meshProxy;
+
 	void* m_userData;
 };
 
@@ -336,10 +354,4 @@ inline void b2Fixture::GetMassData(b2MassData* massData) const
 	m_shape->ComputeMass(massData, m_density);
 }
 
-inline const b2AABB& b2Fixture::GetAABB(int32 childIndex) const
-{
-	b2Assert(0 <= childIndex && childIndex < m_proxyCount);
-	return m_proxies[childIndex].aabb;
-}
-
 #endif
@@ -24,6 +24,7 @@
 #include <Box2D/Dynamics/Contacts/b2Contact.h>
 #include <Box2D/Dynamics/Contacts/b2ContactSolver.h>
 #include <Box2D/Dynamics/Joints/b2Joint.h>
+#include <Box2D/Dynamics/Joints/b2JointSolver.h>
 #include <Box2D/Common/b2StackAllocator.h>
 #include <Box2D/Common/b2Timer.h>
 
@@ -150,7 +151,7 @@ b2Island::b2Island(
 	int32 contactCapacity,
 	int32 jointCapacity,
 	b2StackAllocator* allocator,
-	b2ContactListener* listener)
+	b2ContactManager* contactManager)
 {
 	m_bodyCapacity = bodyCapacity;
 	m_contactCapacity = contactCapacity;
@@ -160,7 +161,8 @@ b2Island::b2Island(
 	m_jointCount = 0;
 
 	m_allocator = allocator;
-	m_listener = listener;
+	m_contactManager = contactManager;
+	m_listener = contactManager->m_contactListener;
 
 	m_bodies = (b2Body**)m_allocator->Allocate(bodyCapacity * sizeof(b2Body*));
 	m_contacts = (b2Contact**)m_allocator->Allocate(contactCapacity	 * sizeof(b2Contact*));
@@ -180,7 +182,7 @@ b2Island::~b2Island()
 	m_allocator->Free(m_bodies);
 }
 
-void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& gravity, bool allowSleep)
+void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& gravity, bool allowSleep, const b2SleepSettings& sleep)
 {
 	b2Timer timer;
 
@@ -248,10 +250,9 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 		contactSolver.WarmStart();
 	}
 	
-	for (int32 i = 0; i < m_jointCount; ++i)
-	{
-		m_joints[i]->InitVelocityConstraints(solverData);
-	}
+	// Declared after the contact solver so stack allocations are freed in order.
+	b2JointSolver jointSolver(m_joints, m_jointCount, m_bodyCount, m_allocator);
+	jointSolver.InitVelocityConstraints(solverData);
 
 	profile->solveInit = timer.GetMilliseconds();
 
@@ -259,19 +260,20 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 	timer.Reset();
 	for (int32 i = 0; i < step.velocityIterations; ++i)
 	{
-		for (int32 j = 0; j < m_jointCount; ++j)
-		{
-			m_joints[j]->SolveVelocityConstraints(solverData);
-		}
+		jointSolver.SolveVelocityConstraints(solverData);
 
 		contactSolver.SolveVelocityConstraints();
 	}
 
 	// Store impulses for warm starting
 	contactSolver.StoreImpulses();
+	jointSolver.StoreImpulses();
 	profile->solveVelocity = timer.GetMilliseconds();
 
-	// Integrate positions
+	// Integrate positions. A multi-rate island covers several steps, so it may
+	// move further without exceeding the speed limit of a single step.
+	const float32 maxTranslation = float32(step.stepCount) * b2_maxTranslation;
+	const float32 maxRotation = float32(step.stepCount) * b2_maxRotation;
 	for (int32 i = 0; i < m_bodyCount; ++i)
 	{
 		b2Vec2 c = m_positions[i].c;
@@ -281,16 +283,16 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 
 		// Check for large velocities
 		b2Vec2 translation = h * v;
-		if (b2Dot(translation, translation) > b2_maxTranslationSquared)
+		if (b2Dot(translation, translation) > maxTranslation * maxTranslation)
 		{
-			float32 ratio = b2_maxTranslation / translation.Length();
+			float32 ratio = maxTranslation / translation.Length();
 			v *= ratio;
 		}
 
 		float32 rotation = h * w;
-		if (rotation * rotation > b2_maxRotationSquared)
+		if (rotation * rotation > maxRotation * maxRotation)
 		{
-			float32 ratio = b2_maxRotation / b2Abs(rotation);
+			float32 ratio = maxRotation / b2Abs(rotation);
 			w *= ratio;
 		}
 
@@ -311,12 +313,7 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 	{
 		bool contactsOkay = contactSolver.SolvePositionConstraints();
 
-		bool jointsOkay = true;
-		for (int32 i = 0; i < m_jointCount; ++i)
-		{
-			bool jointOkay = m_joints[i]->SolvePositionConstraints(solverData);
-			jointsOkay = jointsOkay && jointOkay;
-		}
+		bool jointsOkay = jointSolver.SolvePositionConstraints(solverData);
 
 		if (contactsOkay && jointsOkay)
 		{
@@ -345,8 +342,29 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 	{
 		float32 minSleepTime = b2_maxFloat;
 
-		const float32 linTolSqr = b2_linearSleepTolerance * b2_linearSleepTolerance;
-		const float32 angTolSqr = b2_angularSleepTolerance * b2_angularSleepTolerance;
+		const float32 linTolSqr = sleep.linearTolerance * sleep.linearTolerance;
+		const float32 angTolSqr = sleep.angularTolerance * sleep.angularTolerance;
+		const float32 stillScaleSqr = sleep.energySpeedScale * sleep.energySpeedScale;
+
+		// Kinetic energy per unit mass of the whole island.
+		bool islandStill = false;
+		if (sleep.energyTolerance > 0.0f)
+		{
+			float32 energy = 0.0f;
+			float32 mass = 0.0f;
+			for (int32 i = 0; i < m_bodyCount; ++i)
+			{
+				b2Body* b = m_bodies[i];
+				if (b->GetType() == b2_dynamicBody)
+				{
+					float32 w = b->m_angularVelocity;
+					energy += 0.5f * (b->m_mass * b2Dot(b->m_linearVelocity, b->m_linearVelocity) + b->m_I * w * w);
+					mass += b->m_mass;
+				}
+			}
+
+			islandStill = mass > 0.0f && energy <= sleep.energyTolerance * mass;
+		}
 
 		for (int32 i = 0; i < m_bodyCount; ++i)
 		{
@@ -356,9 +374,19 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 				continue;
 			}
 
-			if ((b->m_flags & b2Body::e_autoSleepFlag) == 0 ||
-				b->m_angularVelocity * b->m_angularVelocity > angTolSqr ||
-				b2Dot(b->m_linearVelocity, b->m_linearVelocity) > linTolSqr)
+			float32 angSqr = b->m_angularVelocity * b->m_angularVelocity;
+			float32 linSqr = b2Dot(b->m_linearVelocity, b->m_linearVelocity);
+			bool still = angSqr <= angTolSqr && linSqr <= linTolSqr;
+
+			// In a still island a dynamic body may move a little faster, but a
+			// light body can not hide a large speed behind a heavy one.
+			// Kinematic bodies carry no mass, so they must be still on their own.
+			if (still == false && islandStill && b->GetType() == b2_dynamicBody)
+			{
+				still = angSqr <= stillScaleSqr * angTolSqr && linSqr <= stillScaleSqr * linTolSqr;
+			}
+
+			if ((b->m_flags & b2Body::e_autoSleepFlag) == 0 || still == false)
 			{
 				b->m_sleepTime = 0.0f;
 				minSleepTime = 0.0f;
@@ -370,7 +398,14 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 			}
 		}
 
-		if (minSleepTime >= b2_timeToSleep && positionSolved)
+		float32 timeToSleep = sleep.timeToSleep;
+		if (sleep.stackedSleep && IsStacked())
+		{
+			// Stacks keep jittering long after they come to rest.
+			timeToSleep = b2Min(timeToSleep, sleep.stackedTimeToSleep);
+		}
+
+		if (minSleepTime >= timeToSleep && positionSolved)
 		{
 			for (int32 i = 0; i < m_bodyCount; ++i)
 			{
@@ -515,6 +550,30 @@ void b2Island::SolveTOI(const b2TimeStep& subStep, int32 toiIndexA, int32 toiInd
 
 void b2Island::Report(const b2ContactVelocityConstraint* constraints)
 {
+	if (m_contactManager->m_bufferEvents)
+	{
+		float32 threshold = m_contactManager->m_hitEventThreshold;
+		for (int32 i = 0; i < m_contactCount; ++i)
+		{
+			const b2ContactVelocityConstraint* vc = constraints + i;
+
+			float32 approachSpeed = 0.0f;
+			float32 maxImpulse = 0.0f;
+			for (int32 j = 0; j < vc->pointCount; ++j)
+			{
+				approachSpeed = b2Max(approachSpeed, -vc->points[j].relativeVelocity);
+				maxImpulse = b2Max(maxImpulse, vc->points[j].normalImpulse);
+			}
+
+			if (approachSpeed > threshold)
+			{
+				m_contactManager->AddHitEvent(m_contacts[i], approachSpeed, maxImpulse);
+			}
+		}
+
+		return;
+	}
+
 	if (m_listener == NULL)
 	{
 		return;
@@ -537,3 +596,44 @@ void b2Island::Report(const b2ContactVelocityConstraint* constraints)
 		m_listener->PostSolve(c, &impulse);
 	}
 }
+
+bool b2Island::IsStacked() const
+{
+	int32 dynamicCount = 0;
+	for (int32 i = 0; i < m_bodyCount && dynamicCount < 2; ++i)
+	{
+		if (m_bodies[i]->GetType() == b2_dynamicBody)
+		{
+			++dynamicCount;
+		}
+	}
+
+	if (dynamicCount < 2)
+	{
+		return false;
+	}
+
+	bool grounded = false;
+	bool touching = false;
+	for (int32 i = 0; i < m_contactCount; ++i)
+	{
+		b2Contact* c = m_contacts[i];
+		b2BodyType typeA = c->GetFixtureA()->GetBody()->GetType();
+		b2BodyType typeB = c->GetFixtureB()->GetBody()->GetType();
+		if (typeA == b2_staticBody || typeB == b2_staticBody)
+		{
+			grounded = true;
+		}
+		else if (typeA == b2_dynamicBody && typeB == b2_dynamicBody)
+		{
+			touching = true;
+		}
+
+		if (grounded && touching)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
@@ -27,6 +27,7 @@ class b2Contact;
 class b2Joint;
 class b2StackAllocator;
 class b2ContactListener;
+class b2ContactManager;
 struct b2ContactVelocityConstraint;
 struct b2Profile;
 
@@ -35,7 +36,7 @@ class b2Island
 {
 public:
 	b2Island(int32 bodyCapacity, int32 contactCapacity, int32 jointCapacity,
-			b2StackAllocator* allocator, b2ContactListener* listener);
+			b2StackAllocator* allocator, b2ContactManager* contactManager);
 	~b2Island();
 
 	void Clear()
@@ -45,7 +46,7 @@ public:
 		m_jointCount = 0;
 	}
 
-	void Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& gravity, bool allowSleep);
+	void Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& gravity, bool allowSleep, const b2SleepSettings& sleep);
 
 	void SolveTOI(const b2TimeStep& subStep, int32 toiIndexA, int32 toiIndexB);
 
@@ -71,8 +72,13 @@ public:
 
 	void Report(const b2ContactVelocityConstraint* constraints);
 
+	/// Is this a stack: two or more dynamic bodies that touch each other and
+	/// rest on a static body?
+	bool IsStacked() const;
+
 	b2StackAllocator* m_allocator;
 	b2ContactListener* m_listener;
+	b2ContactManager* m_contactManager;
 
 	b2Body** m_bodies;
 	b2Contact** m_contacts;
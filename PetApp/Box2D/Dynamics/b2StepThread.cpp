@@ -0,0 +1,144 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Dynamics/b2StepThread.h>
+#include <Box2D/Dynamics/b2Body.h>
+#include <Box2D/Dynamics/b2World.h>
+
+b2StepThread::b2StepThread(b2World* world)
+{
+	m_world = world;
+
+	m_buffers[0] = NULL;
+	m_buffers[1] = NULL;
+	m_front.store(0);
+	m_count = 0;
+	m_capacity = 0;
+
+	m_timeStep = 0.0f;
+	m_velocityIterations = 0;
+	m_positionIterations = 0;
+
+	m_busy = false;
+	m_quit = false;
+
+	m_thread = std::thread(&b2StepThread::Run, this);
+}
+
+b2StepThread::~b2StepThread()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_quit = true;
+	}
+	m_condition.notify_all();
+	m_thread.join();
+
+	b2Free(m_buffers[0]);
+	b2Free(m_buffers[1]);
+}
+
+void b2StepThread::Start(float32 timeStep, int32 velocityIterations, int32 positionIterations)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		b2Assert(m_busy == false);
+		m_timeStep = timeStep;
+		m_velocityIterations = velocityIterations;
+		m_positionIterations = positionIterations;
+		m_busy = true;
+	}
+	m_condition.notify_all();
+}
+
+void b2StepThread::Wait()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (m_busy)
+	{
+		m_condition.wait(lock);
+	}
+}
+
+bool b2StepThread::IsBusy() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_busy;
+}
+
+void b2StepThread::Prepare()
+{
+	int32 count = m_world->GetBodyCount();
+	if (count > m_capacity)
+	{
+		b2Free(m_buffers[0]);
+		b2Free(m_buffers[1]);
+		m_capacity = b2Max(count, 2 * m_capacity);
+		m_buffers[0] = (b2Transform*)b2Alloc(m_capacity * sizeof(b2Transform));
+		m_buffers[1] = (b2Transform*)b2Alloc(m_capacity * sizeof(b2Transform));
+		m_count = 0;
+	}
+
+	// The bodies may have been moved, created or destroyed since the last step.
+	m_count = count;
+	int32 index = 0;
+	b2Transform* front = m_buffers[m_front.load(std::memory_order_relaxed)];
+	for (b2Body* b = m_world->GetBodyList(); b; b = b->GetNext())
+	{
+		b->m_stateIndex = index;
+		front[index] = b->GetTransform();
+		++index;
+	}
+}
+
+void b2StepThread::Publish()
+{
+	int32 back = 1 - m_front.load(std::memory_order_relaxed);
+	b2Transform* buffer = m_buffers[back];
+	for (b2Body* b = m_world->GetBodyList(); b; b = b->GetNext())
+	{
+		buffer[b->m_stateIndex] = b->GetTransform();
+	}
+
+	m_front.store(back, std::memory_order_release);
+}
+
+void b2StepThread::Run()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	for (;;)
+	{
+		while (m_busy == false && m_quit == false)
+		{
+			m_condition.wait(lock);
+		}
+
+		if (m_quit)
+		{
+			return;
+		}
+
+		lock.unlock();
+		m_world->Step(m_timeStep, m_velocityIterations, m_positionIterations);
+		Publish();
+		lock.lock();
+
+		m_busy = false;
+		m_condition.notify_all();
+	}
+}
@@ -0,0 +1,85 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_STEP_THREAD_H
+#define B2_STEP_THREAD_H
+
+#include <Box2D/Common/b2Math.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+class b2World;
+
+// Delegate of b2World for asynchronous stepping. A worker thread runs b2World::Step
+// and then writes the body transforms into the back buffer and publishes it. The
+// thread that starts the steps reads the front buffer without locking.
+class b2StepThread
+{
+public:
+	b2StepThread(b2World* world);
+	~b2StepThread();
+
+	// Start a step. The previous step must be complete.
+	void Start(float32 timeStep, int32 velocityIterations, int32 positionIterations);
+
+	// Wait until the current step is complete.
+	void Wait();
+
+	// Is a step running?
+	bool IsBusy() const;
+
+	// Assign the state indices of the bodies and fill the front buffer with the
+	// current transforms. This must be called between steps.
+	void Prepare();
+
+	// Copy the body transforms into the back buffer and make it the front buffer.
+	void Publish();
+
+	const b2Transform& GetTransform(int32 index) const
+	{
+		b2Assert(0 <= index && index < m_count);
+		return m_buffers[m_front.load(std::memory_order_acquire)][index];
+	}
+
+private:
+
+	void Run();
+
+	b2World* m_world;
+
+	b2Transform* m_buffers[2];
+	std::atomic<int32> m_front;
+	int32 m_count;
+	int32 m_capacity;
+
+	float32 m_timeStep;
+	int32 m_velocityIterations;
+	int32 m_positionIterations;
+
+	mutable std::mutex m_mutex;
+	std::condition_variable m_condition;
+	bool m_busy;
+	bool m_quit;
+
+	std::thread m_thread;
+};
+
+#endif
@@ -21,17 +21,64 @@
 
 #include <Box2D/Common/b2Math.h>
 
-/// Profiling data. Times are in milliseconds.
+/// Profiling data. Times are in milliseconds, counts are per step.
 struct b2Profile
 {
 	float32 step;
 	float32 collide;
+	float32 sensors;
 	float32 solve;
 	float32 solveInit;
 	float32 solveVelocity;
 	float32 solvePosition;
 	float32 broadphase;
 	float32 solveTOI;
+	int32 proxyReinserts;	///< proxies re-inserted into the dynamic tree
+	int32 falsePairs;		///< new pairs whose tight AABBs did not overlap
+	int32 contactRevivals;	///< recycled contacts revived by new pairs
+	int32 islands;			///< islands solved
+	int32 awakeIslands;		///< islands still awake after the step
+	int32 awakeBodies;		///< non-static bodies still awake after the step
+	int32 toiEvents;			///< TOI events solved
+	int32 deferredTOIContacts;	///< pending TOI events left over by the TOI budget
+	int32 deferredTOIBodies;	///< bodies held at their first TOI by the TOI budget
+};
+
+/// Sleep thresholds of a world. See b2World::SetSleepSettings.
+struct b2SleepSettings
+{
+	b2SleepSettings()
+	{
+		linearTolerance = b2_linearSleepTolerance;
+		angularTolerance = b2_angularSleepTolerance;
+		timeToSleep = b2_timeToSleep;
+		energyTolerance = 0.0f;
+		energySpeedScale = 4.0f;
+		stackedSleep = false;
+		stackedTimeToSleep = 0.25f * b2_timeToSleep;
+	}
+
+	/// A body is still while its speeds stay below these tolerances.
+	float32 linearTolerance;
+	float32 angularTolerance;
+
+	/// The time an island must stay still before it goes to sleep.
+	float32 timeToSleep;
+
+	/// An island is also still while its kinetic energy per unit mass stays
+	/// below this value, so jitter of single bodies in a stack does not keep
+	/// it awake. Zero disables the energy test.
+	float32 energyTolerance;
+
+	/// Under the energy test each body must still be slower than this multiple
+	/// of the tolerances.
+	float32 energySpeedScale;
+
+	/// Let stacks sleep after stackedTimeToSleep. A stack is an island with at
+	/// least two dynamic bodies that touch each other and rest on a static
+	/// body. The position solver must still have converged.
+	bool stackedSleep;
+	float32 stackedTimeToSleep;
 };
 
 /// This is an internal structure.
@@ -40,9 +87,11 @@ struct b2TimeStep
 	float32 dt;			// time step
 	float32 inv_dt;		// inverse time step (0 if dt == 0).
 	float32 dtRatio;	// dt * inv_dt0
+	int32 stepCount;	// world steps covered by dt (multi-rate islands)
 	int32 velocityIterations;
 	int32 positionIterations;
 	bool warmStarting;
+	bool directJoints;	// solve joint trees with b2ArticulationSolver
 };
 
 /// This is an internal structure.
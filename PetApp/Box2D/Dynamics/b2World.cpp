@@ -20,6 +20,8 @@
 #include <Box2D/Dynamics/b2Body.h>
 #include <Box2D/Dynamics/b2Fixture.h>
 #include <Box2D/Dynamics/b2Island.h>
+#include <Box2D/Dynamics/b2StepThread.h>
+#include <Box2D/Dynamics/Joints/b2GearJoint.h>
 #include <Box2D/Dynamics/Joints/b2PulleyJoint.h>
 #include <Box2D/Dynamics/Contacts/b2Contact.h>
 #include <Box2D/Dynamics/Contacts/b2ContactSolver.h>
@@ -46,11 +48,20 @@ b2World::b2World(const b2Vec2& gravity)
 	m_jointCount = 0;
 
 	m_warmStarting = true;
+	m_directJointSolver = false;
 	m_continuousPhysics = true;
 	m_subStepping = false;
 
 	m_stepComplete = true;
 
+	m_toiTimeBudget = 0.0f;
+	m_toiEventBudget = 0;
+
+	m_multiRate = false;
+	m_rateStep = 0;
+	m_rateCenter.SetZero();
+	m_rateRadius = 0.0f;
+
 	m_allowSleep = true;
 	m_gravity = gravity;
 
@@ -61,27 +72,46 @@ b2World::b2World(const b2Vec2& gravity)
 	m_contactManager.m_allocator = &m_blockAllocator;
 
 	memset(&m_profile, 0, sizeof(b2Profile));
+
+	m_stepThread = NULL;
+
+	m_origin.SetZero();
 }
 
 b2World::~b2World()
 {
-	// Some shapes allocate using b2Alloc.
-	b2Body* b = m_bodyList;
-	while (b)
-	{
-		b2Body* bNext = b->m_next;
+	SetAsyncStepping(false);
 
-		b2Fixture* f = b->m_fixtureList;
-		while (f)
-		{
-			b2Fixture* fNext = f->m_next;
-			f->m_proxyCount = 0;
-			f->Destroy(&m_blockAllocator);
-			f = fNext;
-		}
+	// All bodies, fixtures, shapes, contacts and joints are in the block
+	// allocator, so they are released with it.
+}
 
-		b = bNext;
+void b2World::Reset()
+{
+	b2Assert(IsLocked() == false && IsStepping() == false);
+	if (IsLocked() || IsStepping())
+	{
+		return;
 	}
+
+	// Everything the bodies own is in the block allocator, except the broad-phase
+	// tree and buffers which keep their capacity.
+	m_blockAllocator.Reset();
+	m_contactManager.Reset();
+
+	m_bodyList = NULL;
+	m_jointList = NULL;
+	m_bodyCount = 0;
+	m_jointCount = 0;
+
+	m_flags &= ~e_newFixture;
+	m_stepComplete = true;
+	m_rateStep = 0;
+	m_inv_dt0 = 0.0f;
+
+	m_origin.SetZero();
+
+	memset(&m_profile, 0, sizeof(b2Profile));
 }
 
 void b2World::SetDestructionListener(b2DestructionListener* listener)
@@ -92,6 +122,14 @@ void b2World::SetDestructionListener(b2DestructionListener* listener)
 void b2World::SetContactFilter(b2ContactFilter* filter)
 {
 	m_contactManager.m_contactFilter = filter;
+
+	// A custom filter may accept pairs that the filter bits reject.
+	m_contactManager.m_broadPhase.SetFiltering(filter == &b2_defaultFilter);
+}
+
+void b2World::SetBroadPhaseFiltering(bool flag)
+{
+	m_contactManager.m_broadPhase.SetFiltering(flag);
 }
 
 void b2World::SetContactListener(b2ContactListener* listener)
@@ -99,6 +137,97 @@ void b2World::SetContactListener(b2ContactListener* listener)
 	m_contactManager.m_contactListener = listener;
 }
 
+void b2World::SetContactEventBuffering(bool flag)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return;
+	}
+
+	m_contactManager.m_bufferEvents = flag;
+	m_contactManager.ClearEvents();
+}
+
+void b2World::SetSensorPass(bool flag)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked() || flag == m_contactManager.m_sensorPass)
+	{
+		return;
+	}
+
+	m_contactManager.m_sensorPass = flag;
+
+	// Drop the sensor contacts or sensor pairs. The other kind is created at the
+	// next step.
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		b2ContactEdge* edge = b->m_contactList;
+		while (edge)
+		{
+			b2Contact* c = edge->contact;
+			edge = edge->next;
+			if (c->m_fixtureA->m_isSensor || c->m_fixtureB->m_isSensor)
+			{
+				m_contactManager.Destroy(c);
+			}
+		}
+
+		m_contactManager.DestroySensorPairs(b, NULL);
+
+		for (b2Fixture* f = b->m_fixtureList; f; f = f->m_next)
+		{
+			if (f->m_isSensor)
+			{
+				f->Refilter();
+			}
+		}
+	}
+}
+
+void b2World::SetContactRecycling(int32 steps)
+{
+	b2Assert(IsLocked() == false);
+	b2Assert(steps >= 0);
+	if (IsLocked())
+	{
+		return;
+	}
+
+	m_contactManager.m_recycleSteps = b2Max(steps, 0);
+	if (m_contactManager.m_recycleSteps == 0)
+	{
+		m_contactManager.FlushPool();
+	}
+}
+
+void b2World::SetTOIBudget(float32 milliseconds, int32 eventCount)
+{
+	b2Assert(b2IsValid(milliseconds) && milliseconds >= 0.0f);
+	b2Assert(eventCount >= 0);
+	m_toiTimeBudget = b2Max(milliseconds, 0.0f);
+	m_toiEventBudget = b2Max(eventCount, 0);
+}
+
+void b2World::SetMultiRate(bool flag)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return;
+	}
+
+	m_multiRate = flag;
+}
+
+void b2World::SetRateFocus(const b2Vec2& center, float32 radius)
+{
+	b2Assert(b2IsValid(radius) && radius >= 0.0f);
+	m_rateCenter = center;
+	m_rateRadius = radius;
+}
+
 void b2World::SetDebugDraw(b2Draw* debugDraw)
 {
 	m_debugDraw = debugDraw;
@@ -128,6 +257,44 @@ b2Body* b2World::CreateBody(const b2BodyDef* def)
 	return b;
 }
 
+void b2World::CreateBodies(const b2BodyDef* bodyDefs, int32 bodyCount,
+						   const b2FixtureDef* fixtureDefs, const int32* fixtureCounts,
+						   b2Body** bodies)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return;
+	}
+
+	b2Assert(fixtureDefs == NULL || fixtureCounts != NULL);
+
+	b2BroadPhase* broadPhase = &m_contactManager.m_broadPhase;
+	broadPhase->BeginBulkInsert();
+
+	const b2FixtureDef* fixtureDef = fixtureDefs;
+	for (int32 i = 0; i < bodyCount; ++i)
+	{
+		b2Body* b = CreateBody(bodyDefs + i);
+
+		if (fixtureDefs != NULL)
+		{
+			for (int32 j = 0; j < fixtureCounts[i]; ++j)
+			{
+				b->CreateFixture(fixtureDef);
+				++fixtureDef;
+			}
+		}
+
+		if (bodies != NULL)
+		{
+			bodies[i] = b;
+		}
+	}
+
+	broadPhase->EndBulkInsert();
+}
+
 void b2World::DestroyBody(b2Body* b)
 {
 	b2Assert(m_bodyCount > 0);
@@ -164,6 +331,7 @@ void b2World::DestroyBody(b2Body* b)
 		m_contactManager.Destroy(ce0->contact);
 	}
 	b->m_contactList = NULL;
+	m_contactManager.DestroySensorPairs(b, NULL);
 
 	// Delete the attached fixtures. This destroys broad-phase proxies.
 	b2Fixture* f = b->m_fixtureList;
@@ -262,6 +430,8 @@ b2Joint* b2World::CreateJoint(const b2JointDef* def)
 
 			edge = edge->next;
 		}
+
+		m_contactManager.FilterSensorPairs(bodyB, NULL);
 	}
 
 	// Note: creating a joint doesn't wake the bodies.
@@ -361,6 +531,8 @@ void b2World::DestroyJoint(b2Joint* j)
 
 			edge = edge->next;
 		}
+
+		m_contactManager.FilterSensorPairs(bodyB, NULL);
 	}
 }
 
@@ -388,13 +560,16 @@ void b2World::Solve(const b2TimeStep& step)
 	m_profile.solveInit = 0.0f;
 	m_profile.solveVelocity = 0.0f;
 	m_profile.solvePosition = 0.0f;
+	m_profile.islands = 0;
+	m_profile.awakeIslands = 0;
+	m_profile.awakeBodies = 0;
 
 	// Size the island for the worst case.
 	b2Island island(m_bodyCount,
 					m_contactManager.m_contactCount,
 					m_jointCount,
 					&m_stackAllocator,
-					m_contactManager.m_contactListener);
+					&m_contactManager);
 
 	// Clear all the island flags.
 	for (b2Body* b = m_bodyList; b; b = b->m_next)
@@ -410,6 +585,29 @@ void b2World::Solve(const b2TimeStep& step)
 		j->m_islandFlag = false;
 	}
 
+	// Assign rate levels by distance from the focus.
+	if (m_multiRate && m_rateRadius > 0.0f)
+	{
+		for (b2Body* b = m_bodyList; b; b = b->m_next)
+		{
+			if (b->GetType() == b2_staticBody || b->IsAwake() == false)
+			{
+				continue;
+			}
+
+			float32 distanceSquared = b2DistanceSquared(b->m_sweep.c, m_rateCenter);
+			float32 radius = m_rateRadius;
+			int32 level = 0;
+			while (level < b2_maxRateLevel && distanceSquared > radius * radius)
+			{
+				++level;
+				radius *= 2.0f;
+			}
+
+			b->m_rateLevel = level;
+		}
+	}
+
 	// Build and simulate all awake islands.
 	int32 stackSize = m_bodyCount;
 	b2Body** stack = (b2Body**)m_stackAllocator.Allocate(stackSize * sizeof(b2Body*));
@@ -527,11 +725,114 @@ void b2World::Solve(const b2TimeStep& step)
 			}
 		}
 
-		b2Profile profile;
-		island.Solve(&profile, step, m_gravity, m_allowSleep);
-		m_profile.solveInit += profile.solveInit;
-		m_profile.solveVelocity += profile.solveVelocity;
-		m_profile.solvePosition += profile.solvePosition;
+		// With multi-rate stepping the island runs at the rate of its fastest body.
+		int32 level = 0;
+		if (m_multiRate)
+		{
+			level = b2_maxRateLevel;
+			for (int32 i = 0; i < island.m_bodyCount; ++i)
+			{
+				b2Body* b = island.m_bodies[i];
+
+				// A body that just woke up has only missed this step.
+				if (b->m_flags & b2Body::e_lodResetFlag)
+				{
+					b->m_lodStep = m_rateStep - 1;
+					b->m_flags &= ~b2Body::e_lodResetFlag;
+				}
+
+				if (b->GetType() != b2_staticBody)
+				{
+					level = b2Min(level, b->m_rateLevel);
+				}
+			}
+		}
+
+		// Level n is due on steps 2^(n-1) modulo 2^n, so no two slow levels share a step.
+		if (level > 0 && (m_rateStep & ((1 << level) - 1)) != (1 << (level - 1)))
+		{
+			// Hold the bodies still so continuous collision does not move them.
+			for (int32 i = 0; i < island.m_bodyCount; ++i)
+			{
+				b2Body* b = island.m_bodies[i];
+				b->m_sweep.c0 = b->m_sweep.c;
+				b->m_sweep.a0 = b->m_sweep.a;
+			}
+		}
+		else
+		{
+			// The island covers the steps since its bodies were last solved. Bodies
+			// that joined from a faster island have fewer, so take the minimum and
+			// let the others lose time rather than gain it.
+			b2TimeStep rateStep = step;
+			int32 stepCount = 1;
+			if (m_multiRate)
+			{
+				int32 lastCount = 0;
+				stepCount = 0;
+				for (int32 i = 0; i < island.m_bodyCount; ++i)
+				{
+					b2Body* b = island.m_bodies[i];
+					if (b->GetType() == b2_staticBody)
+					{
+						continue;
+					}
+
+					// Each body is solved at most once per step and at most once per 2^level steps.
+					int32 elapsed = m_rateStep - b->m_lodStep;
+					b2Assert(elapsed >= 1);
+					b2Assert(b->m_rateLevel >= level);
+					if (stepCount == 0 || elapsed < stepCount)
+					{
+						stepCount = elapsed;
+						lastCount = b->m_lodSteps;
+					}
+				}
+
+				stepCount = b2Max(stepCount, 1);
+				lastCount = b2Max(lastCount, 1);
+				if (stepCount > 1)
+				{
+					rateStep.dt = float32(stepCount) * step.dt;
+					rateStep.inv_dt = step.inv_dt / float32(stepCount);
+					rateStep.stepCount = stepCount;
+				}
+
+				// Scale the warm starting impulses when the island changes rate.
+				if (stepCount != lastCount)
+				{
+					rateStep.dtRatio = step.dtRatio * float32(stepCount) / float32(lastCount);
+				}
+			}
+
+			for (int32 i = 0; i < island.m_bodyCount; ++i)
+			{
+				b2Body* b = island.m_bodies[i];
+				b->m_lodSteps = stepCount;
+				b->m_lodStep = m_rateStep;
+				b->m_lodCenter0 = b->m_sweep.c;
+				b->m_lodAngle0 = b->m_sweep.a;
+			}
+
+			b2Profile profile;
+			island.Solve(&profile, rateStep, m_gravity, m_allowSleep, m_sleepSettings);
+			m_profile.solveInit += profile.solveInit;
+			m_profile.solveVelocity += profile.solveVelocity;
+			m_profile.solvePosition += profile.solvePosition;
+
+			++m_profile.islands;
+			if (seed->IsAwake())
+			{
+				++m_profile.awakeIslands;
+				for (int32 i = 0; i < island.m_bodyCount; ++i)
+				{
+					if (island.m_bodies[i]->GetType() != b2_staticBody)
+					{
+						++m_profile.awakeBodies;
+					}
+				}
+			}
+		}
 
 		// Post solve cleanup.
 		for (int32 i = 0; i < island.m_bodyCount; ++i)
@@ -563,6 +864,12 @@ void b2World::Solve(const b2TimeStep& step)
 				continue;
 			}
 
+			// Neither did a body in an island that is waiting for its rate.
+			if (m_multiRate && b->m_lodStep != m_rateStep)
+			{
+				continue;
+			}
+
 			// Update fixtures (for broad-phase).
 			b->SynchronizeFixtures();
 		}
@@ -571,12 +878,16 @@ void b2World::Solve(const b2TimeStep& step)
 		m_contactManager.FindNewContacts();
 		m_profile.broadphase = timer.GetMilliseconds();
 	}
+
+	++m_rateStep;
 }
 
 // Find TOI contacts and solve them.
 void b2World::SolveTOI(const b2TimeStep& step)
 {
-	b2Island island(2 * b2_maxTOIContacts, b2_maxTOIContacts, 0, &m_stackAllocator, m_contactManager.m_contactListener);
+	b2Island island(2 * b2_maxTOIContacts, b2_maxTOIContacts, 0, &m_stackAllocator, &m_contactManager);
+
+	b2Timer timer;
 
 	if (m_stepComplete)
 	{
@@ -719,6 +1030,18 @@ void b2World::SolveTOI(const b2TimeStep& step)
 			break;
 		}
 
+		// Out of budget? All pending TOIs are valid at this point. Solve at least one
+		// event so that a small time budget still makes progress.
+		if ((m_toiEventBudget > 0 && m_profile.toiEvents >= m_toiEventBudget) ||
+			(m_toiTimeBudget > 0.0f && m_profile.toiEvents > 0 && timer.GetMilliseconds() >= m_toiTimeBudget))
+		{
+			DeferTOI();
+			m_stepComplete = true;
+			break;
+		}
+
+		++m_profile.toiEvents;
+
 		// Advance the bodies to the TOI.
 		b2Fixture* fA = minContact->GetFixtureA();
 		b2Fixture* fB = minContact->GetFixtureB();
@@ -732,7 +1055,7 @@ void b2World::SolveTOI(const b2TimeStep& step)
 		bB->Advance(minAlpha);
 
 		// The TOI contact likely has some new contact points.
-		minContact->Update(m_contactManager.m_contactListener);
+		m_contactManager.Update(minContact);
 		minContact->m_flags &= ~b2Contact::e_toiFlag;
 		++minContact->m_toiCount;
 
@@ -782,8 +1105,9 @@ void b2World::SolveTOI(const b2TimeStep& step)
 
 					b2Contact* contact = ce->contact;
 
-					// Has this contact already been added to the island?
-					if (contact->m_flags & b2Contact::e_islandFlag)
+					// Has this contact already been added to the island? Is it a
+					// recycled contact that is not in the world?
+					if (contact->m_flags & (b2Contact::e_islandFlag | b2Contact::e_pooledFlag))
 					{
 						continue;
 					}
@@ -812,7 +1136,7 @@ void b2World::SolveTOI(const b2TimeStep& step)
 					}
 
 					// Update the contact points
-					contact->Update(m_contactManager.m_contactListener);
+					m_contactManager.Update(contact);
 
 					// Was the contact disabled by the user?
 					if (contact->IsEnabled() == false)
@@ -857,9 +1181,11 @@ void b2World::SolveTOI(const b2TimeStep& step)
 		subStep.dt = (1.0f - minAlpha) * step.dt;
 		subStep.inv_dt = 1.0f / subStep.dt;
 		subStep.dtRatio = 1.0f;
+		subStep.stepCount = 1;
 		subStep.positionIterations = 20;
 		subStep.velocityIterations = step.velocityIterations;
 		subStep.warmStarting = false;
+		subStep.directJoints = false;
 		island.SolveTOI(subStep, bA->m_islandIndex, bB->m_islandIndex);
 
 		// Reset island flags and synchronize broad-phase proxies.
@@ -894,10 +1220,106 @@ void b2World::SolveTOI(const b2TimeStep& step)
 	}
 }
 
+// Hold each dynamic body with a pending TOI event at its earliest time of impact.
+// The remaining (1 - alpha) of its motion this step is discarded, not made up later.
+// The body keeps its velocity, so it moves on normally in the next step.
+void b2World::DeferTOI()
+{
+	struct b2DeferredBody
+	{
+		b2Body* body;
+		float32 alpha;
+	};
+
+	// Each body gets at most one entry.
+	b2DeferredBody* deferred = (b2DeferredBody*)m_stackAllocator.Allocate(m_bodyCount * sizeof(b2DeferredBody));
+	int32 deferredCount = 0;
+	int32 pendingCount = 0;
+
+	for (b2Contact* c = m_contactManager.m_contactList; c; c = c->m_next)
+	{
+		if ((c->m_flags & b2Contact::e_toiFlag) == 0 || c->m_toi >= 1.0f || c->IsEnabled() == false)
+		{
+			continue;
+		}
+
+		b2Body* bodies[2] = {c->GetFixtureA()->GetBody(), c->GetFixtureB()->GetBody()};
+
+		// Resting pairs report a TOI of zero but cannot tunnel.
+		const b2Sweep& sweepA = bodies[0]->m_sweep;
+		const b2Sweep& sweepB = bodies[1]->m_sweep;
+		bool stillA = sweepA.c0 == sweepA.c && sweepA.a0 == sweepA.a;
+		bool stillB = sweepB.c0 == sweepB.c && sweepB.a0 == sweepB.a;
+		if (stillA && stillB)
+		{
+			continue;
+		}
+
+		c->m_flags |= b2Contact::e_islandFlag;
+		++pendingCount;
+
+		for (int32 i = 0; i < 2; ++i)
+		{
+			b2Body* b = bodies[i];
+			if (b->m_type != b2_dynamicBody)
+			{
+				continue;
+			}
+
+			// The island flag marks bodies that already have an entry.
+			if (b->m_flags & b2Body::e_islandFlag)
+			{
+				b2DeferredBody* entry = deferred + b->m_islandIndex;
+				entry->alpha = b2Min(entry->alpha, c->m_toi);
+				continue;
+			}
+
+			b2Assert(deferredCount < m_bodyCount);
+			b->m_flags |= b2Body::e_islandFlag;
+			b->m_islandIndex = deferredCount;
+			deferred[deferredCount].body = b;
+			deferred[deferredCount].alpha = c->m_toi;
+			++deferredCount;
+		}
+	}
+
+	for (int32 i = 0; i < deferredCount; ++i)
+	{
+		b2Body* b = deferred[i].body;
+		b->m_flags &= ~b2Body::e_islandFlag;
+		b->Advance(deferred[i].alpha);
+		b->SynchronizeFixtures();
+	}
+
+	m_stackAllocator.Free(deferred);
+
+	// Update the contact points at the held poses. Pending contacts then usually touch,
+	// so the regular solver stops the bodies on the next step.
+	for (b2Contact* c = m_contactManager.m_contactList; c; c = c->m_next)
+	{
+		if (c->m_flags & b2Contact::e_islandFlag)
+		{
+			c->m_flags &= ~b2Contact::e_islandFlag;
+			m_contactManager.Update(c);
+		}
+	}
+
+	m_contactManager.FindNewContacts();
+
+	m_profile.deferredTOIContacts = pendingCount;
+	m_profile.deferredTOIBodies = deferredCount;
+}
+
 void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIterations)
 {
 	b2Timer stepTimer;
 
+	int32 reinsertCount0 = m_contactManager.m_broadPhase.GetReinsertCount();
+	int32 falsePairCount0 = m_contactManager.m_falsePairCount;
+	int32 revivalCount0 = m_contactManager.m_revivalCount;
+
+	m_contactManager.ClearStepEvents();
+
 	// If new fixtures were added, we need to find the new contacts.
 	if (m_flags & e_newFixture)
 	{
@@ -921,8 +1343,10 @@ void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIteration
 	}
 
 	step.dtRatio = m_inv_dt0 * dt;
+	step.stepCount = 1;
 
 	step.warmStarting = m_warmStarting;
+	step.directJoints = m_directJointSolver;
 	
 	// Update contacts. This is where some contacts are destroyed.
 	{
@@ -931,6 +1355,13 @@ void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIteration
 		m_profile.collide = timer.GetMilliseconds();
 	}
 
+	// Update sensor overlaps.
+	{
+		b2Timer timer;
+		m_contactManager.UpdateSensors();
+		m_profile.sensors = timer.GetMilliseconds();
+	}
+
 	// Integrate velocities, solve velocity constraints, and integrate positions.
 	if (m_stepComplete && step.dt > 0.0f)
 	{
@@ -940,6 +1371,9 @@ void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIteration
 	}
 
 	// Handle TOI events.
+	m_profile.toiEvents = 0;
+	m_profile.deferredTOIContacts = 0;
+	m_profile.deferredTOIBodies = 0;
 	if (m_continuousPhysics && step.dt > 0.0f)
 	{
 		b2Timer timer;
@@ -959,9 +1393,73 @@ void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIteration
 
 	m_flags &= ~e_locked;
 
+	m_profile.proxyReinserts = m_contactManager.m_broadPhase.GetReinsertCount() - reinsertCount0;
+	m_profile.falsePairs = m_contactManager.m_falsePairCount - falsePairCount0;
+	m_profile.contactRevivals = m_contactManager.m_revivalCount - revivalCount0;
+
+	m_contactManager.MarkStepEvents();
+
 	m_profile.step = stepTimer.GetMilliseconds();
 }
 
+void b2World::SetAsyncStepping(bool flag)
+{
+	if (flag == (m_stepThread != NULL))
+	{
+		return;
+	}
+
+	if (flag)
+	{
+		void* mem = b2Alloc(sizeof(b2StepThread));
+		m_stepThread = new (mem) b2StepThread(this);
+	}
+	else
+	{
+		m_stepThread->Wait();
+		m_stepThread->~b2StepThread();
+		b2Free(m_stepThread);
+		m_stepThread = NULL;
+	}
+}
+
+void b2World::StepAsync(float32 dt, int32 velocityIterations, int32 positionIterations)
+{
+	if (m_stepThread == NULL)
+	{
+		Step(dt, velocityIterations, positionIterations);
+		return;
+	}
+
+	m_stepThread->Wait();
+	m_stepThread->Prepare();
+	m_stepThread->Start(dt, velocityIterations, positionIterations);
+}
+
+void b2World::Fence()
+{
+	if (m_stepThread)
+	{
+		m_stepThread->Wait();
+	}
+}
+
+bool b2World::IsStepping() const
+{
+	return m_stepThread != NULL && m_stepThread->IsBusy();
+}
+
+const b2Transform& b2World::GetStepTransform(const b2Body* body) const
+{
+	// Bodies created since the last StepAsync have no published state yet.
+	if (m_stepThread == NULL || body->m_stateIndex == -1)
+	{
+		return body->GetTransform();
+	}
+
+	return m_stepThread->GetTransform(body->m_stateIndex);
+}
+
 void b2World::ClearForces()
 {
 	for (b2Body* body = m_bodyList; body; body = body->GetNext())
@@ -1000,7 +1498,17 @@ struct b2WorldRayCastWrapper
 		b2Fixture* fixture = proxy->fixture;
 		int32 index = proxy->childIndex;
 		b2RayCastOutput output;
-		bool hit = fixture->RayCast(&output, input, index);
+		bool hit;
+		const b2Shape* shape = fixture->GetShape();
+		if (shape->m_type == b2Shape::e_chain && ((b2ChainShape*)shape)->HasEdgeTree())
+		{
+			// A mesh has one proxy for all edges. Report the closest edge.
+			hit = ((b2ChainShape*)shape)->RayCastEdges(&output, input, fixture->GetBody()->GetTransform());
+		}
+		else
+		{
+			hit = fixture->RayCast(&output, input, index);
+		}
 
 		if (hit)
 		{
@@ -1028,6 +1536,213 @@ void b2World::RayCast(b2RayCastCallback* callback, const b2Vec2& point1, const b
 	m_contactManager.m_broadPhase.RayCast(&wrapper, input);
 }
 
+// Sweeps the fixtures of one body against the static and sleeping fixtures
+// reported by the broad-phase and keeps the earliest time of impact.
+struct b2TrajectoryCallback
+{
+	bool QueryCallback(int32 proxyId);
+	void SweepChild(b2Fixture* fixture, int32 childIndex);
+
+	const b2BroadPhase* broadPhase;
+	b2ContactFilter* filter;
+	b2Body* body;
+	b2Sweep sweep;
+	b2AABB aabb;
+	float32 t;
+};
+
+struct b2TrajectoryEdgeCallback
+{
+	bool QueryCallback(int32 edgeIndex)
+	{
+		trajectory->SweepChild(mesh, edgeIndex);
+		return true;
+	}
+
+	b2TrajectoryCallback* trajectory;
+	b2Fixture* mesh;
+};
+
+bool b2TrajectoryCallback::QueryCallback(int32 proxyId)
+{
+	b2FixtureProxy* proxy = (b2FixtureProxy*)broadPhase->GetUserData(proxyId);
+	b2Fixture* fixture = proxy->fixture;
+	b2Body* other = fixture->GetBody();
+
+	// Awake bodies move during the prediction, so only solid resting geometry counts.
+	if (other == body || fixture->IsSensor())
+	{
+		return true;
+	}
+
+	if (other->GetType() != b2_staticBody && other->IsAwake())
+	{
+		return true;
+	}
+
+	for (b2JointEdge* je = body->GetJointList(); je; je = je->next)
+	{
+		if (je->other == other && je->joint->GetCollideConnected() == false)
+		{
+			return true;
+		}
+	}
+
+	const b2Shape* shape = fixture->GetShape();
+	if (shape->m_type == b2Shape::e_chain && ((b2ChainShape*)shape)->HasEdgeTree())
+	{
+		b2TrajectoryEdgeCallback callback;
+		callback.trajectory = this;
+		callback.mesh = fixture;
+		((b2ChainShape*)shape)->QueryEdges(&callback, aabb, other->GetTransform());
+	}
+	else
+	{
+		SweepChild(fixture, proxy->childIndex);
+	}
+
+	// Stop the query once the body hits at the start of the step.
+	return t > 0.0f;
+}
+
+void b2TrajectoryCallback::SweepChild(b2Fixture* fixture, int32 childIndex)
+{
+	b2Body* other = fixture->GetBody();
+
+	b2TOIInput input;
+	input.proxyB.Set(fixture->GetShape(), childIndex);
+	input.sweepA = sweep;
+	input.sweepB.localCenter = other->GetLocalCenter();
+	input.sweepB.c0 = other->GetWorldCenter();
+	input.sweepB.c = input.sweepB.c0;
+	input.sweepB.a0 = other->GetAngle();
+	input.sweepB.a = input.sweepB.a0;
+	input.sweepB.alpha0 = 0.0f;
+
+	for (b2Fixture* f = body->GetFixtureList(); f; f = f->GetNext())
+	{
+		if (f->IsSensor() || filter->ShouldCollide(f, fixture) == false)
+		{
+			continue;
+		}
+
+		int32 childCount = f->GetShape()->GetChildCount();
+		for (int32 i = 0; i < childCount; ++i)
+		{
+			input.proxyA.Set(f->GetShape(), i);
+			input.tMax = t;
+
+			b2TOIOutput output;
+			b2TimeOfImpact(&output, &input);
+
+			if (output.state == b2TOIOutput::e_touching && output.t < t)
+			{
+				t = output.t;
+			}
+		}
+	}
+}
+
+int32 b2World::PredictTrajectory(b2Body* body, int32 stepCount, float32 timeStep, b2Vec2* points) const
+{
+	b2Assert(IsStepping() == false);
+	if (IsStepping() || body->GetType() != b2_dynamicBody || timeStep <= 0.0f)
+	{
+		return 0;
+	}
+
+	float32 h = timeStep;
+	b2Sweep sweep = body->m_sweep;
+	b2Vec2 v = body->m_linearVelocity;
+	float32 w = body->m_angularVelocity;
+
+	b2TrajectoryCallback callback;
+	callback.broadPhase = &m_contactManager.m_broadPhase;
+	callback.filter = m_contactManager.m_contactFilter;
+	callback.body = body;
+
+	for (int32 i = 0; i < stepCount; ++i)
+	{
+		// Integrate the same way as b2Island::Solve, without constraints.
+		v += h * (body->m_gravityScale * m_gravity + body->m_invMass * body->m_force);
+		w += h * body->m_invI * body->m_torque;
+		v *= 1.0f / (1.0f + h * body->m_linearDamping);
+		w *= 1.0f / (1.0f + h * body->m_angularDamping);
+
+		b2Vec2 translation = h * v;
+		if (b2Dot(translation, translation) > b2_maxTranslationSquared)
+		{
+			v *= b2_maxTranslation / translation.Length();
+		}
+
+		float32 rotation = h * w;
+		if (rotation * rotation > b2_maxRotationSquared)
+		{
+			w *= b2_maxRotation / b2Abs(rotation);
+		}
+
+		sweep.c0 = sweep.c;
+		sweep.a0 = sweep.a;
+		sweep.alpha0 = 0.0f;
+		sweep.c += h * v;
+		sweep.a += h * w;
+
+		// Bound the swept fixtures.
+		b2Transform xf0, xf1;
+		sweep.GetTransform(&xf0, 0.0f);
+		sweep.GetTransform(&xf1, 1.0f);
+
+		bool first = true;
+		for (const b2Fixture* f = body->GetFixtureList(); f; f = f->GetNext())
+		{
+			if (f->IsSensor())
+			{
+				continue;
+			}
+
+			int32 childCount = f->GetShape()->GetChildCount();
+			for (int32 j = 0; j < childCount; ++j)
+			{
+				b2AABB aabb0, aabb1;
+				f->GetShape()->ComputeAABB(&aabb0, xf0, j);
+				f->GetShape()->ComputeAABB(&aabb1, xf1, j);
+				aabb0.Combine(aabb1);
+
+				if (first)
+				{
+					callback.aabb = aabb0;
+					first = false;
+				}
+				else
+				{
+					callback.aabb.Combine(aabb0);
+				}
+			}
+		}
+
+		if (first == false)
+		{
+			callback.sweep = sweep;
+			callback.t = 1.0f;
+			m_contactManager.m_broadPhase.Query(&callback, callback.aabb);
+
+			if (callback.t < 1.0f)
+			{
+				b2Transform xf;
+				sweep.GetTransform(&xf, callback.t);
+				points[i] = xf.p;
+				return i + 1;
+			}
+		}
+
+		b2Transform xf;
+		sweep.GetTransform(&xf, 1.0f);
+		points[i] = xf.p;
+	}
+
+	return stepCount;
+}
+
 void b2World::DrawShape(b2Fixture* fixture, const b2Transform& xf, const b2Color& color)
 {
 	switch (fixture->GetType())
@@ -1256,6 +1971,17 @@ float32 b2World::GetTreeQuality() const
 	return m_contactManager.m_broadPhase.GetTreeQuality();
 }
 
+void b2World::RebuildBroadPhase(bool bottomUp)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return;
+	}
+
+	m_contactManager.m_broadPhase.RebuildTree(bottomUp);
+}
+
 void b2World::ShiftOrigin(const b2Vec2& newOrigin)
 {
 	b2Assert((m_flags & e_locked) == 0);
@@ -1269,6 +1995,16 @@ void b2World::ShiftOrigin(const b2Vec2& newOrigin)
 		b->m_xf.p -= newOrigin;
 		b->m_sweep.c0 -= newOrigin;
 		b->m_sweep.c -= newOrigin;
+		b->m_lodCenter0 -= newOrigin;
+
+		for (b2Fixture* f = b->m_fixtureList; f; f = f->m_next)
+		{
+			for (int32 i = 0; i < f->m_proxyCount; ++i)
+			{
+				f->m_proxies[i].aabb.lowerBound -= newOrigin;
+				f->m_proxies[i].aabb.upperBound -= newOrigin;
+			}
+		}
 	}
 
 	for (b2Joint* j = m_jointList; j; j = j->m_next)
@@ -1277,6 +2013,216 @@ void b2World::ShiftOrigin(const b2Vec2& newOrigin)
 	}
 
 	m_contactManager.m_broadPhase.ShiftOrigin(newOrigin);
+
+	m_rateCenter -= newOrigin;
+
+	m_origin += newOrigin;
+}
+
+// Map a pointer into the blocks of the source world to the cloned object.
+template <typename T>
+static inline T* b2Relocate(const b2BlockAllocator* allocator, T* p)
+{
+	return (T*)allocator->Relocate(p);
+}
+
+void b2World::RelocateContacts(const b2BlockAllocator* allocator, b2Contact* list)
+{
+	for (b2Contact* c = list; c; c = c->m_next)
+	{
+		b2Contact* clone = b2Relocate(allocator, c);
+		clone->m_prev = b2Relocate(allocator, c->m_prev);
+		clone->m_next = b2Relocate(allocator, c->m_next);
+
+		clone->m_nodeA.contact = clone;
+		clone->m_nodeA.other = b2Relocate(allocator, c->m_nodeA.other);
+		clone->m_nodeA.prev = b2Relocate(allocator, c->m_nodeA.prev);
+		clone->m_nodeA.next = b2Relocate(allocator, c->m_nodeA.next);
+
+		clone->m_nodeB.contact = clone;
+		clone->m_nodeB.other = b2Relocate(allocator, c->m_nodeB.other);
+		clone->m_nodeB.prev = b2Relocate(allocator, c->m_nodeB.prev);
+		clone->m_nodeB.next = b2Relocate(allocator, c->m_nodeB.next);
+
+		clone->m_fixtureA = b2Relocate(allocator, c->m_fixtureA);
+		clone->m_fixtureB = b2Relocate(allocator, c->m_fixtureB);
+	}
+}
+
+b2World* b2World::Clone() const
+{
+	b2Assert(IsLocked() == false);
+	b2Assert(IsStepping() == false);
+	if (IsLocked())
+	{
+		return NULL;
+	}
+
+	b2World* world = new b2World(m_gravity);
+
+	// Copy all bodies, fixtures, shapes, contacts and joints at once. Then fix
+	// up the pointers.
+	b2BlockAllocator* allocator = &world->m_blockAllocator;
+	allocator->BeginCopy(m_blockAllocator);
+
+	const b2ContactManager& sourceManager = m_contactManager;
+	b2ContactManager& manager = world->m_contactManager;
+	manager.m_broadPhase.Copy(sourceManager.m_broadPhase);
+
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		b2Body* body = b2Relocate(allocator, b);
+		body->m_world = world;
+		body->m_prev = b2Relocate(allocator, b->m_prev);
+		body->m_next = b2Relocate(allocator, b->m_next);
+		body->m_fixtureList = b2Relocate(allocator, b->m_fixtureList);
+		body->m_jointList = b2Relocate(allocator, b->m_jointList);
+		body->m_contactList = b2Relocate(allocator, b->m_contactList);
+		body->m_stateIndex = -1;
+
+		for (b2Fixture* f = b->m_fixtureList; f; f = f->m_next)
+		{
+			b2Fixture* fixture = b2Relocate(allocator, f);
+			fixture->m_next = b2Relocate(allocator, f->m_next);
+			fixture->m_body = body;
+			fixture->m_shape = b2Relocate(allocator, f->m_shape);
+			fixture->m_sensorPairList = b2Relocate(allocator, f->m_sensorPairList);
+			fixture->m_visitorPairList = b2Relocate(allocator, f->m_visitorPairList);
+
+			// Chain vertices and edge trees are in the block allocator, but large
+			// vertex arrays are not copied.
+			if (f->m_shape->m_type == b2Shape::e_chain)
+			{
+				const b2ChainShape* chain = (const b2ChainShape*)f->m_shape;
+				b2ChainShape* cloneChain = (b2ChainShape*)fixture->m_shape;
+				cloneChain->m_allocator = allocator;
+
+				int32 vertexSize = chain->m_count * sizeof(b2Vec2);
+				if (vertexSize > b2_maxBlockSize)
+				{
+					cloneChain->m_vertices = (b2Vec2*)allocator->Allocate(vertexSize);
+					memcpy(cloneChain->m_vertices, chain->m_vertices, vertexSize);
+				}
+				else
+				{
+					cloneChain->m_vertices = b2Relocate(allocator, chain->m_vertices);
+				}
+
+				if (chain->m_edgeTree)
+				{
+					cloneChain->m_edgeTree = b2Relocate(allocator, chain->m_edgeTree);
+					cloneChain->m_edgeTree->Relocate(allocator);
+				}
+			}
+
+			// Large proxy arrays are allocated with b2Alloc.
+			int32 childCount = f->m_meshProxy ? 1 : f->m_shape->GetChildCount();
+			int32 proxySize = childCount * sizeof(b2FixtureProxy);
+			if (proxySize > b2_maxBlockSize)
+			{
+				fixture->m_proxies = (b2FixtureProxy*)allocator->Allocate(proxySize);
+				memcpy(fixture->m_proxies, f->m_proxies, proxySize);
+			}
+			else
+			{
+				fixture->m_proxies = b2Relocate(allocator, f->m_proxies);
+			}
+
+			for (int32 i = 0; i < fixture->m_proxyCount; ++i)
+			{
+				b2FixtureProxy* proxy = fixture->m_proxies + i;
+				proxy->fixture = fixture;
+				manager.m_broadPhase.SetUserData(proxy->proxyId, proxy);
+			}
+		}
+	}
+
+	for (b2Joint* j = m_jointList; j; j = j->m_next)
+	{
+		b2Joint* joint = b2Relocate(allocator, j);
+		joint->m_prev = b2Relocate(allocator, j->m_prev);
+		joint->m_next = b2Relocate(allocator, j->m_next);
+
+		joint->m_edgeA.joint = joint;
+		joint->m_edgeA.other = b2Relocate(allocator, j->m_edgeA.other);
+		joint->m_edgeA.prev = b2Relocate(allocator, j->m_edgeA.prev);
+		joint->m_edgeA.next = b2Relocate(allocator, j->m_edgeA.next);
+
+		joint->m_edgeB.joint = joint;
+		joint->m_edgeB.other = b2Relocate(allocator, j->m_edgeB.other);
+		joint->m_edgeB.prev = b2Relocate(allocator, j->m_edgeB.prev);
+		joint->m_edgeB.next = b2Relocate(allocator, j->m_edgeB.next);
+
+		joint->m_bodyA = b2Relocate(allocator, j->m_bodyA);
+		joint->m_bodyB = b2Relocate(allocator, j->m_bodyB);
+
+		if (j->m_type == e_gearJoint)
+		{
+			const b2GearJoint* gear = (const b2GearJoint*)j;
+			b2GearJoint* cloneGear = (b2GearJoint*)joint;
+			cloneGear->m_joint1 = b2Relocate(allocator, gear->m_joint1);
+			cloneGear->m_joint2 = b2Relocate(allocator, gear->m_joint2);
+			cloneGear->m_bodyC = b2Relocate(allocator, gear->m_bodyC);
+			cloneGear->m_bodyD = b2Relocate(allocator, gear->m_bodyD);
+		}
+	}
+
+	RelocateContacts(allocator, sourceManager.m_contactList);
+	RelocateContacts(allocator, sourceManager.m_poolList);
+
+	for (b2SensorPair* p = sourceManager.m_sensorPairList; p; p = p->next)
+	{
+		b2SensorPair* pair = b2Relocate(allocator, p);
+		pair->sensor = b2Relocate(allocator, p->sensor);
+		pair->visitor = b2Relocate(allocator, p->visitor);
+		pair->prev = b2Relocate(allocator, p->prev);
+		pair->next = b2Relocate(allocator, p->next);
+		pair->sensorPrev = b2Relocate(allocator, p->sensorPrev);
+		pair->sensorNext = b2Relocate(allocator, p->sensorNext);
+		pair->visitorPrev = b2Relocate(allocator, p->visitorPrev);
+		pair->visitorNext = b2Relocate(allocator, p->visitorNext);
+	}
+
+	manager.m_contactList = b2Relocate(allocator, sourceManager.m_contactList);
+	manager.m_contactCount = sourceManager.m_contactCount;
+	manager.m_falsePairCount = sourceManager.m_falsePairCount;
+	manager.m_poolList = b2Relocate(allocator, sourceManager.m_poolList);
+	manager.m_poolCount = sourceManager.m_poolCount;
+	manager.m_recycleSteps = sourceManager.m_recycleSteps;
+	manager.m_collideCount = sourceManager.m_collideCount;
+	manager.m_revivalCount = sourceManager.m_revivalCount;
+	manager.m_contactFilter = sourceManager.m_contactFilter;
+	manager.m_sensorPairList = b2Relocate(allocator, sourceManager.m_sensorPairList);
+	manager.m_sensorPairCount = sourceManager.m_sensorPairCount;
+	manager.m_bufferEvents = sourceManager.m_bufferEvents;
+	manager.m_sensorPass = sourceManager.m_sensorPass;
+	manager.m_hitEventThreshold = sourceManager.m_hitEventThreshold;
+
+	world->m_flags = m_flags;
+	world->m_bodyList = b2Relocate(allocator, m_bodyList);
+	world->m_jointList = b2Relocate(allocator, m_jointList);
+	world->m_bodyCount = m_bodyCount;
+	world->m_jointCount = m_jointCount;
+	world->m_allowSleep = m_allowSleep;
+	world->m_sleepSettings = m_sleepSettings;
+	world->m_inv_dt0 = m_inv_dt0;
+	world->m_warmStarting = m_warmStarting;
+	world->m_directJointSolver = m_directJointSolver;
+	world->m_continuousPhysics = m_continuousPhysics;
+	world->m_subStepping = m_subStepping;
+	world->m_stepComplete = m_stepComplete;
+	world->m_toiTimeBudget = m_toiTimeBudget;
+	world->m_toiEventBudget = m_toiEventBudget;
+	world->m_multiRate = m_multiRate;
+	world->m_rateStep = m_rateStep;
+	world->m_rateCenter = m_rateCenter;
+	world->m_rateRadius = m_rateRadius;
+	world->m_profile = m_profile;
+	world->m_origin = m_origin;
+
+	allocator->EndCopy();
+
+	return world;
 }
 
 void b2World::Dump()
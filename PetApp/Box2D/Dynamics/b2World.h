@@ -29,11 +29,13 @@
 struct b2AABB;
 struct b2BodyDef;
 struct b2Color;
+struct b2FixtureDef;
 struct b2JointDef;
 class b2Body;
 class b2Draw;
 class b2Fixture;
 class b2Joint;
+class b2StepThread;
 
 /// The world class manages all physics entities, dynamic simulation,
 /// and asynchronous queries. The world also contains efficient memory
@@ -55,12 +57,74 @@ public:
 	/// Register a contact filter to provide specific control over collision.
 	/// Otherwise the default filter is used (b2_defaultFilter). The listener is
 	/// owned by you and must remain in scope. 
+	/// Note: this disables broad-phase filtering unless filter is b2_defaultFilter.
 	void SetContactFilter(b2ContactFilter* filter);
 
+	/// Enable/disable rejecting pairs by their b2Filter bits inside the broad-phase,
+	/// before contacts are considered. This is enabled for the default contact filter.
+	/// Enable it with a custom filter that only rejects more pairs than the filter bits.
+	void SetBroadPhaseFiltering(bool flag);
+
 	/// Register a contact event listener. The listener is owned by you and must
 	/// remain in scope.
 	void SetContactListener(b2ContactListener* listener);
 
+	/// Enable/disable contact event buffering. When enabled, Step records begin, end
+	/// and hit events into flat arrays instead of calling the contact listener, so no
+	/// listener callbacks (including PreSolve and PostSolve) are made during the step.
+	/// Read the events after Step returns; they are cleared at the start of the next step.
+	/// End events of touching contacts and sensor overlaps that are destroyed between
+	/// steps (DestroyBody, DestroyFixture, SetActive, ...) are reported with the events
+	/// of the next step.
+	void SetContactEventBuffering(bool flag);
+	bool GetContactEventBuffering() const { return m_contactManager.m_bufferEvents; }
+
+	/// Enable/disable the sensor pass. When enabled, sensor fixtures do not create
+	/// contacts. A separate pass tests their broad-phase pairs for shape overlap and
+	/// reports b2ContactListener::BeginSensorOverlap and EndSensorOverlap, or the
+	/// buffered sensor events, instead of BeginContact and EndContact. Sensors then
+	/// do not detect other sensors. Disabled by default.
+	void SetSensorPass(bool flag);
+	bool GetSensorPass() const { return m_contactManager.m_sensorPass; }
+
+	/// Set the approach speed above which a hit event is recorded, in meters per second.
+	void SetHitEventThreshold(float32 speed) { m_contactManager.m_hitEventThreshold = speed; }
+	float32 GetHitEventThreshold() const { return m_contactManager.m_hitEventThreshold; }
+
+	/// Keep contacts whose fixture AABBs stop overlapping for the given number of
+	/// steps. If the pair overlaps again in that time the contact is revived with
+	/// its warm starting impulses instead of being created from scratch. This helps
+	/// bodies that jitter at the edge of their fat AABBs. Zero disables recycling
+	/// and destroys the kept contacts. See b2Profile::contactRevivals.
+	/// @warning kept contacts are removed from the world contact list but stay in
+	/// the body contact lists (b2Body::GetContactList) so they can be found again.
+	/// They never touch. Use b2Contact::IsPooled to skip them.
+	void SetContactRecycling(int32 steps);
+	int32 GetContactRecycling() const { return m_contactManager.m_recycleSteps; }
+
+	/// Get the begin touch events from the last step.
+	const b2ContactBeginEvent* GetContactBeginEvents() const { return m_contactManager.m_beginEvents; }
+	int32 GetContactBeginEventCount() const { return m_contactManager.m_beginEventCount; }
+
+	/// Get the end touch events from the last step, including those of contacts destroyed
+	/// since the step before. Destroyed fixtures leave dangling pointers in these events,
+	/// so identify the fixtures by the user data stored in the events.
+	const b2ContactEndEvent* GetContactEndEvents() const { return m_contactManager.m_endEvents; }
+	int32 GetContactEndEventCount() const { return m_contactManager.m_endEventCount; }
+
+	/// Get the hit events from the last step.
+	const b2ContactHitEvent* GetContactHitEvents() const { return m_contactManager.m_hitEvents; }
+	int32 GetContactHitEventCount() const { return m_contactManager.m_hitEventCount; }
+
+	/// Get the sensor overlap begin events from the last step.
+	const b2SensorEvent* GetSensorBeginEvents() const { return m_contactManager.m_sensorBeginEvents; }
+	int32 GetSensorBeginEventCount() const { return m_contactManager.m_sensorBeginEventCount; }
+
+	/// Get the sensor overlap end events from the last step, including those of pairs
+	/// destroyed since the step before.
+	const b2SensorEvent* GetSensorEndEvents() const { return m_contactManager.m_sensorEndEvents; }
+	int32 GetSensorEndEventCount() const { return m_contactManager.m_sensorEndEventCount; }
+
 	/// Register a routine for debug drawing. The debug draw functions are called
 	/// inside with b2World::DrawDebugData method. The debug draw object is owned
 	/// by you and must remain in scope.
@@ -71,6 +135,19 @@ public:
 	/// @warning This function is locked during callbacks.
 	b2Body* CreateBody(const b2BodyDef* def);
 
+	/// Create many rigid bodies and their fixtures in one call. Broad-phase proxies
+	/// are not inserted one by one; the broad-phase tree is built once at the end.
+	/// Use this for level loading.
+	/// @param bodyDefs array of bodyCount body definitions.
+	/// @param bodyCount the number of bodies to create.
+	/// @param fixtureDefs the fixture definitions of all bodies, grouped by body in order. May be NULL.
+	/// @param fixtureCounts the number of fixture definitions of each body. May be NULL if fixtureDefs is NULL.
+	/// @param bodies optional array of bodyCount pointers receiving the new bodies.
+	/// @warning This function is locked during callbacks.
+	void CreateBodies(const b2BodyDef* bodyDefs, int32 bodyCount,
+					  const b2FixtureDef* fixtureDefs, const int32* fixtureCounts,
+					  b2Body** bodies);
+
 	/// Destroy a rigid body given a definition. No reference to the definition
 	/// is retained. This function is locked during callbacks.
 	/// @warning This automatically deletes all associated shapes and joints.
@@ -95,6 +172,32 @@ public:
 				int32 velocityIterations,
 				int32 positionIterations);
 
+	/// Enable/disable asynchronous stepping. When enabled, StepAsync runs the step on
+	/// a worker thread owned by the world.
+	void SetAsyncStepping(bool flag);
+	bool GetAsyncStepping() const { return m_stepThread != NULL; }
+
+	/// Start a time step and return without waiting for it. This waits for the previous
+	/// step first. While the step runs, do not call any other world, body, fixture or
+	/// joint function except GetStepTransform, IsStepping and Fence. Without
+	/// asynchronous stepping this is the same as Step.
+	void StepAsync(	float32 timeStep,
+					int32 velocityIterations,
+					int32 positionIterations);
+
+	/// Wait for the running step to complete. Call this before applying forces or
+	/// impulses, or changing the world in any other way.
+	void Fence();
+
+	/// Is an asynchronous step running?
+	bool IsStepping() const;
+
+	/// Get the body transform at the end of the last completed step. While a step
+	/// runs this is the transform the step started from, including changes made
+	/// after Fence. This does not lock and may be called while a step runs, from
+	/// the thread that calls StepAsync.
+	const b2Transform& GetStepTransform(const b2Body* body) const;
+
 	/// Manually clear the force buffer on all bodies. By default, forces are cleared automatically
 	/// after each call to Step. The default behavior is modified by calling SetAutoClearForces.
 	/// The purpose of this function is to support sub-stepping. Sub-stepping is often used to maintain
@@ -121,6 +224,18 @@ public:
 	/// @param point2 the ray ending point
 	void RayCast(b2RayCastCallback* callback, const b2Vec2& point1, const b2Vec2& point2) const;
 
+	/// Predict the path of a body without changing the world. Only this body is integrated,
+	/// using its velocity, force, gravity and damping. Its fixtures are swept through the
+	/// broad-phase against the fixtures of static and sleeping bodies. Joints and awake
+	/// bodies are ignored. The prediction stops at the first impact.
+	/// @param body the dynamic body to predict.
+	/// @param stepCount the maximum number of time steps.
+	/// @param timeStep the time step, usually the one passed to Step.
+	/// @param points receives the body origin after each step, at most stepCount points.
+	/// @return the number of points written. If this is less than stepCount, the last
+	/// point is the body origin at the time of impact.
+	int32 PredictTrajectory(b2Body* body, int32 stepCount, float32 timeStep, b2Vec2* points) const;
+
 	/// Get the world body list. With the returned body, use b2Body::GetNext to get
 	/// the next body in the world list. A NULL body indicates the end of the list.
 	/// @return the head of the world body list.
@@ -145,10 +260,45 @@ public:
 	void SetAllowSleeping(bool flag);
 	bool GetAllowSleeping() const { return m_allowSleep; }
 
+	/// Set the thresholds used to put islands to sleep.
+	void SetSleepSettings(const b2SleepSettings& settings) { m_sleepSettings = settings; }
+	const b2SleepSettings& GetSleepSettings() const { return m_sleepSettings; }
+
 	/// Enable/disable warm starting. For testing.
 	void SetWarmStarting(bool flag) { m_warmStarting = flag; }
 	bool GetWarmStarting() const { return m_warmStarting; }
 
+	/// Enable/disable the direct solver for tree-structured joints. Revolute joints
+	/// without an active motor or limit and rigid weld joints that form a tree are
+	/// solved exactly in O(n), so long chains stay stiff at normal iteration counts.
+	/// Joints closing a loop are still solved iteratively.
+	void SetDirectJointSolver(bool flag) { m_directJointSolver = flag; }
+	bool GetDirectJointSolver() const { return m_directJointSolver; }
+
+	/// Enable/disable multi-rate stepping. An island whose bodies all have a rate level
+	/// above zero is then solved every 2^level steps with a time step covering the steps
+	/// since it was last solved. Each level is solved on different steps to spread the cost. Use b2Body::GetInterpolatedTransform
+	/// to draw smoothly.
+	void SetMultiRate(bool flag);
+	bool GetMultiRate() const { return m_multiRate; }
+
+	/// Assign rate levels by distance from a point of interest, such as the view center.
+	/// Bodies within the radius are solved every step, within twice the radius every
+	/// second step and so on up to b2_maxRateLevel. This overrides the levels set on the
+	/// bodies. A radius of zero (the default) keeps the levels set on the bodies.
+	void SetRateFocus(const b2Vec2& center, float32 radius);
+
+	/// Limit the continuous collision work of a step. Once the TOI events of a step take
+	/// longer than the given milliseconds or reach the given count, the remaining events
+	/// are deferred. Each dynamic body with a pending event is held at its earliest time
+	/// of impact, so it does not tunnel. The rest of its motion in that step, (1 - alpha)
+	/// of the time step, is discarded. The body keeps its velocity and moves on normally
+	/// in the next step. At least one event is solved per step. Zero disables a limit.
+	/// See b2Profile::deferredTOIContacts.
+	void SetTOIBudget(float32 milliseconds, int32 eventCount);
+	float32 GetTOITimeBudget() const { return m_toiTimeBudget; }
+	int32 GetTOIEventBudget() const { return m_toiEventBudget; }
+
 	/// Enable/disable continuous physics. For testing.
 	void SetContinuousPhysics(bool flag) { m_continuousPhysics = flag; }
 	bool GetContinuousPhysics() const { return m_continuousPhysics; }
@@ -179,6 +329,17 @@ public:
 	/// The minimum is 1.
 	float32 GetTreeQuality() const;
 
+	/// Enable/disable adaptive fat AABB margins. Each proxy then gets a margin based
+	/// on its size and recent displacement instead of the fixed b2_aabbExtension.
+	/// Existing proxies pick up the new margin the next time they are re-inserted.
+	void SetAdaptiveAABBMargins(bool flag) { m_contactManager.m_broadPhase.SetAdaptiveMargins(flag); }
+	bool GetAdaptiveAABBMargins() const { return m_contactManager.m_broadPhase.GetAdaptiveMargins(); }
+
+	/// Set how many broad-phase leaves are re-inserted per step to keep the dynamic
+	/// tree quality from degrading over long sessions. Zero (the default) disables this.
+	void SetTreeRebalanceIterations(int32 iterations) { m_contactManager.m_broadPhase.SetRebalanceIterations(iterations); }
+	int32 GetTreeRebalanceIterations() const { return m_contactManager.m_broadPhase.GetRebalanceIterations(); }
+
 	/// Change the global gravity vector.
 	void SetGravity(const b2Vec2& gravity);
 	
@@ -194,17 +355,52 @@ public:
 	/// Get the flag that controls automatic clearing of forces after each time step.
 	bool GetAutoClearForces() const;
 
+	/// Rebuild the broad-phase tree from scratch. Call this after a bulk level load so
+	/// the first steps don't pay for a tree shaped by the insertion order.
+	/// @param bottomUp use the agglomerative builder instead of the binned SAH builder.
+	/// @warning This function is locked during callbacks.
+	void RebuildBroadPhase(bool bottomUp = false);
+
 	/// Shift the world origin. Useful for large worlds.
 	/// The body shift formula is: position -= newOrigin
+	/// This visits every body, fixture proxy and joint, so shift rarely, for example
+	/// while a streamed region loads.
 	/// @param newOrigin the new origin with respect to the old origin
 	void ShiftOrigin(const b2Vec2& newOrigin);
 
+	/// Get the double precision position of the current origin. All float32 positions
+	/// in the world are relative to this point. It starts at zero and is moved by ShiftOrigin.
+	const b2Vec2d& GetOrigin() const;
+
+	/// Convert a position relative to the current origin to a double precision position.
+	b2Vec2d GetGlobalPoint(const b2Vec2& localPoint) const;
+
+	/// Convert a double precision position to a position relative to the current origin.
+	b2Vec2 GetLocalPoint(const b2Vec2d& globalPoint) const;
+
 	/// Get the contact manager for testing.
 	const b2ContactManager& GetContactManager() const;
 
 	/// Get the current profile.
 	const b2Profile& GetProfile() const;
 
+	/// Create an independent copy of this world, including the broad-phase tree,
+	/// contacts and warm starting impulses. The storage of the block allocator is
+	/// copied in bulk and the pointers are then fixed up, so this is much faster
+	/// than rebuilding the world. The clone has no listeners or debug draw and
+	/// does not step asynchronously. It shares the contact filter and the user
+	/// data pointers. Delete the clone when done.
+	/// @warning this should be called outside of a time step.
+	b2World* Clone() const;
+
+	/// Destroy all bodies, fixtures, shapes, contacts and joints at once, keeping the
+	/// memory for the next use of the world. No objects are visited, so the destruction
+	/// listener is not called and the cost does not grow with the number of objects.
+	/// Gravity, listeners and settings are kept.
+	/// @warning this should be called outside of a time step. Call Fence first after
+	/// StepAsync.
+	void Reset();
+
 	/// Dump the world into the log file.
 	/// @warning this should be called outside of a time step.
 	void Dump();
@@ -223,9 +419,13 @@ private:
 	friend class b2Fixture;
 	friend class b2ContactManager;
 	friend class b2Controller;
+	friend class b2WorldStreamer;
 
 	void Solve(const b2TimeStep& step);
 	void SolveTOI(const b2TimeStep& step);
+	void DeferTOI();
+
+	static void RelocateContacts(const b2BlockAllocator* allocator, b2Contact* list);
 
 	void DrawJoint(b2Joint* joint);
 	void DrawShape(b2Fixture* shape, const b2Transform& xf, const b2Color& color);
@@ -245,6 +445,7 @@ private:
 
 	b2Vec2 m_gravity;
 	bool m_allowSleep;
+	b2SleepSettings m_sleepSettings;
 
 	b2DestructionListener* m_destructionListener;
 	b2Draw* m_debugDraw;
@@ -255,12 +456,27 @@ private:
 
 	// These are for debugging the solver.
 	bool m_warmStarting;
+	bool m_directJointSolver;
 	bool m_continuousPhysics;
 	bool m_subStepping;
 
 	bool m_stepComplete;
 
+	float32 m_toiTimeBudget;
+	int32 m_toiEventBudget;
+
+	// Multi-rate stepping.
+	bool m_multiRate;
+	int32 m_rateStep;
+	b2Vec2 m_rateCenter;
+	float32 m_rateRadius;
+
 	b2Profile m_profile;
+
+	b2StepThread* m_stepThread;
+
+	// Large world support.
+	b2Vec2d m_origin;
 };
 
 inline b2Body* b2World::GetBodyList()
@@ -351,4 +567,19 @@ inline const b2Profile& b2World::GetProfile() const
 	return m_profile;
 }
 
+inline const b2Vec2d& b2World::GetOrigin() const
+{
+	return m_origin;
+}
+
+inline b2Vec2d b2World::GetGlobalPoint(const b2Vec2& localPoint) const
+{
+	return b2Vec2d(m_origin.x + localPoint.x, m_origin.y + localPoint.y);
+}
+
+inline b2Vec2 b2World::GetLocalPoint(const b2Vec2d& globalPoint) const
+{
+	return b2Vec2(float32(globalPoint.x - m_origin.x), float32(globalPoint.y - m_origin.y));
+}
+
 #endif
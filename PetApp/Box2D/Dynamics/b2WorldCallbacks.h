@@ -19,10 +19,8 @@
 #ifndef B2_WORLD_CALLBACKS_H
 #define B2_WORLD_CALLBACKS_H
 
-#include <Box2D/Common/b2Settings.h>
+#include <Box2D/Common/b2Math.h>
 
-struct b2Vec2;
-struct b2Transform;
 class b2Fixture;
 class b2Body;
 class b2Joint;
@@ -59,6 +57,10 @@ public:
 	virtual bool ShouldCollide(b2Fixture* fixtureA, b2Fixture* fixtureB);
 };
 
+/// The contact filter used by default. It only tests the b2Filter of the fixtures,
+/// which lets the broad-phase reject pairs early (see b2World::SetContactFilter).
+extern b2ContactFilter b2_defaultFilter;
+
 /// Contact impulses for reporting. Impulses are used instead of forces because
 /// sub-step forces may approach infinity for rigid body collisions. These
 /// match up one-to-one with the contact points in b2Manifold.
@@ -69,6 +71,58 @@ struct b2ContactImpulse
 	int32 count;
 };
 
+/// Recorded when two fixtures begin to touch and contact event buffering is enabled.
+/// The point and normal are zero for sensors. The approach speed is the relative
+/// normal velocity at the point, positive when the fixtures move towards each other.
+/// @see b2World::SetContactEventBuffering
+struct b2ContactBeginEvent
+{
+	b2Fixture* fixtureA;
+	b2Fixture* fixtureB;
+	b2Vec2 point;
+	b2Vec2 normal;
+	float32 approachSpeed;
+};
+
+/// Recorded when two fixtures stop touching and contact event buffering is enabled.
+/// The event outlives the contact: if a fixture or its body was destroyed, the fixture
+/// pointer dangles and its memory may already hold a new fixture. Use the user data,
+/// which is copied when the event is recorded, to identify the objects.
+struct b2ContactEndEvent
+{
+	b2Fixture* fixtureA;
+	b2Fixture* fixtureB;
+	void* fixtureUserDataA;
+	void* fixtureUserDataB;
+	void* bodyUserDataA;
+	void* bodyUserDataB;
+};
+
+/// Recorded after the solver when a touching contact was hit faster than the hit
+/// event threshold. This replaces b2ContactListener::PostSolve in buffered mode.
+struct b2ContactHitEvent
+{
+	b2Fixture* fixtureA;
+	b2Fixture* fixtureB;
+	b2Vec2 point;
+	b2Vec2 normal;
+	float32 approachSpeed;
+	float32 maxImpulse;
+};
+
+/// Recorded when a solid fixture begins or ends overlapping a sensor fixture, the
+/// sensor pass is enabled and contact event buffering is enabled. As with b2ContactEndEvent, the fixture pointers
+/// of an end event may dangle, so use the copied user data to identify the objects.
+struct b2SensorEvent
+{
+	b2Fixture* sensor;
+	b2Fixture* visitor;
+	void* sensorUserData;
+	void* visitorUserData;
+	void* sensorBodyUserData;
+	void* visitorBodyUserData;
+};
+
 /// Implement this class to get contact information. You can use these results for
 /// things like sounds and game logic. You can also get contact results by
 /// traversing the contact lists after the time step. However, you might miss
@@ -84,6 +138,7 @@ public:
 	virtual ~b2ContactListener() {}
 
 	/// Called when two fixtures begin to touch.
+	/// Note: with the sensor pass enabled this is not called for sensors, see BeginSensorOverlap.
 	virtual void BeginContact(b2Contact* contact) { B2_NOT_USED(contact); }
 
 	/// Called when two fixtures cease to touch.
@@ -116,6 +171,22 @@ public:
 		B2_NOT_USED(contact);
 		B2_NOT_USED(impulse);
 	}
+
+	/// Called when a solid fixture begins to overlap a sensor fixture and the sensor
+	/// pass is enabled. Sensors then do not create contacts and do not detect other
+	/// sensors. @see b2World::SetSensorPass
+	virtual void BeginSensorOverlap(b2Fixture* sensor, b2Fixture* visitor)
+	{
+		B2_NOT_USED(sensor);
+		B2_NOT_USED(visitor);
+	}
+
+	/// Called when a solid fixture ceases to overlap a sensor fixture.
+	virtual void EndSensorOverlap(b2Fixture* sensor, b2Fixture* visitor)
+	{
+		B2_NOT_USED(sensor);
+		B2_NOT_USED(visitor);
+	}
 };
 
 /// Callback class for AABB queries.
@@ -0,0 +1,301 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Dynamics/b2WorldGroup.h>
+#include <Box2D/Dynamics/b2World.h>
+#include <Box2D/Common/b2Timer.h>
+
+#include <new>
+#include <string.h>
+
+b2WorldGroup::b2WorldGroup(int32 threadCount)
+{
+	m_worlds = NULL;
+	m_worldCount = 0;
+	m_worldCapacity = 0;
+
+	m_threadCount = b2Max(threadCount, 1);
+
+	m_queues = (b2GroupQueue*)b2Alloc(m_threadCount * sizeof(b2GroupQueue));
+	for (int32 i = 0; i < m_threadCount; ++i)
+	{
+		b2GroupQueue* queue = new (m_queues + i) b2GroupQueue;
+		queue->items = NULL;
+		queue->head = 0;
+		queue->tail = 0;
+	}
+
+	m_timeStep = 0.0f;
+	m_velocityIterations = 0;
+	m_positionIterations = 0;
+
+	m_generation = 0;
+	m_activeCount = 0;
+	m_quit = false;
+	m_stealCount.store(0);
+
+	// The thread that calls Step is thread zero.
+	m_threads = NULL;
+	if (m_threadCount > 1)
+	{
+		m_threads = (std::thread*)b2Alloc((m_threadCount - 1) * sizeof(std::thread));
+		for (int32 i = 1; i < m_threadCount; ++i)
+		{
+			new (m_threads + i - 1) std::thread(&b2WorldGroup::Run, this, i);
+		}
+	}
+}
+
+b2WorldGroup::~b2WorldGroup()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_quit = true;
+	}
+	m_startCondition.notify_all();
+
+	for (int32 i = 1; i < m_threadCount; ++i)
+	{
+		m_threads[i - 1].join();
+		m_threads[i - 1].~thread();
+	}
+	b2Free(m_threads);
+
+	for (int32 i = 0; i < m_threadCount; ++i)
+	{
+		b2Free(m_queues[i].items);
+		m_queues[i].~b2GroupQueue();
+	}
+	b2Free(m_queues);
+
+	b2Free(m_worlds);
+}
+
+void b2WorldGroup::Reserve(int32 capacity)
+{
+	if (capacity <= m_worldCapacity)
+	{
+		return;
+	}
+
+	m_worldCapacity = b2Max(capacity, 2 * m_worldCapacity);
+
+	b2GroupWorld* oldWorlds = m_worlds;
+	m_worlds = (b2GroupWorld*)b2Alloc(m_worldCapacity * sizeof(b2GroupWorld));
+	if (oldWorlds)
+	{
+		memcpy(m_worlds, oldWorlds, m_worldCount * sizeof(b2GroupWorld));
+		b2Free(oldWorlds);
+	}
+
+	// Any queue may hold every world.
+	for (int32 i = 0; i < m_threadCount; ++i)
+	{
+		b2Free(m_queues[i].items);
+		m_queues[i].items = (int32*)b2Alloc(m_worldCapacity * sizeof(int32));
+	}
+}
+
+int32 b2WorldGroup::AddWorld(b2World* world)
+{
+	b2Assert(world->GetAsyncStepping() == false);
+
+	Reserve(m_worldCount + 1);
+
+	b2GroupWorld* w = m_worlds + m_worldCount;
+	w->world = world;
+	w->stepTime = 0.0f;
+	w->thread = 0;
+	return m_worldCount++;
+}
+
+void b2WorldGroup::RemoveWorld(b2World* world)
+{
+	for (int32 i = 0; i < m_worldCount; ++i)
+	{
+		if (m_worlds[i].world == world)
+		{
+			m_worlds[i] = m_worlds[m_worldCount - 1];
+			--m_worldCount;
+			return;
+		}
+	}
+
+	// You tried to remove a world that is not in this group.
+	b2Assert(false);
+}
+
+b2World* b2WorldGroup::GetWorld(int32 index) const
+{
+	b2Assert(0 <= index && index < m_worldCount);
+	return m_worlds[index].world;
+}
+
+float32 b2WorldGroup::GetStepTime(int32 index) const
+{
+	b2Assert(0 <= index && index < m_worldCount);
+	return m_worlds[index].stepTime;
+}
+
+int32 b2WorldGroup::GetStepThread(int32 index) const
+{
+	b2Assert(0 <= index && index < m_worldCount);
+	return m_worlds[index].thread;
+}
+
+void b2WorldGroup::Step(float32 timeStep, int32 velocityIterations, int32 positionIterations)
+{
+	if (m_worldCount == 0)
+	{
+		return;
+	}
+
+	m_timeStep = timeStep;
+	m_velocityIterations = velocityIterations;
+	m_positionIterations = positionIterations;
+	m_stealCount.store(0, std::memory_order_relaxed);
+
+	for (int32 i = 0; i < m_threadCount; ++i)
+	{
+		m_queues[i].head = 0;
+		m_queues[i].tail = 0;
+	}
+
+	// Deal the worlds round robin, slowest first. A selection sort is fine
+	// here because the number of worlds is small compared to a step.
+	int32* order = m_queues[0].items;
+	for (int32 i = 0; i < m_worldCount; ++i)
+	{
+		order[i] = i;
+	}
+
+	for (int32 i = 0; i < m_worldCount; ++i)
+	{
+		int32 slowest = i;
+		for (int32 j = i + 1; j < m_worldCount; ++j)
+		{
+			if (m_worlds[order[j]].stepTime > m_worlds[order[slowest]].stepTime)
+			{
+				slowest = j;
+			}
+		}
+		b2Swap(order[i], order[slowest]);
+	}
+
+	// Queue zero is dealt in place. Its index k only moves to k / threadCount.
+	for (int32 i = 0; i < m_worldCount; ++i)
+	{
+		b2GroupQueue* queue = m_queues + i % m_threadCount;
+		queue->items[queue->tail++] = order[i];
+	}
+
+	if (m_threadCount > 1)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		++m_generation;
+		m_activeCount = m_threadCount - 1;
+	}
+	m_startCondition.notify_all();
+
+	Work(0);
+
+	if (m_threadCount > 1)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		while (m_activeCount > 0)
+		{
+			m_doneCondition.wait(lock);
+		}
+	}
+}
+
+void b2WorldGroup::Run(int32 thread)
+{
+	uint32 generation = 0;
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	for (;;)
+	{
+		while (m_generation == generation && m_quit == false)
+		{
+			m_startCondition.wait(lock);
+		}
+
+		if (m_quit)
+		{
+			return;
+		}
+
+		generation = m_generation;
+
+		lock.unlock();
+		Work(thread);
+		lock.lock();
+
+		if (--m_activeCount == 0)
+		{
+			m_doneCondition.notify_all();
+		}
+	}
+}
+
+void b2WorldGroup::Work(int32 thread)
+{
+	int32 index;
+	while (Pop(thread, &index) || Steal(thread, &index))
+	{
+		b2GroupWorld* w = m_worlds + index;
+
+		b2Timer timer;
+		w->world->Step(m_timeStep, m_velocityIterations, m_positionIterations);
+		w->stepTime = timer.GetMilliseconds();
+		w->thread = thread;
+	}
+}
+
+bool b2WorldGroup::Pop(int32 thread, int32* item)
+{
+	// The owner takes the slowest worlds from the front.
+	b2GroupQueue* queue = m_queues + thread;
+	std::lock_guard<std::mutex> lock(queue->mutex);
+	if (queue->head == queue->tail)
+	{
+		return false;
+	}
+
+	*item = queue->items[queue->head++];
+	return true;
+}
+
+bool b2WorldGroup::Steal(int32 thread, int32* item)
+{
+	// Thieves take the fastest worlds from the back.
+	for (int32 i = 1; i < m_threadCount; ++i)
+	{
+		b2GroupQueue* queue = m_queues + (thread + i) % m_threadCount;
+		std::lock_guard<std::mutex> lock(queue->mutex);
+		if (queue->head < queue->tail)
+		{
+			*item = queue->items[--queue->tail];
+			m_stealCount.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+
+	return false;
+}
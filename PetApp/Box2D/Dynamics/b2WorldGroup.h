@@ -0,0 +1,120 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_WORLD_GROUP_H
+#define B2_WORLD_GROUP_H
+
+#include <Box2D/Common/b2Settings.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+class b2World;
+
+/// A world group steps many independent worlds in parallel on a thread pool.
+/// Each thread takes worlds from its own queue and steals from the other queues
+/// when its queue is empty. Worlds are dealt to the queues by their last step
+/// time, so the slow worlds start first. The worlds must not share bodies,
+/// listeners or other state, and must not use asynchronous stepping.
+class b2WorldGroup
+{
+public:
+	/// Construct a group that steps with the given number of threads, including
+	/// the thread that calls Step.
+	b2WorldGroup(int32 threadCount);
+
+	/// Stop the worker threads. The worlds are not destroyed.
+	~b2WorldGroup();
+
+	/// Add a world. The world is owned by you.
+	/// @return the world index.
+	int32 AddWorld(b2World* world);
+
+	/// Remove a world. This changes the index of the last world to the index of
+	/// the removed world.
+	void RemoveWorld(b2World* world);
+
+	/// Get the number of worlds.
+	int32 GetWorldCount() const { return m_worldCount; }
+
+	/// Get a world by index.
+	b2World* GetWorld(int32 index) const;
+
+	/// Get the number of threads, including the thread that calls Step.
+	int32 GetThreadCount() const { return m_threadCount; }
+
+	/// Step all worlds and wait for them. The parameters are passed to b2World::Step.
+	void Step(float32 timeStep, int32 velocityIterations, int32 positionIterations);
+
+	/// Get the time the last Step took for a world, in milliseconds.
+	float32 GetStepTime(int32 index) const;
+
+	/// Get the thread that stepped a world during the last Step.
+	int32 GetStepThread(int32 index) const;
+
+	/// Get the number of worlds stolen from other queues during the last Step.
+	int32 GetStealCount() const { return m_stealCount.load(std::memory_order_relaxed); }
+
+private:
+
+	struct b2GroupWorld
+	{
+		b2World* world;
+		float32 stepTime;
+		int32 thread;
+	};
+
+	struct b2GroupQueue
+	{
+		std::mutex mutex;
+		int32* items;
+		int32 head;
+		int32 tail;
+	};
+
+	void Reserve(int32 capacity);
+	void Run(int32 thread);
+	void Work(int32 thread);
+	bool Pop(int32 thread, int32* item);
+	bool Steal(int32 thread, int32* item);
+
+	b2GroupWorld* m_worlds;
+	int32 m_worldCount;
+	int32 m_worldCapacity;
+
+	b2GroupQueue* m_queues;
+	int32 m_threadCount;
+	std::thread* m_threads;
+
+	float32 m_timeStep;
+	int32 m_velocityIterations;
+	int32 m_positionIterations;
+
+	std::mutex m_mutex;
+	std::condition_variable m_startCondition;
+	std::condition_variable m_doneCondition;
+	uint32 m_generation;
+	int32 m_activeCount;
+	bool m_quit;
+
+	std::atomic<int32> m_stealCount;
+};
+
+#endif
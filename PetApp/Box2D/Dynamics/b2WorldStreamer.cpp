@@ -0,0 +1,1353 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Dynamics/b2WorldStreamer.h>
+#include <Box2D/Dynamics/b2World.h>
+#include <Box2D/Dynamics/b2Body.h>
+#include <Box2D/Dynamics/b2Fixture.h>
+#include <Box2D/Dynamics/Joints/b2DistanceJoint.h>
+#include <Box2D/Dynamics/Joints/b2FrictionJoint.h>
+#include <Box2D/Dynamics/Joints/b2GearJoint.h>
+#include <Box2D/Dynamics/Joints/b2MotorJoint.h>
+#include <Box2D/Dynamics/Joints/b2PrismaticJoint.h>
+#include <Box2D/Dynamics/Joints/b2PulleyJoint.h>
+#include <Box2D/Dynamics/Joints/b2RevoluteJoint.h>
+#include <Box2D/Dynamics/Joints/b2RopeJoint.h>
+#include <Box2D/Dynamics/Joints/b2WeldJoint.h>
+#include <Box2D/Dynamics/Joints/b2WheelJoint.h>
+#include <Box2D/Collision/Shapes/b2CircleShape.h>
+#include <Box2D/Collision/Shapes/b2EdgeShape.h>
+#include <Box2D/Collision/Shapes/b2ChainShape.h>
+#include <Box2D/Collision/Shapes/b2PolygonShape.h>
+
+#include <math.h>
+#include <string.h>
+
+// A snapshot is a sequence of sections, one per unload of the chunk. Each section
+// starts with a header followed by the bodies with their fixtures and then the
+// joints between these bodies. Positions are global, so a snapshot does not depend
+// on the world origin.
+static const int32 b2_snapshotMagic = 0x4b433262;	// "b2CK"
+static const int32 b2_snapshotVersion = 2;
+
+struct b2SnapshotHeader
+{
+	int32 magic;
+	int32 version;
+	int32 size;			// bytes in the section, including this header
+	int32 bodyCount;
+	int32 jointCount;
+	int32 proxyCount;	// broad-phase proxies of the fixtures
+	int32 filterSize;	// bytes of b2FilterBits, see B2_WIDE_FILTER_BITS
+};
+
+struct b2StreamedChunk
+{
+	int32 x, y;
+	int8* data;
+	int32 size;
+};
+
+enum b2SavedBodyFlags
+{
+	e_savedAllowSleep = 0x0001,
+	e_savedAwake = 0x0002,
+	e_savedFixedRotation = 0x0004,
+	e_savedBullet = 0x0008,
+	e_savedActive = 0x0010
+};
+
+// Appends values to a growable buffer.
+struct b2SnapshotWriter
+{
+	b2SnapshotWriter()
+	{
+		data = NULL;
+		size = 0;
+		capacity = 0;
+	}
+
+	void Write(const void* value, int32 count)
+	{
+		if (size + count > capacity)
+		{
+			int32 newCapacity = b2Max(2 * capacity, size + count);
+			newCapacity = b2Max(newCapacity, 256);
+			int8* newData = (int8*)b2Alloc(newCapacity);
+			if (size > 0)
+			{
+				memcpy(newData, data, size);
+			}
+			b2Free(data);
+			data = newData;
+			capacity = newCapacity;
+		}
+
+		memcpy(data + size, value, count);
+		size += count;
+	}
+
+	template <typename T>
+	void Put(const T& value)
+	{
+		Write(&value, sizeof(T));
+	}
+
+	void PutVec2(const b2Vec2& v)
+	{
+		Put(v.x);
+		Put(v.y);
+	}
+
+	// Write a world point in global coordinates.
+	void PutPoint(const b2World* world, const b2Vec2& point)
+	{
+		b2Vec2d p = world->GetGlobalPoint(point);
+		Put(p.x);
+		Put(p.y);
+	}
+
+	void PutBool(bool flag)
+	{
+		int32 value = flag ? 1 : 0;
+		Put(value);
+	}
+
+	void PutPointer(void* pointer)
+	{
+		// Pointers take 64 bits so snapshots do not depend on the pointer size.
+		unsigned long long value = (unsigned long long)(size_t)pointer;
+		Put(value);
+	}
+
+	int8* data;
+	int32 size;
+	int32 capacity;
+};
+
+// Reads values from a buffer. Reading past the end yields zeros and clears ok.
+struct b2SnapshotReader
+{
+	void Read(void* value, int32 count)
+	{
+		if (ok == false || offset + count > size)
+		{
+			ok = false;
+			memset(value, 0, count);
+			return;
+		}
+
+		memcpy(value, data + offset, count);
+		offset += count;
+	}
+
+	template <typename T>
+	T Get()
+	{
+		T value;
+		Read(&value, sizeof(T));
+		return value;
+	}
+
+	b2Vec2 GetVec2()
+	{
+		b2Vec2 v;
+		v.x = Get<float32>();
+		v.y = Get<float32>();
+		return v;
+	}
+
+	// Read a global point and convert it to the world frame. Without a world the
+	// point is only read.
+	b2Vec2 GetPoint(const b2World* world)
+	{
+		b2Vec2d p;
+		p.x = Get<float64>();
+		p.y = Get<float64>();
+		return world ? world->GetLocalPoint(p) : b2Vec2(float32(p.x), float32(p.y));
+	}
+
+	bool GetBool()
+	{
+		return Get<int32>() != 0;
+	}
+
+	void* GetPointer()
+	{
+		return (void*)(size_t)Get<unsigned long long>();
+	}
+
+	const int8* data;
+	int32 size;
+	int32 offset;
+	bool ok;
+};
+
+static void b2WriteShape(b2SnapshotWriter* writer, const b2Shape* shape)
+{
+	writer->Put((int32)shape->m_type);
+	writer->Put(shape->m_radius);
+
+	switch (shape->m_type)
+	{
+	case b2Shape::e_circle:
+		{
+			const b2CircleShape* circle = (const b2CircleShape*)shape;
+			writer->PutVec2(circle->m_p);
+		}
+		break;
+
+	case b2Shape::e_edge:
+		{
+			const b2EdgeShape* edge = (const b2EdgeShape*)shape;
+			writer->PutVec2(edge->m_vertex0);
+			writer->PutVec2(edge->m_vertex1);
+			writer->PutVec2(edge->m_vertex2);
+			writer->PutVec2(edge->m_vertex3);
+			writer->PutBool(edge->m_hasVertex0);
+			writer->PutBool(edge->m_hasVertex3);
+		}
+		break;
+
+	case b2Shape::e_polygon:
+		{
+			const b2PolygonShape* polygon = (const b2PolygonShape*)shape;
+			writer->Put(polygon->m_count);
+			writer->PutVec2(polygon->m_centroid);
+			for (int32 i = 0; i < polygon->m_count; ++i)
+			{
+				writer->PutVec2(polygon->m_vertices[i]);
+				writer->PutVec2(polygon->m_normals[i]);
+			}
+		}
+		break;
+
+	case b2Shape::e_chain:
+		{
+			const b2ChainShape* chain = (const b2ChainShape*)shape;
+			writer->Put(chain->m_count);
+			writer->Write(chain->m_vertices, chain->m_count * sizeof(b2Vec2));
+			writer->PutVec2(chain->m_prevVertex);
+			writer->PutVec2(chain->m_nextVertex);
+			writer->PutBool(chain->m_hasPrevVertex);
+			writer->PutBool(chain->m_hasNextVertex);
+			writer->PutBool(chain->HasEdgeTree());
+		}
+		break;
+
+	default:
+		b2Assert(false);
+		break;
+	}
+}
+
+// Read a shape and create the fixture if body is not NULL.
+static void b2ReadFixture(b2SnapshotReader* reader, b2FixtureDef* def, b2Body* body)
+{
+	b2Shape::Type type = (b2Shape::Type)reader->Get<int32>();
+	float32 radius = reader->Get<float32>();
+
+	switch (type)
+	{
+	case b2Shape::e_circle:
+		{
+			b2CircleShape circle;
+			circle.m_radius = radius;
+			circle.m_p = reader->GetVec2();
+			def->shape = &circle;
+			if (body && reader->ok)
+			{
+				body->CreateFixture(def);
+			}
+		}
+		break;
+
+	case b2Shape::e_edge:
+		{
+			b2EdgeShape edge;
+			edge.m_radius = radius;
+			edge.m_vertex0 = reader->GetVec2();
+			edge.m_vertex1 = reader->GetVec2();
+			edge.m_vertex2 = reader->GetVec2();
+			edge.m_vertex3 = reader->GetVec2();
+			edge.m_hasVertex0 = reader->GetBool();
+			edge.m_hasVertex3 = reader->GetBool();
+			def->shape = &edge;
+			if (body && reader->ok)
+			{
+				body->CreateFixture(def);
+			}
+		}
+		break;
+
+	case b2Shape::e_polygon:
+		{
+			b2PolygonShape polygon;
+			polygon.m_radius = radius;
+			polygon.m_count = reader->Get<int32>();
+			if (polygon.m_count < 3 || polygon.m_count > b2_maxPolygonVertices)
+			{
+				reader->ok = false;
+				break;
+			}
+
+			polygon.m_centroid = reader->GetVec2();
+			for (int32 i = 0; i < polygon.m_count; ++i)
+			{
+				polygon.m_vertices[i] = reader->GetVec2();
+				polygon.m_normals[i] = reader->GetVec2();
+			}
+
+			def->shape = &polygon;
+			if (body && reader->ok)
+			{
+				body->CreateFixture(def);
+			}
+		}
+		break;
+
+	case b2Shape::e_chain:
+		{
+			int32 count = reader->Get<int32>();
+			if (count < 2 || count > (reader->size - reader->offset) / (int32)sizeof(b2Vec2))
+			{
+				reader->ok = false;
+				break;
+			}
+
+			const b2Vec2* vertices = (const b2Vec2*)(reader->data + reader->offset);
+			reader->offset += count * sizeof(b2Vec2);
+
+			b2ChainShape chain;
+			chain.m_radius = radius;
+			chain.m_prevVertex = reader->GetVec2();
+			chain.m_nextVertex = reader->GetVec2();
+			chain.m_hasPrevVertex = reader->GetBool();
+			chain.m_hasNextVertex = reader->GetBool();
+			bool edgeTree = reader->GetBool();
+
+			if (body && reader->ok)
+			{
+				// The vertices may be unaligned in the snapshot.
+				chain.m_vertices = (b2Vec2*)b2Alloc(count * sizeof(b2Vec2));
+				memcpy(chain.m_vertices, vertices, count * sizeof(b2Vec2));
+				chain.m_count = count;
+				if (edgeTree)
+				{
+					chain.CreateEdgeTree();
+				}
+
+				def->shape = &chain;
+				body->CreateFixture(def);
+			}
+		}
+		break;
+
+	default:
+		reader->ok = false;
+		break;
+	}
+
+	def->shape = NULL;
+}
+
+static void b2WriteBody(b2SnapshotWriter* writer, b2Body* body)
+{
+	writer->Put((int32)body->GetType());
+	writer->PutPoint(body->GetWorld(), body->GetPosition());
+	writer->Put(body->GetAngle());
+	writer->PutVec2(body->GetLinearVelocity());
+	writer->Put(body->GetAngularVelocity());
+	writer->Put(body->GetLinearDamping());
+	writer->Put(body->GetAngularDamping());
+	writer->Put(body->GetGravityScale());
+	writer->Put(body->GetRateLevel());
+
+	int32 flags = 0;
+	flags |= body->IsSleepingAllowed() ? e_savedAllowSleep : 0;
+	flags |= body->IsAwake() ? e_savedAwake : 0;
+	flags |= body->IsFixedRotation() ? e_savedFixedRotation : 0;
+	flags |= body->IsBullet() ? e_savedBullet : 0;
+	flags |= body->IsActive() ? e_savedActive : 0;
+	writer->Put(flags);
+	writer->PutPointer(body->GetUserData());
+
+	// Keep mass data that was set by hand.
+	b2MassData massData;
+	body->GetMassData(&massData);
+	writer->Put(massData.mass);
+	writer->PutVec2(massData.center);
+	writer->Put(massData.I);
+
+	int32 fixtureCount = 0;
+	for (b2Fixture* f = body->GetFixtureList(); f; f = f->GetNext())
+	{
+		++fixtureCount;
+	}
+	writer->Put(fixtureCount);
+
+	for (b2Fixture* f = body->GetFixtureList(); f; f = f->GetNext())
+	{
+		const b2Filter& filter = f->GetFilterData();
+		writer->Put(f->GetFriction());
+		writer->Put(f->GetRestitution());
+		writer->Put(f->GetDensity());
+		writer->PutBool(f->IsSensor());
+		writer->Put(filter.categoryBits);
+		writer->Put(filter.maskBits);
+		writer->Put(filter.groupIndex);
+		writer->PutPointer(f->GetUserData());
+		b2WriteShape(writer, f->GetShape());
+	}
+}
+
+// Read a body and create it if world is not NULL.
+static b2Body* b2ReadBody(b2SnapshotReader* reader, b2World* world)
+{
+	b2BodyDef bd;
+	bd.type = (b2BodyType)reader->Get<int32>();
+	bd.position = reader->GetPoint(world);
+	bd.angle = reader->Get<float32>();
+	bd.linearVelocity = reader->GetVec2();
+	bd.angularVelocity = reader->Get<float32>();
+	bd.linearDamping = reader->Get<float32>();
+	bd.angularDamping = reader->Get<float32>();
+	bd.gravityScale = reader->Get<float32>();
+	bd.rateLevel = b2Clamp(reader->Get<int32>(), 0, b2_maxRateLevel);
+
+	int32 flags = reader->Get<int32>();
+	bd.allowSleep = (flags & e_savedAllowSleep) != 0;
+	bd.awake = (flags & e_savedAwake) != 0;
+	bd.fixedRotation = (flags & e_savedFixedRotation) != 0;
+	bd.bullet = (flags & e_savedBullet) != 0;
+	bd.active = (flags & e_savedActive) != 0;
+	bd.userData = reader->GetPointer();
+
+	b2MassData massData;
+	massData.mass = reader->Get<float32>();
+	massData.center = reader->GetVec2();
+	massData.I = reader->Get<float32>();
+
+	int32 fixtureCount = reader->Get<int32>();
+	if (bd.type < b2_staticBody || bd.type > b2_dynamicBody || fixtureCount < 0)
+	{
+		reader->ok = false;
+	}
+
+	b2Body* body = NULL;
+	if (world && reader->ok)
+	{
+		body = world->CreateBody(&bd);
+	}
+
+	for (int32 i = 0; i < fixtureCount && reader->ok; ++i)
+	{
+		b2FixtureDef fd;
+		fd.friction = reader->Get<float32>();
+		fd.restitution = reader->Get<float32>();
+		fd.density = reader->Get<float32>();
+		fd.isSensor = reader->GetBool();
+		fd.filter.categoryBits = reader->Get<b2FilterBits>();
+		fd.filter.maskBits = reader->Get<b2FilterBits>();
+		fd.filter.groupIndex = reader->Get<int16>();
+		fd.userData = reader->GetPointer();
+		b2ReadFixture(reader, &fd, body);
+	}
+
+	if (body && body->GetType() == b2_dynamicBody)
+	{
+		body->SetMassData(&massData);
+	}
+
+	return body;
+}
+
+// Joints refer to bodies and gear joints refer to joints by section index.
+static void b2WriteJoint(b2SnapshotWriter* writer, b2Joint* joint, int32 indexA, int32 indexB,
+						 b2Joint** joints, int32 jointCount)
+{
+	b2Body* bodyA = joint->GetBodyA();
+	b2Body* bodyB = joint->GetBodyB();
+
+	writer->Put((int32)joint->GetType());
+	writer->Put(indexA);
+	writer->Put(indexB);
+	writer->PutBool(joint->GetCollideConnected());
+	writer->PutPointer(joint->GetUserData());
+
+	switch (joint->GetType())
+	{
+	case e_distanceJoint:
+		{
+			b2DistanceJoint* j = (b2DistanceJoint*)joint;
+			writer->PutVec2(j->GetLocalAnchorA());
+			writer->PutVec2(j->GetLocalAnchorB());
+			writer->Put(j->GetLength());
+			writer->Put(j->GetFrequency());
+			writer->Put(j->GetDampingRatio());
+		}
+		break;
+
+	case e_frictionJoint:
+		{
+			b2FrictionJoint* j = (b2FrictionJoint*)joint;
+			writer->PutVec2(j->GetLocalAnchorA());
+			writer->PutVec2(j->GetLocalAnchorB());
+			writer->Put(j->GetMaxForce());
+			writer->Put(j->GetMaxTorque());
+		}
+		break;
+
+	case e_gearJoint:
+		{
+			b2GearJoint* j = (b2GearJoint*)joint;
+			int32 index1 = -1, index2 = -1;
+			for (int32 i = 0; i < jointCount; ++i)
+			{
+				if (joints[i] == j->GetJoint1())
+				{
+					index1 = i;
+				}
+				if (joints[i] == j->GetJoint2())
+				{
+					index2 = i;
+				}
+			}
+			b2Assert(index1 != -1 && index2 != -1);
+			writer->Put(index1);
+			writer->Put(index2);
+			writer->Put(j->GetRatio());
+		}
+		break;
+
+	case e_motorJoint:
+		{
+			b2MotorJoint* j = (b2MotorJoint*)joint;
+			writer->PutVec2(j->GetLinearOffset());
+			writer->Put(j->GetAngularOffset());
+			writer->Put(j->GetMaxForce());
+			writer->Put(j->GetMaxTorque());
+			writer->Put(j->GetCorrectionFactor());
+		}
+		break;
+
+	case e_prismaticJoint:
+		{
+			b2PrismaticJoint* j = (b2PrismaticJoint*)joint;
+			writer->PutVec2(j->GetLocalAnchorA());
+			writer->PutVec2(j->GetLocalAnchorB());
+			writer->PutVec2(j->GetLocalAxisA());
+			writer->Put(j->GetReferenceAngle());
+			writer->PutBool(j->IsLimitEnabled());
+			writer->Put(j->GetLowerLimit());
+			writer->Put(j->GetUpperLimit());
+			writer->PutBool(j->IsMotorEnabled());
+			writer->Put(j->GetMaxMotorForce());
+			writer->Put(j->GetMotorSpeed());
+		}
+		break;
+
+	case e_pulleyJoint:
+		{
+			b2PulleyJoint* j = (b2PulleyJoint*)joint;
+			writer->PutPoint(bodyA->GetWorld(), j->GetGroundAnchorA());
+			writer->PutPoint(bodyA->GetWorld(), j->GetGroundAnchorB());
+			writer->PutVec2(bodyA->GetLocalPoint(j->GetAnchorA()));
+			writer->PutVec2(bodyB->GetLocalPoint(j->GetAnchorB()));
+			writer->Put(j->GetLengthA());
+			writer->Put(j->GetLengthB());
+			writer->Put(j->GetRatio());
+		}
+		break;
+
+	case e_revoluteJoint:
+		{
+			b2RevoluteJoint* j = (b2RevoluteJoint*)joint;
+			writer->PutVec2(j->GetLocalAnchorA());
+			writer->PutVec2(j->GetLocalAnchorB());
+			writer->Put(j->GetReferenceAngle());
+			writer->PutBool(j->IsLimitEnabled());
+			writer->Put(j->GetLowerLimit());
+			writer->Put(j->GetUpperLimit());
+			writer->PutBool(j->IsMotorEnabled());
+			writer->Put(j->GetMotorSpeed());
+			writer->Put(j->GetMaxMotorTorque());
+		}
+		break;
+
+	case e_ropeJoint:
+		{
+			b2RopeJoint* j = (b2RopeJoint*)joint;
+			writer->PutVec2(j->GetLocalAnchorA());
+			writer->PutVec2(j->GetLocalAnchorB());
+			writer->Put(j->GetMaxLength());
+		}
+		break;
+
+	case e_weldJoint:
+		{
+			b2WeldJoint* j = (b2WeldJoint*)joint;
+			writer->PutVec2(j->GetLocalAnchorA());
+			writer->PutVec2(j->GetLocalAnchorB());
+			writer->Put(j->GetReferenceAngle());
+			writer->Put(j->GetFrequency());
+			writer->Put(j->GetDampingRatio());
+		}
+		break;
+
+	case e_wheelJoint:
+		{
+			b2WheelJoint* j = (b2WheelJoint*)joint;
+			writer->PutVec2(j->GetLocalAnchorA());
+			writer->PutVec2(j->GetLocalAnchorB());
+			writer->PutVec2(j->GetLocalAxisA());
+			writer->PutBool(j->IsMotorEnabled());
+			writer->Put(j->GetMaxMotorTorque());
+			writer->Put(j->GetMotorSpeed());
+			writer->Put(j->GetSpringFrequencyHz());
+			writer->Put(j->GetSpringDampingRatio());
+		}
+		break;
+
+	default:
+		b2Assert(false);
+		break;
+	}
+}
+
+static void b2ReadJointBase(b2JointDef* def, b2Body** bodies, int32 indexA, int32 indexB,
+							bool collideConnected, void* userData)
+{
+	def->bodyA = bodies ? bodies[indexA] : NULL;
+	def->bodyB = bodies ? bodies[indexB] : NULL;
+	def->collideConnected = collideConnected;
+	def->userData = userData;
+}
+
+// Read a joint and create it if world is not NULL.
+static b2Joint* b2ReadJoint(b2SnapshotReader* reader, b2World* world, b2Body** bodies, int32 bodyCount,
+							b2Joint** joints, int32 jointCount)
+{
+	b2JointType type = (b2JointType)reader->Get<int32>();
+	int32 indexA = reader->Get<int32>();
+	int32 indexB = reader->Get<int32>();
+	bool collideConnected = reader->GetBool();
+	void* userData = reader->GetPointer();
+
+	if (indexA < 0 || indexA >= bodyCount || indexB < 0 || indexB >= bodyCount)
+	{
+		reader->ok = false;
+		return NULL;
+	}
+
+	b2Body** defBodies = world ? bodies : NULL;
+
+	switch (type)
+	{
+	case e_distanceJoint:
+		{
+			b2DistanceJointDef def;
+			b2ReadJointBase(&def, defBodies, indexA, indexB, collideConnected, userData);
+			def.localAnchorA = reader->GetVec2();
+			def.localAnchorB = reader->GetVec2();
+			def.length = reader->Get<float32>();
+			def.frequencyHz = reader->Get<float32>();
+			def.dampingRatio = reader->Get<float32>();
+			return world && reader->ok ? world->CreateJoint(&def) : NULL;
+		}
+
+	case e_frictionJoint:
+		{
+			b2FrictionJointDef def;
+			b2ReadJointBase(&def, defBodies, indexA, indexB, collideConnected, userData);
+			def.localAnchorA = reader->GetVec2();
+			def.localAnchorB = reader->GetVec2();
+			def.maxForce = reader->Get<float32>();
+			def.maxTorque = reader->Get<float32>();
+			return world && reader->ok ? world->CreateJoint(&def) : NULL;
+		}
+
+	case e_gearJoint:
+		{
+			b2GearJointDef def;
+			b2ReadJointBase(&def, defBodies, indexA, indexB, collideConnected, userData);
+			int32 index1 = reader->Get<int32>();
+			int32 index2 = reader->Get<int32>();
+			def.ratio = reader->Get<float32>();
+			if (index1 < 0 || index1 >= jointCount || index2 < 0 || index2 >= jointCount)
+			{
+				reader->ok = false;
+				return NULL;
+			}
+
+			def.joint1 = joints ? joints[index1] : NULL;
+			def.joint2 = joints ? joints[index2] : NULL;
+			return world && reader->ok ? world->CreateJoint(&def) : NULL;
+		}
+
+	case e_motorJoint:
+		{
+			b2MotorJointDef def;
+			b2ReadJointBase(&def, defBodies, indexA, indexB, collideConnected, userData);
+			def.linearOffset = reader->GetVec2();
+			def.angularOffset = reader->Get<float32>();
+			def.maxForce = reader->Get<float32>();
+			def.maxTorque = reader->Get<float32>();
+			def.correctionFactor = reader->Get<float32>();
+			return world && reader->ok ? world->CreateJoint(&def) : NULL;
+		}
+
+	case e_prismaticJoint:
+		{
+			b2PrismaticJointDef def;
+			b2ReadJointBase(&def, defBodies, indexA, indexB, collideConnected, userData);
+			def.localAnchorA = reader->GetVec2();
+			def.localAnchorB = reader->GetVec2();
+			def.localAxisA = reader->GetVec2();
+			def.referenceAngle = reader->Get<float32>();
+			def.enableLimit = reader->GetBool();
+			def.lowerTranslation = reader->Get<float32>();
+			def.upperTranslation = reader->Get<float32>();
+			def.enableMotor = reader->GetBool();
+			def.maxMotorForce = reader->Get<float32>();
+			def.motorSpeed = reader->Get<float32>();
+			return world && reader->ok ? world->CreateJoint(&def) : NULL;
+		}
+
+	case e_pulleyJoint:
+		{
+			b2PulleyJointDef def;
+			b2ReadJointBase(&def, defBodies, indexA, indexB, collideConnected, userData);
+			def.groundAnchorA = reader->GetPoint(world);
+			def.groundAnchorB = reader->GetPoint(world);
+			def.localAnchorA = reader->GetVec2();
+			def.localAnchorB = reader->GetVec2();
+			def.lengthA = reader->Get<float32>();
+			def.lengthB = reader->Get<float32>();
+			def.ratio = reader->Get<float32>();
+			return world && reader->ok ? world->CreateJoint(&def) : NULL;
+		}
+
+	case e_revoluteJoint:
+		{
+			b2RevoluteJointDef def;
+			b2ReadJointBase(&def, defBodies, indexA, indexB, collideConnected, userData);
+			def.localAnchorA = reader->GetVec2();
+			def.localAnchorB = reader->GetVec2();
+			def.referenceAngle = reader->Get<float32>();
+			def.enableLimit = reader->GetBool();
+			def.lowerAngle = reader->Get<float32>();
+			def.upperAngle = reader->Get<float32>();
+			def.enableMotor = reader->GetBool();
+			def.motorSpeed = reader->Get<float32>();
+			def.maxMotorTorque = reader->Get<float32>();
+			return world && reader->ok ? world->CreateJoint(&def) : NULL;
+		}
+
+	case e_ropeJoint:
+		{
+			b2RopeJointDef def;
+			b2ReadJointBase(&def, defBodies, indexA, indexB, collideConnected, userData);
+			def.localAnchorA = reader->GetVec2();
+			def.localAnchorB = reader->GetVec2();
+			def.maxLength = reader->Get<float32>();
+			return world && reader->ok ? world->CreateJoint(&def) : NULL;
+		}
+
+	case e_weldJoint:
+		{
+			b2WeldJointDef def;
+			b2ReadJointBase(&def, defBodies, indexA, indexB, collideConnected, userData);
+			def.localAnchorA = reader->GetVec2();
+			def.localAnchorB = reader->GetVec2();
+			def.referenceAngle = reader->Get<float32>();
+			def.frequencyHz = reader->Get<float32>();
+			def.dampingRatio = reader->Get<float32>();
+			return world && reader->ok ? world->CreateJoint(&def) : NULL;
+		}
+
+	case e_wheelJoint:
+		{
+			b2WheelJointDef def;
+			b2ReadJointBase(&def, defBodies, indexA, indexB, collideConnected, userData);
+			def.localAnchorA = reader->GetVec2();
+			def.localAnchorB = reader->GetVec2();
+			def.localAxisA = reader->GetVec2();
+			def.enableMotor = reader->GetBool();
+			def.maxMotorTorque = reader->Get<float32>();
+			def.motorSpeed = reader->Get<float32>();
+			def.frequencyHz = reader->Get<float32>();
+			def.dampingRatio = reader->Get<float32>();
+			return world && reader->ok ? world->CreateJoint(&def) : NULL;
+		}
+
+	default:
+		reader->ok = false;
+		return NULL;
+	}
+}
+
+// Check the section headers of a snapshot and count its bodies and proxies.
+static bool b2ScanSnapshot(const int8* data, int32 size, int32* bodyCount, int32* jointCount, int32* proxyCount)
+{
+	*bodyCount = 0;
+	*jointCount = 0;
+	*proxyCount = 0;
+
+	int32 offset = 0;
+	while (offset < size)
+	{
+		b2SnapshotHeader header;
+		if (size - offset < (int32)sizeof(header))
+		{
+			return false;
+		}
+
+		memcpy(&header, data + offset, sizeof(header));
+		if (header.magic != b2_snapshotMagic || header.version != b2_snapshotVersion ||
+			header.size < (int32)sizeof(header) || header.size > size - offset ||
+			header.bodyCount < 0 || header.jointCount < 0 || header.proxyCount < 0 ||
+			header.filterSize != (int32)sizeof(b2FilterBits))
+		{
+			return false;
+		}
+
+		*bodyCount += header.bodyCount;
+		*jointCount = b2Max(*jointCount, header.jointCount);
+		*proxyCount += header.proxyCount;
+		offset += header.size;
+	}
+
+	return true;
+}
+
+// Read all sections of a snapshot. With a NULL world this only validates the data.
+static bool b2ReadSnapshot(const int8* data, int32 size, b2World* world, b2Body** bodies, b2Joint** joints)
+{
+	int32 bodyOffset = 0;
+	int32 offset = 0;
+	while (offset < size)
+	{
+		b2SnapshotHeader header;
+		memcpy(&header, data + offset, sizeof(header));
+
+		b2SnapshotReader reader;
+		reader.data = data + offset;
+		reader.size = header.size;
+		reader.offset = sizeof(header);
+		reader.ok = true;
+
+		b2Body** sectionBodies = bodies ? bodies + bodyOffset : NULL;
+		for (int32 i = 0; i < header.bodyCount && reader.ok; ++i)
+		{
+			b2Body* body = b2ReadBody(&reader, world);
+			if (sectionBodies)
+			{
+				sectionBodies[i] = body;
+			}
+		}
+
+		for (int32 i = 0; i < header.jointCount && reader.ok; ++i)
+		{
+			b2Joint* joint = b2ReadJoint(&reader, world, sectionBodies, header.bodyCount, joints, i);
+			if (joints)
+			{
+				joints[i] = joint;
+			}
+		}
+
+		if (reader.ok == false || reader.offset != reader.size)
+		{
+			return false;
+		}
+
+		bodyOffset += header.bodyCount;
+		offset += header.size;
+	}
+
+	return true;
+}
+
+b2WorldStreamer::b2WorldStreamer(b2World* world, float32 chunkSize)
+{
+	b2Assert(world != NULL);
+	b2Assert(b2IsValid(chunkSize) && chunkSize > 0.0f);
+
+	m_world = world;
+	m_listener = NULL;
+	m_chunkSize = chunkSize;
+
+	m_chunks = NULL;
+	m_chunkCount = 0;
+	m_chunkCapacity = 0;
+}
+
+b2WorldStreamer::~b2WorldStreamer()
+{
+	for (int32 i = 0; i < m_chunkCount; ++i)
+	{
+		b2Free(m_chunks[i].data);
+	}
+	b2Free(m_chunks);
+}
+
+void b2WorldStreamer::GetChunk(int32* x, int32* y, const b2Vec2& point) const
+{
+	GetChunk(x, y, m_world->GetGlobalPoint(point));
+}
+
+void b2WorldStreamer::GetChunk(int32* x, int32* y, const b2Vec2d& globalPoint) const
+{
+	*x = (int32)floor(globalPoint.x / m_chunkSize);
+	*y = (int32)floor(globalPoint.y / m_chunkSize);
+}
+
+int32 b2WorldStreamer::FindChunk(int32 x, int32 y) const
+{
+	for (int32 i = 0; i < m_chunkCount; ++i)
+	{
+		if (m_chunks[i].x == x && m_chunks[i].y == y)
+		{
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+void b2WorldStreamer::RemoveChunk(int32 index)
+{
+	b2Assert(0 <= index && index < m_chunkCount);
+	b2Free(m_chunks[index].data);
+	m_chunks[index] = m_chunks[m_chunkCount - 1];
+	--m_chunkCount;
+}
+
+// Bulk updates rebuild the whole broad-phase tree, so only use them for large changes.
+bool b2WorldStreamer::BeginBulk(int32 proxyCount)
+{
+	b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
+	if (4 * proxyCount < broadPhase->GetProxyCount())
+	{
+		return false;
+	}
+
+	broadPhase->BeginBulkInsert();
+	return true;
+}
+
+void b2WorldStreamer::EndBulk(bool bulk)
+{
+	if (bulk)
+	{
+		m_world->m_contactManager.m_broadPhase.EndBulkInsert();
+	}
+}
+
+int32 b2WorldStreamer::UnloadChunk(int32 x, int32 y)
+{
+	b2Assert(m_world->IsLocked() == false && m_world->IsStepping() == false);
+	if (m_world->IsLocked() || m_world->IsStepping())
+	{
+		return 0;
+	}
+
+	// Gather the bodies. The island flag marks them and the island index is the body
+	// index in the snapshot.
+	b2Body** bodies = (b2Body**)b2Alloc(m_world->GetBodyCount() * sizeof(b2Body*));
+	int32 bodyCount = 0;
+	int32 proxyCount = 0;
+	for (b2Body* b = m_world->GetBodyList(); b; b = b->GetNext())
+	{
+		b->m_flags &= ~b2Body::e_islandFlag;
+
+		int32 bx, by;
+		GetChunk(&bx, &by, b->GetGlobalPosition());
+		if (bx != x || by != y)
+		{
+			continue;
+		}
+
+		if (m_listener && m_listener->ShouldUnload(b) == false)
+		{
+			continue;
+		}
+
+		b->m_flags |= b2Body::e_islandFlag;
+		b->m_islandIndex = bodyCount;
+		bodies[bodyCount++] = b;
+
+		for (b2Fixture* f = b->GetFixtureList(); f; f = f->GetNext())
+		{
+			proxyCount += f->m_proxyCount;
+		}
+	}
+
+	if (bodyCount == 0)
+	{
+		b2Free(bodies);
+		return 0;
+	}
+
+	// Sort the joints. Internal joints connect two unloaded bodies and are saved.
+	// Gear joints are internal if their joints are, and are saved after them.
+	int32 jointCapacity = m_world->GetJointCount();
+	b2Joint** joints = (b2Joint**)b2Alloc(2 * jointCapacity * sizeof(b2Joint*));
+	b2Joint** crossJoints = joints + jointCapacity;
+	int32 jointCount = 0;
+	int32 crossCount = 0;
+
+	for (b2Joint* j = m_world->GetJointList(); j; j = j->GetNext())
+	{
+		if (j->GetType() == e_gearJoint)
+		{
+			continue;
+		}
+
+		bool inA = (j->GetBodyA()->m_flags & b2Body::e_islandFlag) != 0;
+		bool inB = (j->GetBodyB()->m_flags & b2Body::e_islandFlag) != 0;
+		if (inA && inB && j->GetType() != e_mouseJoint)
+		{
+			joints[jointCount++] = j;
+		}
+		else if (inA || inB)
+		{
+			crossJoints[crossCount++] = j;
+		}
+	}
+
+	int32 baseCount = jointCount;
+	int32 crossBaseCount = crossCount;
+	for (b2Joint* j = m_world->GetJointList(); j; j = j->GetNext())
+	{
+		if (j->GetType() != e_gearJoint)
+		{
+			continue;
+		}
+
+		b2GearJoint* gear = (b2GearJoint*)j;
+		int32 internalCount = 0;
+		bool removed = (j->GetBodyA()->m_flags & b2Body::e_islandFlag) || (j->GetBodyB()->m_flags & b2Body::e_islandFlag);
+		for (int32 i = 0; i < baseCount; ++i)
+		{
+			if (joints[i] == gear->GetJoint1() || joints[i] == gear->GetJoint2())
+			{
+				++internalCount;
+			}
+		}
+		for (int32 i = 0; i < crossCount && removed == false; ++i)
+		{
+			removed = crossJoints[i] == gear->GetJoint1() || crossJoints[i] == gear->GetJoint2();
+		}
+
+		if (internalCount == 2)
+		{
+			joints[jointCount++] = j;
+		}
+		else if (removed || internalCount > 0)
+		{
+			crossJoints[crossCount++] = j;
+		}
+	}
+
+	// Write the section.
+	b2SnapshotWriter writer;
+	b2SnapshotHeader header;
+	header.magic = b2_snapshotMagic;
+	header.version = b2_snapshotVersion;
+	header.size = 0;
+	header.bodyCount = bodyCount;
+	header.jointCount = jointCount;
+	header.proxyCount = proxyCount;
+	header.filterSize = sizeof(b2FilterBits);
+	writer.Put(header);
+
+	for (int32 i = 0; i < bodyCount; ++i)
+	{
+		b2WriteBody(&writer, bodies[i]);
+	}
+
+	for (int32 i = 0; i < jointCount; ++i)
+	{
+		b2Joint* j = joints[i];
+		b2WriteJoint(&writer, j, j->GetBodyA()->m_islandIndex, j->GetBodyB()->m_islandIndex, joints, jointCount);
+	}
+
+	header.size = writer.size;
+	memcpy(writer.data, &header, sizeof(header));
+
+	// Gear joints come last in both arrays and are destroyed before the joints they
+	// use. The destruction listener is not called for unloaded objects.
+	b2DestructionListener* destructionListener = m_world->m_destructionListener;
+	m_world->m_destructionListener = NULL;
+
+	for (int32 i = crossCount - 1; i >= crossBaseCount; --i)
+	{
+		if (m_listener)
+		{
+			m_listener->UnloadJoint(crossJoints[i]);
+		}
+		m_world->DestroyJoint(crossJoints[i]);
+	}
+
+	for (int32 i = jointCount - 1; i >= baseCount; --i)
+	{
+		m_world->DestroyJoint(joints[i]);
+	}
+
+	for (int32 i = crossBaseCount - 1; i >= 0; --i)
+	{
+		if (m_listener)
+		{
+			m_listener->UnloadJoint(crossJoints[i]);
+		}
+		m_world->DestroyJoint(crossJoints[i]);
+	}
+
+	for (int32 i = baseCount - 1; i >= 0; --i)
+	{
+		m_world->DestroyJoint(joints[i]);
+	}
+
+	bool bulk = BeginBulk(proxyCount);
+	for (int32 i = 0; i < bodyCount; ++i)
+	{
+		m_world->DestroyBody(bodies[i]);
+	}
+	EndBulk(bulk);
+
+	m_world->m_destructionListener = destructionListener;
+
+	b2Free(joints);
+	b2Free(bodies);
+
+	// Store the section, after any earlier section of this chunk.
+	int32 index = FindChunk(x, y);
+	if (index == -1)
+	{
+		if (m_chunkCount == m_chunkCapacity)
+		{
+			m_chunkCapacity = m_chunkCapacity == 0 ? 16 : 2 * m_chunkCapacity;
+			b2StreamedChunk* chunks = (b2StreamedChunk*)b2Alloc(m_chunkCapacity * sizeof(b2StreamedChunk));
+			if (m_chunkCount > 0)
+			{
+				memcpy(chunks, m_chunks, m_chunkCount * sizeof(b2StreamedChunk));
+			}
+			b2Free(m_chunks);
+			m_chunks = chunks;
+		}
+
+		b2StreamedChunk* chunk = m_chunks + m_chunkCount++;
+		chunk->x = x;
+		chunk->y = y;
+		chunk->data = writer.data;
+		chunk->size = writer.size;
+	}
+	else
+	{
+		b2StreamedChunk* chunk = m_chunks + index;
+		int8* data = (int8*)b2Alloc(chunk->size + writer.size);
+		memcpy(data, chunk->data, chunk->size);
+		memcpy(data + chunk->size, writer.data, writer.size);
+		b2Free(chunk->data);
+		b2Free(writer.data);
+		chunk->data = data;
+		chunk->size += writer.size;
+	}
+
+	return bodyCount;
+}
+
+int32 b2WorldStreamer::LoadChunk(int32 x, int32 y)
+{
+	b2Assert(m_world->IsLocked() == false && m_world->IsStepping() == false);
+	if (m_world->IsLocked() || m_world->IsStepping())
+	{
+		return 0;
+	}
+
+	int32 index = FindChunk(x, y);
+	if (index == -1)
+	{
+		return 0;
+	}
+
+	const b2StreamedChunk* chunk = m_chunks + index;
+
+	int32 bodyCount, jointCount, proxyCount;
+	bool valid = b2ScanSnapshot(chunk->data, chunk->size, &bodyCount, &jointCount, &proxyCount);
+	b2Assert(valid);
+	if (valid == false)
+	{
+		return 0;
+	}
+
+	b2Body** bodies = (b2Body**)b2Alloc(bodyCount * sizeof(b2Body*));
+	b2Joint** joints = (b2Joint**)b2Alloc(jointCount * sizeof(b2Joint*));
+
+	bool bulk = BeginBulk(proxyCount);
+	valid = b2ReadSnapshot(chunk->data, chunk->size, m_world, bodies, joints);
+	EndBulk(bulk);
+	b2Assert(valid);
+
+	RemoveChunk(index);
+
+	if (m_listener)
+	{
+		m_listener->ChunkLoaded(x, y, bodies, bodyCount);
+	}
+
+	b2Free(joints);
+	b2Free(bodies);
+
+	return bodyCount;
+}
+
+void b2WorldStreamer::Update(const b2Vec2& center, int32 radius)
+{
+	b2Assert(radius >= 0);
+
+	int32 cx, cy;
+	GetChunk(&cx, &cy, center);
+
+	// Find the far chunks with bodies to unload.
+	const int32 stackSize = 64;
+	int32 stackKeys[2 * stackSize];
+	int32* keys = stackKeys;
+	int32 keyCount = 0;
+	int32 keyCapacity = stackSize;
+
+	for (b2Body* b = m_world->GetBodyList(); b; b = b->GetNext())
+	{
+		int32 bx, by;
+		GetChunk(&bx, &by, b->GetGlobalPosition());
+		if (b2Abs(bx - cx) <= radius && b2Abs(by - cy) <= radius)
+		{
+			continue;
+		}
+
+		bool found = false;
+		for (int32 i = 0; i < keyCount && found == false; ++i)
+		{
+			found = keys[2 * i] == bx && keys[2 * i + 1] == by;
+		}
+
+		if (found || (m_listener && m_listener->ShouldUnload(b) == false))
+		{
+			continue;
+		}
+
+		if (keyCount == keyCapacity)
+		{
+			int32* newKeys = (int32*)b2Alloc(4 * keyCapacity * sizeof(int32));
+			memcpy(newKeys, keys, 2 * keyCount * sizeof(int32));
+			if (keys != stackKeys)
+			{
+				b2Free(keys);
+			}
+			keys = newKeys;
+			keyCapacity *= 2;
+		}
+
+		keys[2 * keyCount] = bx;
+		keys[2 * keyCount + 1] = by;
+		++keyCount;
+	}
+
+	for (int32 i = 0; i < keyCount; ++i)
+	{
+		UnloadChunk(keys[2 * i], keys[2 * i + 1]);
+	}
+
+	if (keys != stackKeys)
+	{
+		b2Free(keys);
+	}
+
+	// Load the near chunks. Loading removes the chunk from the array.
+	for (int32 i = 0; i < m_chunkCount;)
+	{
+		const b2StreamedChunk* chunk = m_chunks + i;
+		if (b2Abs(chunk->x - cx) <= radius && b2Abs(chunk->y - cy) <= radius)
+		{
+			LoadChunk(chunk->x, chunk->y);
+		}
+		else
+		{
+			++i;
+		}
+	}
+}
+
+bool b2WorldStreamer::IsUnloaded(int32 x, int32 y) const
+{
+	return FindChunk(x, y) != -1;
+}
+
+const void* b2WorldStreamer::GetSnapshot(int32 x, int32 y, int32* size) const
+{
+	int32 index = FindChunk(x, y);
+	if (index == -1)
+	{
+		*size = 0;
+		return NULL;
+	}
+
+	*size = m_chunks[index].size;
+	return m_chunks[index].data;
+}
+
+bool b2WorldStreamer::SetSnapshot(int32 x, int32 y, const void* data, int32 size)
+{
+	int32 bodyCount, jointCount, proxyCount;
+	if (size <= 0 || b2ScanSnapshot((const int8*)data, size, &bodyCount, &jointCount, &proxyCount) == false)
+	{
+		return false;
+	}
+
+	if (b2ReadSnapshot((const int8*)data, size, NULL, NULL, NULL) == false)
+	{
+		return false;
+	}
+
+	int32 index = FindChunk(x, y);
+	if (index != -1)
+	{
+		RemoveChunk(index);
+	}
+
+	if (m_chunkCount == m_chunkCapacity)
+	{
+		m_chunkCapacity = m_chunkCapacity == 0 ? 16 : 2 * m_chunkCapacity;
+		b2StreamedChunk* chunks = (b2StreamedChunk*)b2Alloc(m_chunkCapacity * sizeof(b2StreamedChunk));
+		if (m_chunkCount > 0)
+		{
+			memcpy(chunks, m_chunks, m_chunkCount * sizeof(b2StreamedChunk));
+		}
+		b2Free(m_chunks);
+		m_chunks = chunks;
+	}
+
+	b2StreamedChunk* chunk = m_chunks + m_chunkCount++;
+	chunk->x = x;
+	chunk->y = y;
+	chunk->data = (int8*)b2Alloc(size);
+	memcpy(chunk->data, data, size);
+	chunk->size = size;
+	return true;
+}
@@ -0,0 +1,134 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_WORLD_STREAMER_H
+#define B2_WORLD_STREAMER_H
+
+#include <Box2D/Common/b2Math.h>
+
+class b2Body;
+class b2Joint;
+class b2World;
+struct b2StreamedChunk;
+
+/// Implement this class to control which bodies are unloaded and to handle
+/// joints that cross chunk borders.
+class b2ChunkListener
+{
+public:
+	virtual ~b2ChunkListener() {}
+
+	/// Return false to keep a body loaded when its chunk is unloaded, for example
+	/// the player or terrain that spans many chunks.
+	virtual bool ShouldUnload(b2Body* body)
+	{
+		B2_NOT_USED(body);
+		return true;
+	}
+
+	/// Called before a joint is destroyed because it connects an unloaded body to a
+	/// body that stays loaded. Mouse joints are always reported here. Record what you
+	/// need to recreate the joint in ChunkLoaded.
+	virtual void UnloadJoint(b2Joint* joint) { B2_NOT_USED(joint); }
+
+	/// Called after a chunk is loaded, with its bodies in the order they were saved.
+	/// Recreate cross-chunk joints here.
+	virtual void ChunkLoaded(int32 x, int32 y, b2Body** bodies, int32 bodyCount)
+	{
+		B2_NOT_USED(x);
+		B2_NOT_USED(y);
+		B2_NOT_USED(bodies);
+		B2_NOT_USED(bodyCount);
+	}
+};
+
+/// A world streamer partitions a world into square chunks and moves whole chunks
+/// in and out of the world. A body belongs to the chunk that contains its origin.
+/// Chunks and saved positions are in global coordinates, so they stay put when the
+/// world origin shifts.
+/// Unloading a chunk saves its bodies, fixtures and the joints between them into a
+/// compact binary snapshot and destroys them. Loading a chunk recreates them.
+/// Large changes insert and remove broad-phase proxies in bulk and rebuild the tree
+/// once. Contacts and joint impulses are not saved, so they warm up again after
+/// loading. User data pointers are saved by value. Snapshots use the byte order of
+/// the host. Do not unload or load chunks while the world is locked or stepping.
+class b2WorldStreamer
+{
+public:
+	/// Construct a streamer for a world. The world is owned by you and must outlive
+	/// the streamer.
+	/// @param chunkSize the side length of a chunk in meters.
+	b2WorldStreamer(b2World* world, float32 chunkSize);
+
+	/// Free all snapshots. This does not change the world.
+	~b2WorldStreamer();
+
+	/// Register a chunk listener. The listener is owned by you and must remain in scope.
+	void SetListener(b2ChunkListener* listener) { m_listener = listener; }
+
+	/// Get the chunk that contains a world point.
+	void GetChunk(int32* x, int32* y, const b2Vec2& point) const;
+
+	/// Get the chunk that contains a global point.
+	void GetChunk(int32* x, int32* y, const b2Vec2d& globalPoint) const;
+
+	/// Unload the bodies of a chunk. If the chunk already has a snapshot, the new
+	/// bodies are added to it.
+	/// @return the number of bodies unloaded.
+	int32 UnloadChunk(int32 x, int32 y);
+
+	/// Load the snapshot of a chunk back into the world and free it.
+	/// @return the number of bodies loaded.
+	int32 LoadChunk(int32 x, int32 y);
+
+	/// Keep the chunks within radius chunks of a point loaded, and unload the bodies
+	/// of all other chunks. Call this when the point moves to another chunk.
+	void Update(const b2Vec2& center, int32 radius);
+
+	/// Does this chunk have a snapshot?
+	bool IsUnloaded(int32 x, int32 y) const;
+
+	/// Get the snapshot of an unloaded chunk, for example to write it to disk.
+	/// @return the snapshot, or NULL if the chunk has none.
+	const void* GetSnapshot(int32 x, int32 y, int32* size) const;
+
+	/// Set the snapshot of a chunk, for example after reading it from disk. This
+	/// replaces any snapshot the chunk has. The data is copied.
+	/// @return false if the data is not a valid snapshot.
+	bool SetSnapshot(int32 x, int32 y, const void* data, int32 size);
+
+	/// Get the number of chunks with a snapshot.
+	int32 GetUnloadedChunkCount() const { return m_chunkCount; }
+
+private:
+
+	int32 FindChunk(int32 x, int32 y) const;
+	void RemoveChunk(int32 index);
+	bool BeginBulk(int32 proxyCount);
+	void EndBulk(bool bulk);
+
+	b2World* m_world;
+	b2ChunkListener* m_listener;
+	float32 m_chunkSize;
+
+	b2StreamedChunk* m_chunks;
+	int32 m_chunkCount;
+	int32 m_chunkCapacity;
+};
+
+#endif
@@ -0,0 +1,504 @@
+/*
+* Copyright (c) 2011 Erin Catto http://box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Rope/b2RopeSystem.h>
+#include <Box2D/Common/b2Draw.h>
+#include <memory.h>
+#include <new>
+
+// Grow an array allocated with b2Alloc, keeping the first count elements.
+template <typename T>
+static void b2Grow(T*& array, int32 count, int32 capacity)
+{
+	T* oldArray = array;
+	array = (T*)b2Alloc(capacity * sizeof(T));
+	if (oldArray)
+	{
+		memcpy(array, oldArray, count * sizeof(T));
+		b2Free(oldArray);
+	}
+}
+
+b2RopeSystem::b2RopeSystem()
+{
+	m_ropes = NULL;
+	m_ropeCount = 0;
+	m_ropeCapacity = 0;
+
+	m_vertexCount = 0;
+	m_vertexCapacity = 0;
+
+	m_px = NULL;
+	m_py = NULL;
+	m_p0x = NULL;
+	m_p0y = NULL;
+	m_vx = NULL;
+	m_vy = NULL;
+	m_ims = NULL;
+	m_Ls = NULL;
+	m_s1 = NULL;
+	m_s2 = NULL;
+	m_as = NULL;
+	m_k3 = NULL;
+
+	m_threadCount = 1;
+	m_threads = NULL;
+	m_rangeBegins = NULL;
+	m_rangeEnds = NULL;
+
+	m_timeStep = 0.0f;
+	m_iterations = 0;
+
+	m_generation = 0;
+	m_activeCount = 0;
+	m_quit = false;
+}
+
+b2RopeSystem::~b2RopeSystem()
+{
+	StopThreads();
+
+	b2Free(m_ropes);
+	b2Free(m_px);
+	b2Free(m_py);
+	b2Free(m_p0x);
+	b2Free(m_p0y);
+	b2Free(m_vx);
+	b2Free(m_vy);
+	b2Free(m_ims);
+	b2Free(m_Ls);
+	b2Free(m_s1);
+	b2Free(m_s2);
+	b2Free(m_as);
+	b2Free(m_k3);
+}
+
+void b2RopeSystem::Reserve(int32 vertexCapacity)
+{
+	if (vertexCapacity <= m_vertexCapacity)
+	{
+		return;
+	}
+
+	vertexCapacity = b2Max(vertexCapacity, 2 * m_vertexCapacity);
+
+	b2Grow(m_px, m_vertexCount, vertexCapacity);
+	b2Grow(m_py, m_vertexCount, vertexCapacity);
+	b2Grow(m_p0x, m_vertexCount, vertexCapacity);
+	b2Grow(m_p0y, m_vertexCount, vertexCapacity);
+	b2Grow(m_vx, m_vertexCount, vertexCapacity);
+	b2Grow(m_vy, m_vertexCount, vertexCapacity);
+	b2Grow(m_ims, m_vertexCount, vertexCapacity);
+	b2Grow(m_Ls, m_vertexCount, vertexCapacity);
+	b2Grow(m_s1, m_vertexCount, vertexCapacity);
+	b2Grow(m_s2, m_vertexCount, vertexCapacity);
+	b2Grow(m_as, m_vertexCount, vertexCapacity);
+	b2Grow(m_k3, m_vertexCount, vertexCapacity);
+
+	m_vertexCapacity = vertexCapacity;
+}
+
+int32 b2RopeSystem::AddRope(const b2RopeDef* def)
+{
+	b2Assert(def->count >= 3);
+
+	if (m_ropeCount == m_ropeCapacity)
+	{
+		m_ropeCapacity = m_ropeCapacity > 0 ? 2 * m_ropeCapacity : 16;
+		b2Grow(m_ropes, m_ropeCount, m_ropeCapacity);
+	}
+
+	int32 count = def->count;
+	int32 offset = m_vertexCount;
+	Reserve(m_vertexCount + count);
+
+	b2RopeRange* rope = m_ropes + m_ropeCount;
+	rope->offset = offset;
+	rope->count = count;
+	rope->gravity = def->gravity;
+	rope->damping = def->damping;
+
+	for (int32 i = 0; i < count; ++i)
+	{
+		int32 j = offset + i;
+		m_px[j] = def->vertices[i].x;
+		m_py[j] = def->vertices[i].y;
+		m_p0x[j] = m_px[j];
+		m_p0y[j] = m_py[j];
+		m_vx[j] = 0.0f;
+		m_vy[j] = 0.0f;
+
+		float32 m = def->masses[i];
+		m_ims[j] = m > 0.0f ? 1.0f / m : 0.0f;
+	}
+
+	for (int32 i = 0; i < count; ++i)
+	{
+		int32 j = offset + i;
+		m_Ls[j] = 0.0f;
+		m_s1[j] = 0.0f;
+		m_s2[j] = 0.0f;
+		m_as[j] = 0.0f;
+		m_k3[j] = 0.0f;
+
+		if (i < count - 1)
+		{
+			b2Vec2 p1 = def->vertices[i];
+			b2Vec2 p2 = def->vertices[i + 1];
+			m_Ls[j] = b2Distance(p1, p2);
+
+			float32 im1 = m_ims[j];
+			float32 im2 = m_ims[j + 1];
+			if (im1 + im2 > 0.0f)
+			{
+				m_s1[j] = def->k2 * im1 / (im1 + im2);
+				m_s2[j] = def->k2 * im2 / (im1 + im2);
+			}
+		}
+
+		if (i < count - 2)
+		{
+			b2Vec2 d1 = def->vertices[i + 1] - def->vertices[i];
+			b2Vec2 d2 = def->vertices[i + 2] - def->vertices[i + 1];
+			m_as[j] = b2Atan2(b2Cross(d1, d2), b2Dot(d1, d2));
+			m_k3[j] = def->k3;
+		}
+	}
+
+	m_vertexCount += count;
+	return m_ropeCount++;
+}
+
+void b2RopeSystem::Clear()
+{
+	m_ropeCount = 0;
+	m_vertexCount = 0;
+}
+
+int32 b2RopeSystem::GetVertexCount(int32 rope) const
+{
+	b2Assert(0 <= rope && rope < m_ropeCount);
+	return m_ropes[rope].count;
+}
+
+b2Vec2 b2RopeSystem::GetVertex(int32 rope, int32 index) const
+{
+	b2Assert(0 <= rope && rope < m_ropeCount);
+	b2Assert(0 <= index && index < m_ropes[rope].count);
+	int32 j = m_ropes[rope].offset + index;
+	return b2Vec2(m_px[j], m_py[j]);
+}
+
+void b2RopeSystem::SetAngle(int32 rope, float32 angle)
+{
+	b2Assert(0 <= rope && rope < m_ropeCount);
+	const b2RopeRange* r = m_ropes + rope;
+	for (int32 i = 0; i < r->count - 2; ++i)
+	{
+		m_as[r->offset + i] = angle;
+	}
+}
+
+void b2RopeSystem::StartThreads(int32 threadCount)
+{
+	StopThreads();
+
+	m_threadCount = threadCount;
+	m_rangeBegins = (int32*)b2Alloc(threadCount * sizeof(int32));
+	m_rangeEnds = (int32*)b2Alloc(threadCount * sizeof(int32));
+
+	m_quit = false;
+	m_threads = (std::thread*)b2Alloc((threadCount - 1) * sizeof(std::thread));
+	for (int32 i = 1; i < threadCount; ++i)
+	{
+		new (m_threads + i - 1) std::thread(&b2RopeSystem::Run, this, i, m_generation);
+	}
+}
+
+void b2RopeSystem::StopThreads()
+{
+	if (m_threads == NULL)
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_quit = true;
+	}
+	m_startCondition.notify_all();
+
+	for (int32 i = 1; i < m_threadCount; ++i)
+	{
+		m_threads[i - 1].join();
+		m_threads[i - 1].~thread();
+	}
+	b2Free(m_threads);
+	b2Free(m_rangeBegins);
+	b2Free(m_rangeEnds);
+
+	m_threads = NULL;
+	m_rangeBegins = NULL;
+	m_rangeEnds = NULL;
+	m_threadCount = 1;
+}
+
+// A worker runs each generation after the one it was started in.
+void b2RopeSystem::Run(int32 thread, uint32 generation)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	for (;;)
+	{
+		while (m_generation == generation && m_quit == false)
+		{
+			m_startCondition.wait(lock);
+		}
+
+		if (m_quit)
+		{
+			return;
+		}
+
+		generation = m_generation;
+
+		lock.unlock();
+		StepRange(m_timeStep, m_iterations, m_rangeBegins[thread], m_rangeEnds[thread]);
+		lock.lock();
+
+		if (--m_activeCount == 0)
+		{
+			m_doneCondition.notify_all();
+		}
+	}
+}
+
+void b2RopeSystem::Step(float32 h, int32 iterations, int32 threadCount)
+{
+	if (threadCount <= 1 || m_ropeCount < 2 * threadCount)
+	{
+		StepRange(h, iterations, 0, m_ropeCount);
+		return;
+	}
+
+	if (threadCount != m_threadCount)
+	{
+		StartThreads(threadCount);
+	}
+
+	// Split the ropes into contiguous ranges with similar vertex counts.
+	int32 ropeBegin = 0;
+	for (int32 t = 0; t < threadCount; ++t)
+	{
+		int32 vertexEnd = (int32)((float64)m_vertexCount * (t + 1) / threadCount);
+		int32 ropeEnd = ropeBegin;
+		while (ropeEnd < m_ropeCount && (t == threadCount - 1 || m_ropes[ropeEnd].offset < vertexEnd))
+		{
+			++ropeEnd;
+		}
+
+		m_rangeBegins[t] = ropeBegin;
+		m_rangeEnds[t] = ropeEnd;
+		ropeBegin = ropeEnd;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_timeStep = h;
+		m_iterations = iterations;
+		++m_generation;
+		m_activeCount = threadCount - 1;
+	}
+	m_startCondition.notify_all();
+
+	StepRange(h, iterations, m_rangeBegins[0], m_rangeEnds[0]);
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (m_activeCount > 0)
+	{
+		m_doneCondition.wait(lock);
+	}
+}
+
+void b2RopeSystem::StepRange(float32 h, int32 iterations, int32 ropeBegin, int32 ropeEnd)
+{
+	if (h == 0.0f || ropeBegin >= ropeEnd)
+	{
+		return;
+	}
+
+	b2Assert(0 <= ropeBegin && ropeEnd <= m_ropeCount);
+
+	int32 begin = m_ropes[ropeBegin].offset;
+	int32 end = m_ropes[ropeEnd - 1].offset + m_ropes[ropeEnd - 1].count;
+
+	for (int32 r = ropeBegin; r < ropeEnd; ++r)
+	{
+		const b2RopeRange* rope = m_ropes + r;
+		float32 d = expf(- h * rope->damping);
+		float32 gx = h * rope->gravity.x;
+		float32 gy = h * rope->gravity.y;
+
+		int32 rBegin = rope->offset;
+		int32 rEnd = rope->offset + rope->count;
+		for (int32 i = rBegin; i < rEnd; ++i)
+		{
+			float32 g = m_ims[i] > 0.0f ? 1.0f : 0.0f;
+			m_p0x[i] = m_px[i];
+			m_p0y[i] = m_py[i];
+			m_vx[i] = d * (m_vx[i] + g * gx);
+			m_vy[i] = d * (m_vy[i] + g * gy);
+			m_px[i] += h * m_vx[i];
+			m_py[i] += h * m_vy[i];
+		}
+	}
+
+	for (int32 i = 0; i < iterations; ++i)
+	{
+		SolveC2(begin, end);
+		SolveC3(begin, end);
+		SolveC2(begin, end);
+	}
+
+	float32 inv_h = 1.0f / h;
+	for (int32 i = begin; i < end; ++i)
+	{
+		m_vx[i] = inv_h * (m_px[i] - m_p0x[i]);
+		m_vy[i] = inv_h * (m_py[i] - m_p0y[i]);
+	}
+}
+
+void b2RopeSystem::SolveC2(int32 begin, int32 end)
+{
+	// Red-black ordering: the segments of one color share no vertices.
+	for (int32 color = 0; color < 2; ++color)
+	{
+		for (int32 i = begin + color; i < end - 1; i += 2)
+		{
+			float32 dx = m_px[i + 1] - m_px[i];
+			float32 dy = m_py[i + 1] - m_py[i];
+			float32 L = sqrtf(dx * dx + dy * dy);
+			float32 invL = L > b2_epsilon ? 1.0f / L : 0.0f;
+
+			// The weights are zero across rope boundaries.
+			float32 C = (m_Ls[i] - L) * invL;
+			float32 c1 = m_s1[i] * C;
+			float32 c2 = m_s2[i] * C;
+
+			m_px[i] -= c1 * dx;
+			m_py[i] -= c1 * dy;
+			m_px[i + 1] += c2 * dx;
+			m_py[i + 1] += c2 * dy;
+		}
+	}
+}
+
+void b2RopeSystem::SolveC3(int32 begin, int32 end)
+{
+	// Three colors: the bends of one color share no vertices.
+	for (int32 color = 0; color < 3; ++color)
+	{
+		for (int32 i = begin + color; i < end - 2; i += 3)
+		{
+			float32 k3 = m_k3[i];
+			if (k3 == 0.0f)
+			{
+				continue;
+			}
+
+			b2Vec2 p1(m_px[i], m_py[i]);
+			b2Vec2 p2(m_px[i + 1], m_py[i + 1]);
+			b2Vec2 p3(m_px[i + 2], m_py[i + 2]);
+
+			float32 m1 = m_ims[i];
+			float32 m2 = m_ims[i + 1];
+			float32 m3 = m_ims[i + 2];
+
+			b2Vec2 d1 = p2 - p1;
+			b2Vec2 d2 = p3 - p2;
+
+			float32 L1sqr = d1.LengthSquared();
+			float32 L2sqr = d2.LengthSquared();
+
+			if (L1sqr * L2sqr == 0.0f)
+			{
+				continue;
+			}
+
+			float32 a = b2Cross(d1, d2);
+			float32 b = b2Dot(d1, d2);
+
+			float32 angle = b2Atan2(a, b);
+
+			b2Vec2 Jd1 = (-1.0f / L1sqr) * d1.Skew();
+			b2Vec2 Jd2 = (1.0f / L2sqr) * d2.Skew();
+
+			b2Vec2 J1 = -Jd1;
+			b2Vec2 J2 = Jd1 - Jd2;
+			b2Vec2 J3 = Jd2;
+
+			float32 mass = m1 * b2Dot(J1, J1) + m2 * b2Dot(J2, J2) + m3 * b2Dot(J3, J3);
+			if (mass == 0.0f)
+			{
+				continue;
+			}
+
+			mass = 1.0f / mass;
+
+			float32 C = angle - m_as[i];
+
+			while (C > b2_pi)
+			{
+				angle -= 2 * b2_pi;
+				C = angle - m_as[i];
+			}
+
+			while (C < -b2_pi)
+			{
+				angle += 2.0f * b2_pi;
+				C = angle - m_as[i];
+			}
+
+			float32 impulse = - k3 * mass * C;
+
+			p1 += (m1 * impulse) * J1;
+			p2 += (m2 * impulse) * J2;
+			p3 += (m3 * impulse) * J3;
+
+			m_px[i] = p1.x;
+			m_py[i] = p1.y;
+			m_px[i + 1] = p2.x;
+			m_py[i + 1] = p2.y;
+			m_px[i + 2] = p3.x;
+			m_py[i + 2] = p3.y;
+		}
+	}
+}
+
+void b2RopeSystem::Draw(b2Draw* draw) const
+{
+	b2Color c(0.4f, 0.5f, 0.7f);
+
+	for (int32 r = 0; r < m_ropeCount; ++r)
+	{
+		const b2RopeRange* rope = m_ropes + r;
+		for (int32 i = rope->offset; i < rope->offset + rope->count - 1; ++i)
+		{
+			draw->DrawSegment(b2Vec2(m_px[i], m_py[i]), b2Vec2(m_px[i + 1], m_py[i + 1]), c);
+		}
+	}
+}
@@ -0,0 +1,136 @@
+/*
+* Copyright (c) 2011 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_ROPE_SYSTEM_H
+#define B2_ROPE_SYSTEM_H
+
+#include <Box2D/Rope/b2Rope.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+class b2Draw;
+
+/// A rope system steps many ropes together. The vertices of all ropes are
+/// stored in one structure of arrays and the constraints are solved with a
+/// red-black (stretching) and three-color (bending) Gauss-Seidel ordering, so the
+/// constraints within a color sweep do not depend on each other. Ropes can be
+/// stepped in parallel because a rope only touches its own vertices. The worker
+/// threads are started by the first parallel Step and kept until the system is
+/// destroyed or a Step asks for a different thread count.
+class b2RopeSystem
+{
+public:
+	b2RopeSystem();
+	~b2RopeSystem();
+
+	/// Add a rope. The definition is the same as for b2Rope.
+	/// @return the rope index.
+	int32 AddRope(const b2RopeDef* def);
+
+	/// Remove all ropes.
+	void Clear();
+
+	/// Get the number of ropes.
+	int32 GetRopeCount() const { return m_ropeCount; }
+
+	/// Get the number of vertices of a rope.
+	int32 GetVertexCount(int32 rope) const;
+
+	/// Get a vertex position of a rope.
+	b2Vec2 GetVertex(int32 rope, int32 index) const;
+
+	/// Set the rest bending angle of a rope.
+	void SetAngle(int32 rope, float32 angle);
+
+	/// Step all ropes. Set threadCount above one to split the ropes over that
+	/// many threads, including the thread that calls Step.
+	void Step(float32 timeStep, int32 iterations, int32 threadCount = 1);
+
+	/// Step the ropes in [ropeBegin, ropeEnd). Disjoint ranges can be stepped
+	/// concurrently, for example from your own job system.
+	void StepRange(float32 timeStep, int32 iterations, int32 ropeBegin, int32 ropeEnd);
+
+	/// Draw all ropes.
+	void Draw(b2Draw* draw) const;
+
+private:
+
+	struct b2RopeRange
+	{
+		int32 offset;
+		int32 count;
+		b2Vec2 gravity;
+		float32 damping;
+	};
+
+	void Reserve(int32 vertexCapacity);
+	void SolveC2(int32 begin, int32 end);
+	void SolveC3(int32 begin, int32 end);
+
+	void StartThreads(int32 threadCount);
+	void StopThreads();
+	void Run(int32 thread, uint32 generation);
+
+	b2RopeRange* m_ropes;
+	int32 m_ropeCount;
+	int32 m_ropeCapacity;
+
+	int32 m_vertexCount;
+	int32 m_vertexCapacity;
+
+	// Per vertex.
+	float32* m_px;
+	float32* m_py;
+	float32* m_p0x;
+	float32* m_p0y;
+	float32* m_vx;
+	float32* m_vy;
+	float32* m_ims;
+
+	// Per segment (vertex i to i + 1). The weights include the stiffness and
+	// are zero for the last vertex of each rope.
+	float32* m_Ls;
+	float32* m_s1;
+	float32* m_s2;
+
+	// Per bend (vertices i, i + 1, i + 2). The stiffness is zero for the last
+	// two vertices of each rope.
+	float32* m_as;
+	float32* m_k3;
+
+	// Worker pool. Thread zero is the thread that calls Step. Each thread steps
+	// the ropes in [m_rangeBegins[t], m_rangeEnds[t]).
+	int32 m_threadCount;
+	std::thread* m_threads;
+	int32* m_rangeBegins;
+	int32* m_rangeEnds;
+
+	float32 m_timeStep;
+	int32 m_iterations;
+
+	std::mutex m_mutex;
+	std::condition_variable m_startCondition;
+	std::condition_variable m_doneCondition;
+	uint32 m_generation;
+	int32 m_activeCount;
+	bool m_quit;
+};
+
+#endif
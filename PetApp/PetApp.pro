@@ -26,6 +26,7 @@ SOURCES += \
     Box2D/Common/b2BlockAllocator.cpp \
     Box2D/Common/b2Draw.cpp \
     Box2D/Common/b2Math.cpp \
+    Box2D/Common/b2MathBatch.cpp \
     Box2D/Common/b2Settings.cpp \
     Box2D/Common/b2StackAllocator.cpp \
     Box2D/Common/b2Timer.cpp \
@@ -38,10 +39,12 @@ SOURCES += \
     Box2D/Dynamics/Contacts/b2EdgeAndPolygonContact.cpp \
     Box2D/Dynamics/Contacts/b2PolygonAndCircleContact.cpp \
     Box2D/Dynamics/Contacts/b2PolygonContact.cpp \
+    Box2D/Dynamics/Joints/b2ArticulationSolver.cpp \
     Box2D/Dynamics/Joints/b2DistanceJoint.cpp \
     Box2D/Dynamics/Joints/b2FrictionJoint.cpp \
     Box2D/Dynamics/Joints/b2GearJoint.cpp \
     Box2D/Dynamics/Joints/b2Joint.cpp \
+    Box2D/Dynamics/Joints/b2JointSolver.cpp \
     Box2D/Dynamics/Joints/b2MotorJoint.cpp \
     Box2D/Dynamics/Joints/b2MouseJoint.cpp \
     Box2D/Dynamics/Joints/b2PrismaticJoint.cpp \
@@ -54,9 +57,13 @@ SOURCES += \
     Box2D/Dynamics/b2ContactManager.cpp \
     Box2D/Dynamics/b2Fixture.cpp \
     Box2D/Dynamics/b2Island.cpp \
+    Box2D/Dynamics/b2StepThread.cpp \
     Box2D/Dynamics/b2World.cpp \
     Box2D/Dynamics/b2WorldCallbacks.cpp \
+    Box2D/Dynamics/b2WorldGroup.cpp \
+    Box2D/Dynamics/b2WorldStreamer.cpp \
     Box2D/Rope/b2Rope.cpp \
+    Box2D/Rope/b2RopeSystem.cpp \
     cat.cpp \
     dialog.cpp \
     dog.cpp \
@@ -83,6 +90,7 @@ HEADERS += \
     Box2D/Common/b2Draw.h \
     Box2D/Common/b2GrowableStack.h \
     Box2D/Common/b2Math.h \
+    Box2D/Common/b2MathBatch.h \
     Box2D/Common/b2Settings.h \
     Box2D/Common/b2StackAllocator.h \
     Box2D/Common/b2Timer.h \
@@ -95,10 +103,12 @@ HEADERS += \
     Box2D/Dynamics/Contacts/b2EdgeAndPolygonContact.h \
     Box2D/Dynamics/Contacts/b2PolygonAndCircleContact.h \
     Box2D/Dynamics/Contacts/b2PolygonContact.h \
+    Box2D/Dynamics/Joints/b2ArticulationSolver.h \
     Box2D/Dynamics/Joints/b2DistanceJoint.h \
     Box2D/Dynamics/Joints/b2FrictionJoint.h \
     Box2D/Dynamics/Joints/b2GearJoint.h \
     Box2D/Dynamics/Joints/b2Joint.h \
+    Box2D/Dynamics/Joints/b2JointSolver.h \
     Box2D/Dynamics/Joints/b2MotorJoint.h \
     Box2D/Dynamics/Joints/b2MouseJoint.h \
     Box2D/Dynamics/Joints/b2PrismaticJoint.h \
@@ -111,10 +121,14 @@ HEADERS += \
     Box2D/Dynamics/b2ContactManager.h \
     Box2D/Dynamics/b2Fixture.h \
     Box2D/Dynamics/b2Island.h \
+    Box2D/Dynamics/b2StepThread.h \
     Box2D/Dynamics/b2TimeStep.h \
     Box2D/Dynamics/b2World.h \
     Box2D/Dynamics/b2WorldCallbacks.h \
+    Box2D/Dynamics/b2WorldGroup.h \
+    Box2D/Dynamics/b2WorldStreamer.h \
     Box2D/Rope/b2Rope.h \
+    Box2D/Rope/b2RopeSystem.h \
     cat.h \
     dialog.h \
     dog.h \
@@ -25,8 +25,9 @@ MainModel::MainModel(string name, int age, double weight, string animal) : world
     connect(&gameTimer, &QTimer::timeout, this, &MainModel::updateGameTime);
     selectedAction = Default;
 
-    // Set up box2d
+    // Set up box2d, stepping on a worker thread so large worlds don't stall the GUI
     setBox2dWorld();
+    world.SetAsyncStepping(true);
     connect(&timer, &QTimer::timeout, this, &MainModel::updateBall);
 }
 
@@ -99,6 +100,8 @@ void MainModel::produceNewBall(int x, int y)
     if (!timer.isActive())
         timer.start(1000/60);
 
+    // Wait for the running step before changing the body
+    world.Fence();
     body->SetTransform(b2Vec2(x/ppm, y/ppm), 0);
 
     // Change to whatever force or impulse wanted
@@ -120,14 +123,15 @@ void MainModel::updateBall()
     int32 velocityIterations = 8;
     int32 positionIterations = 8;
 
-    // Instruct the world to perform a single step of simulation
-    world.Step(timeStep, velocityIterations, positionIterations);
+    // Start a single step of simulation on the physics thread
+    world.StepAsync(timeStep, velocityIterations, positionIterations);
 
-    // Emit the position and angle of the body
-    b2Vec2 position = body->GetPosition();
+    // Emit the position and angle of the body from the last completed step
+    const b2Transform& transform = world.GetStepTransform(body);
+    b2Vec2 position = transform.p;
     emit newBallPos(position.x * ppm, position.y * ppm);
 
-    float angle = body->GetAngle();
+    float angle = transform.q.GetAngle();
     emit newBallAngle(angle);
 }
 